@@ -0,0 +1,139 @@
+/*
+ * Microbenchmarks of the JPL quaternion helpers (jpl_quaternion.hpp):
+ * the fixed-size versions in double and float, against the dynamic-size versions they replaced.
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../jpl_quaternion.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	// As pose_prediction and rk4_integrator had them
+	namespace dynamic {
+
+		Eigen::Matrix<double, 3, 3> skew_x(const Eigen::Matrix<double, 3, 1> &w) {
+			Eigen::Matrix<double, 3, 3> w_x;
+			w_x << 0, -w(2), w(1),
+					w(2), 0, -w(0),
+					-w(1), w(0), 0;
+			return w_x;
+		}
+
+		Eigen::Matrix<double, 3, 3> quat_2_Rot(const Eigen::Matrix<double, 4, 1> &q) {
+			Eigen::Matrix<double, 3, 3> q_x = skew_x(q.block(0, 0, 3, 1));
+			Eigen::MatrixXd Rot = (2 * std::pow(q(3, 0), 2) - 1) * Eigen::MatrixXd::Identity(3, 3)
+								  - 2 * q(3, 0) * q_x +
+								  2 * q.block(0, 0, 3, 1) * (q.block(0, 0, 3, 1).transpose());
+			return Rot;
+		}
+
+		Eigen::Matrix<double, 4, 1> quat_multiply(const Eigen::Matrix<double, 4, 1> &q, const Eigen::Matrix<double, 4, 1> &p) {
+			Eigen::Matrix<double, 4, 1> q_t;
+			Eigen::Matrix<double, 4, 4> Qm;
+			Qm.block(0, 0, 3, 3) = q(3, 0) * Eigen::MatrixXd::Identity(3, 3) - skew_x(q.block(0, 0, 3, 1));
+			Qm.block(0, 3, 3, 1) = q.block(0, 0, 3, 1);
+			Qm.block(3, 0, 1, 3) = -q.block(0, 0, 3, 1).transpose();
+			Qm(3, 3) = q(3, 0);
+			q_t = Qm * p;
+			if (q_t(3, 0) < 0) {
+				q_t *= -1;
+			}
+			return q_t / q_t.norm();
+		}
+
+	}
+
+	constexpr std::size_t inputs = 1024;
+	constexpr int repetitions = 2000;
+
+	// Keep a result from being optimized out
+	template <typename T>
+	inline void escape(const T& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	template <typename T>
+	struct data {
+		std::vector<Eigen::Matrix<T, 4, 1>> q;
+		std::vector<Eigen::Matrix<T, 4, 1>> p;
+		std::vector<Eigen::Matrix<T, 3, 1>> w;
+	};
+
+	template <typename T>
+	data<T> make_data() {
+		std::mt19937 rng {0};
+		std::normal_distribution<double> noise {0., 1.};
+		data<T> d;
+		for (std::size_t i = 0; i < inputs; i++) {
+			d.q.push_back(Eigen::Vector4d{noise(rng), noise(rng), noise(rng), noise(rng)}.normalized().cast<T>());
+			d.p.push_back(Eigen::Vector4d{noise(rng), noise(rng), noise(rng), noise(rng)}.normalized().cast<T>());
+			d.w.push_back(Eigen::Vector3d{noise(rng), noise(rng), noise(rng)}.cast<T>());
+		}
+		return d;
+	}
+
+	template <typename Op>
+	double ns_per_op(Op op) {
+		const auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repetitions; r++) {
+			for (std::size_t i = 0; i < inputs; i++) {
+				escape(op(i));
+			}
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(stop - start).count() / double(repetitions * inputs);
+	}
+
+	void row(const char* name, double dynamic_ns, double double_ns, double float_ns) {
+		if (dynamic_ns > 0) {
+			std::printf("%-16s %12.2f %12.2f %12.2f\n", name, dynamic_ns, double_ns, float_ns);
+		} else {
+			std::printf("%-16s %12s %12.2f %12.2f\n", name, "-", double_ns, float_ns);
+		}
+	}
+
+}
+
+int main() {
+	const data<double> d = make_data<double>();
+	const data<float> f = make_data<float>();
+
+	std::printf("ns per call, over %zu inputs\n\n", inputs);
+	std::printf("%-16s %12s %12s %12s\n", "", "dynamic", "double", "float");
+	row("skew_x",
+		ns_per_op([&](std::size_t i) { return dynamic::skew_x(d.w[i]); }),
+		ns_per_op([&](std::size_t i) { return skew_x(d.w[i]); }),
+		ns_per_op([&](std::size_t i) { return skew_x(f.w[i]); }));
+	row("Omega",
+		0,
+		ns_per_op([&](std::size_t i) { return Omega(d.w[i]); }),
+		ns_per_op([&](std::size_t i) { return Omega(f.w[i]); }));
+	row("quatnorm",
+		0,
+		ns_per_op([&](std::size_t i) { return quatnorm(d.q[i] + d.p[i]); }),
+		ns_per_op([&](std::size_t i) { return quatnorm(f.q[i] + f.p[i]); }));
+	row("quat_2_Rot",
+		ns_per_op([&](std::size_t i) { return dynamic::quat_2_Rot(d.q[i]); }),
+		ns_per_op([&](std::size_t i) { return quat_2_Rot(d.q[i]); }),
+		ns_per_op([&](std::size_t i) { return quat_2_Rot(f.q[i]); }));
+	row("quat_multiply",
+		ns_per_op([&](std::size_t i) { return dynamic::quat_multiply(d.q[i], d.p[i]); }),
+		ns_per_op([&](std::size_t i) { return quat_multiply(d.q[i], d.p[i]); }),
+		ns_per_op([&](std::size_t i) { return quat_multiply(f.q[i], f.p[i]); }));
+	row("exp_so3",
+		0,
+		ns_per_op([&](std::size_t i) { return exp_so3(d.w[i]); }),
+		ns_per_op([&](std::size_t i) { return exp_so3(f.w[i]); }));
+	row("quat_exp",
+		0,
+		ns_per_op([&](std::size_t i) { return quat_exp(d.w[i]); }),
+		ns_per_op([&](std::size_t i) { return quat_exp(f.w[i]); }));
+	return 0;
+}
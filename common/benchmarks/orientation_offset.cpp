@@ -0,0 +1,110 @@
+/*
+ * Contention of the orientation offset (orientation_offset.hpp), which every pose query applies,
+ * with three render consumers (gldemo, timewarp_gl, debugview) querying at once on their own threads.
+ *
+ * - shared_mutex: what pose_prediction and pose_lookup had, a reader-writer lock around the offset
+ * - seqlock: orientation_offset
+ *
+ * Each is run without writes, and with a writer calling set_offset every millisecond
+ * (far more often than a recenter would).
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "../orientation_offset.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	constexpr int consumers = 3;
+	constexpr int queries = 2000000;
+
+	// As pose_prediction had it
+	class shared_mutex_offset {
+	public:
+		Eigen::Quaternionf apply(const Eigen::Quaternionf& orientation) const {
+			std::shared_lock lock {_m_mutex};
+			return orientation * _m_offset;
+		}
+
+		void set(const Eigen::Quaternionf& raw_o_times_offset) {
+			std::unique_lock lock {_m_mutex};
+			const Eigen::Quaternionf raw_o = raw_o_times_offset * _m_offset.inverse();
+			_m_offset = raw_o.inverse();
+		}
+
+	private:
+		Eigen::Quaternionf _m_offset {Eigen::Quaternionf::Identity()};
+		mutable std::shared_mutex _m_mutex;
+	};
+
+	// Keep a result from being optimized out
+	template <typename T>
+	inline void escape(const T& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	// Mean ns per query, over all consumers
+	template <typename Offset>
+	double ns_per_query(bool with_writer) {
+		Offset offset;
+		std::atomic<bool> start {false};
+		std::atomic<int> running {consumers};
+
+		std::thread writer;
+		if (with_writer) {
+			writer = std::thread{[&]() {
+				const Eigen::Quaternionf tilt {Eigen::AngleAxisf{0.01f, Eigen::Vector3f::UnitY()}};
+				while (running.load() > 0) {
+					offset.set(tilt);
+					std::this_thread::sleep_for(std::chrono::milliseconds{1});
+				}
+			}};
+		}
+
+		std::vector<double> ns(consumers);
+		std::vector<std::thread> threads;
+		for (int c = 0; c < consumers; c++) {
+			threads.emplace_back([&, c]() {
+				Eigen::Quaternionf orientation {Eigen::AngleAxisf{0.1f * float(c), Eigen::Vector3f::UnitZ()}};
+				while (!start.load()) { }
+				const auto begin = std::chrono::steady_clock::now();
+				for (int i = 0; i < queries; i++) {
+					escape(offset.apply(orientation));
+				}
+				const auto end = std::chrono::steady_clock::now();
+				ns[c] = std::chrono::duration<double, std::nano>(end - begin).count() / double(queries);
+				running--;
+			});
+		}
+		start = true;
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		if (writer.joinable()) {
+			writer.join();
+		}
+
+		double sum = 0;
+		for (double value : ns) {
+			sum += value;
+		}
+		return sum / double(consumers);
+	}
+
+}
+
+int main() {
+	std::printf("ns per query, %d consumers querying concurrently\n\n", consumers);
+	std::printf("%-16s %14s %14s\n", "", "no writes", "writes @1kHz");
+	std::printf("%-16s %14.2f %14.2f\n", "shared_mutex", ns_per_query<shared_mutex_offset>(false), ns_per_query<shared_mutex_offset>(true));
+	std::printf("%-16s %14.2f %14.2f\n", "seqlock", ns_per_query<orientation_offset>(false), ns_per_query<orientation_offset>(true));
+	return 0;
+}
@@ -23,8 +23,9 @@ DBG_FLAGS ?= -Og -g $(MONADO_FLAGS) -Wall -Wextra -Werror -rdynamic
 #> NDEBUG disables debugging output and logic
 OPT_FLAGS ?= -O3 -DNDEBUG $(MONADO_FLAGS) -Wall -Wextra -Werror
 
-CPP_FILES ?= $(shell find . -name '*.cpp' -not -name 'plugin.cpp' -not -name 'main.cpp' -not -path '*/tests/*')
+CPP_FILES ?= $(shell find . -name '*.cpp' -not -name 'plugin.cpp' -not -name 'main.cpp' -not -path '*/tests/*' -not -path '*/benchmarks/*')
 CPP_TEST_FILES ?= $(shell find tests/ -name '*.cpp' 2>/dev/null)
+CPP_BENCHMARK_FILES ?= $(shell find benchmarks/ -name '*.cpp' 2>/dev/null)
 HPP_FILES ?= $(shell find -L . -name '*.hpp')
 # I need -L to follow symlinks in common/
 LDFLAGS := -ggdb $(LDFLAGS)
@@ -79,10 +80,23 @@ tests/test.exe: $(CPP_TEST_FILES) $(CPP_FILES) $(HPP_FILES)
 	$(CPP_TEST_FILES) $(CPP_FILES) $(LDFLAGS)
 endif
 
+## Benchmarks: each benchmarks/*.cpp is a standalone program (with its own main), built optimized
+.PHONY: benchmarks/run
+ifeq ($(CPP_BENCHMARK_FILES),)
+benchmarks/run:
+else
+benchmarks/run: $(CPP_BENCHMARK_FILES:.cpp=.exe)
+	for benchmark in $^; do ./$$benchmark || exit 1; done
+
+benchmarks/%.exe: benchmarks/%.cpp $(CPP_FILES) $(HPP_FILES)
+	$(CXX) -std=$(STDCXX) $(CFLAGS) $(CPPFLAGS) $(OPT_FLAGS) \
+	-o $@ $< $(CPP_FILES) $(LDFLAGS)
+endif
+
 .PHONY: clean
 clean:
 	touch _target && \
-	$(RM) _target *.so *.exe *.o ./tests/test.exe
+	$(RM) _target *.so *.exe *.o ./tests/test.exe ./benchmarks/*.exe
 # if *.so and *.o do not exist, rm will still work, because it still receives an operand (target)
 
 .PHONY: deepclean
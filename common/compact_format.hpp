@@ -0,0 +1,272 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+
+#include "data_format.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Nanoseconds on the monotonic (`steady_clock`) time base.
+	 *
+	 * Unlike `time_type` (`system_clock`), this never jumps when the wall clock is adjusted,
+	 * and differences are plain integer subtractions.
+	 */
+	typedef std::int64_t mono_ns;
+
+	inline mono_ns mono_now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	inline double mono_to_seconds(mono_ns t) {
+		return double(t) / NANO_SEC;
+	}
+
+	inline mono_ns seconds_to_mono(double t) {
+		return mono_ns(std::llround(t * NANO_SEC));
+	}
+
+	/**
+	 * @brief Maps `time_type` (`system_clock`) to and from `mono_ns`.
+	 *
+	 * The offset between the clocks is sampled once, at construction, so conversions stay consistent
+	 * (and monotonic) even if the wall clock is adjusted later.
+	 * Each plugin library gets its own `clock_domain::process()`; they agree up to the jitter of sampling both clocks.
+	 */
+	class clock_domain {
+	public:
+		clock_domain()
+			: _m_system_minus_mono{
+				std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+				- mono_now()
+			}
+		{ }
+
+		static const clock_domain& process() {
+			static const clock_domain domain;
+			return domain;
+		}
+
+		mono_ns from_system(time_type t) const {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count() - _m_system_minus_mono;
+		}
+
+		time_type to_system(mono_ns t) const {
+			return time_type{std::chrono::duration_cast<time_type::duration>(std::chrono::nanoseconds{t + _m_system_minus_mono})};
+		}
+
+	private:
+		std::int64_t _m_system_minus_mono;
+	};
+
+	/*
+	 * Compact, trivially-copyable variants of the core events.
+	 *
+	 * - Every timestamp is `mono_ns`; dataset timestamps are kept as int64 nanoseconds too.
+	 * - Vectors and quaternions are float32 arrays (quaternions stored x, y, z, w, like Eigen),
+	 *   read and written through the Eigen::Map accessors.
+	 * - Each struct is aligned to (and padded to a multiple of) a 64-byte cache line.
+	 *   `version` is bumped whenever a layout changes, so recorded or shared-memory copies can be checked.
+	 *
+	 * These are plain structs, so publish them as `switchboard::event_wrapper<T>`.
+	 */
+
+	constexpr std::size_t cache_line_size = 64;
+
+	namespace compact_detail {
+		inline Eigen::Map<Eigen::Vector3f> vec(float* data) { return Eigen::Map<Eigen::Vector3f>{data}; }
+		inline Eigen::Map<const Eigen::Vector3f> vec(const float* data) { return Eigen::Map<const Eigen::Vector3f>{data}; }
+		inline Eigen::Map<Eigen::Quaternionf> quat(float* data) { return Eigen::Map<Eigen::Quaternionf>{data}; }
+		inline Eigen::Map<const Eigen::Quaternionf> quat(const float* data) { return Eigen::Map<const Eigen::Quaternionf>{data}; }
+
+		inline void store(float* dst, const Eigen::Vector3f& src) { vec(dst) = src; }
+		inline void store(float* dst, const Eigen::Quaternionf& src) { quat(dst) = src; }
+	}
+
+	// One IMU sample, and the sequence number of the stereo frame taken with it (if any).
+	// The images themselves stay on `stereo_frame`; they do not fit a cache line.
+	struct alignas(cache_line_size) imu_cam_compact {
+		static constexpr std::uint32_t current_version = 1;
+		static constexpr std::uint64_t no_frame = 0;
+
+		std::uint32_t version;
+		std::uint32_t reserved;
+		mono_ns time;
+		mono_ns dataset_time;
+		std::uint64_t frame_seq; // no_frame if this sample has no images
+		float angular_v[3];
+		float linear_a[3];
+
+		Eigen::Map<const Eigen::Vector3f> angular_v_vec() const { return compact_detail::vec(angular_v); }
+		Eigen::Map<const Eigen::Vector3f> linear_a_vec() const { return compact_detail::vec(linear_a); }
+		bool has_frame() const { return frame_seq != no_frame; }
+	};
+
+	// Output of the IMU integrator. Biases and the propagated state in float32;
+	// at the distances a headset covers, float position resolution is well below a micrometer per meter.
+	struct alignas(cache_line_size) imu_raw_compact {
+		static constexpr std::uint32_t current_version = 1;
+
+		std::uint32_t version;
+		std::uint32_t reserved;
+		mono_ns imu_time;
+		float w_hat[3];
+		float a_hat[3];
+		float w_hat2[3];
+		float a_hat2[3];
+		float pos[3];
+		float vel[3];
+		float quat[4];
+
+		Eigen::Map<const Eigen::Vector3f> w_hat_vec() const { return compact_detail::vec(w_hat); }
+		Eigen::Map<const Eigen::Vector3f> a_hat_vec() const { return compact_detail::vec(a_hat); }
+		Eigen::Map<const Eigen::Vector3f> w_hat2_vec() const { return compact_detail::vec(w_hat2); }
+		Eigen::Map<const Eigen::Vector3f> a_hat2_vec() const { return compact_detail::vec(a_hat2); }
+		Eigen::Map<const Eigen::Vector3f> pos_vec() const { return compact_detail::vec(pos); }
+		Eigen::Map<const Eigen::Vector3f> vel_vec() const { return compact_detail::vec(vel); }
+		Eigen::Map<const Eigen::Quaternionf> quat_q() const { return compact_detail::quat(quat); }
+	};
+
+	struct alignas(cache_line_size) pose_compact {
+		static constexpr std::uint32_t current_version = 1;
+
+		std::uint32_t version;
+		std::uint32_t reserved;
+		mono_ns sensor_time;
+		float position[3];
+		float orientation[4];
+
+		Eigen::Map<const Eigen::Vector3f> position_vec() const { return compact_detail::vec(position); }
+		Eigen::Map<const Eigen::Quaternionf> orientation_q() const { return compact_detail::quat(orientation); }
+	};
+
+	struct alignas(cache_line_size) fast_pose_compact {
+		static constexpr std::uint32_t current_version = 1;
+
+		std::uint32_t version;
+		std::uint32_t reserved;
+		mono_ns sensor_time;
+		mono_ns predict_computed_time;
+		mono_ns predict_target_time;
+		float position[3];
+		float orientation[4];
+
+		Eigen::Map<const Eigen::Vector3f> position_vec() const { return compact_detail::vec(position); }
+		Eigen::Map<const Eigen::Quaternionf> orientation_q() const { return compact_detail::quat(orientation); }
+	};
+
+	static_assert(std::is_trivially_copyable_v<imu_cam_compact> && std::is_standard_layout_v<imu_cam_compact>);
+	static_assert(std::is_trivially_copyable_v<imu_raw_compact> && std::is_standard_layout_v<imu_raw_compact>);
+	static_assert(std::is_trivially_copyable_v<pose_compact> && std::is_standard_layout_v<pose_compact>);
+	static_assert(std::is_trivially_copyable_v<fast_pose_compact> && std::is_standard_layout_v<fast_pose_compact>);
+	static_assert(sizeof(imu_cam_compact) == cache_line_size);
+	static_assert(sizeof(imu_raw_compact) == 2 * cache_line_size);
+	static_assert(sizeof(pose_compact) == cache_line_size);
+	static_assert(sizeof(fast_pose_compact) == cache_line_size);
+
+	/* Conversions to and from the full events */
+
+	inline imu_cam_compact to_compact(const imu_sample& sample, std::uint64_t frame_seq = imu_cam_compact::no_frame,
+									  const clock_domain& clock = clock_domain::process()) {
+		imu_cam_compact out {};
+		out.version = imu_cam_compact::current_version;
+		out.time = clock.from_system(sample.time);
+		out.dataset_time = mono_ns(sample.dataset_time);
+		out.frame_seq = frame_seq;
+		compact_detail::store(out.angular_v, sample.angular_v);
+		compact_detail::store(out.linear_a, sample.linear_a);
+		return out;
+	}
+
+	inline imu_sample from_compact(const imu_cam_compact& in, const clock_domain& clock = clock_domain::process()) {
+		return imu_sample {
+			clock.to_system(in.time),
+			in.angular_v_vec(),
+			in.linear_a_vec(),
+			ullong(in.dataset_time),
+		};
+	}
+
+	// Consecutive IMU samples in time order, published on the "imu_batch" topic.
+	// Compact, so an integrator walks one cache line per sample.
+	// `frame_seq` is left at `no_frame`; match frames to samples by `dataset_time`.
+	struct imu_batch_type : public switchboard::event {
+		std::vector<imu_cam_compact> samples;
+		imu_batch_type(std::vector<imu_cam_compact> samples_)
+			: samples{std::move(samples_)}
+		{ }
+	};
+
+	inline imu_raw_compact to_compact(const imu_raw_type& raw, const clock_domain& clock = clock_domain::process()) {
+		imu_raw_compact out {};
+		out.version = imu_raw_compact::current_version;
+		out.imu_time = clock.from_system(raw.imu_time);
+		compact_detail::store(out.w_hat, raw.w_hat.cast<float>());
+		compact_detail::store(out.a_hat, raw.a_hat.cast<float>());
+		compact_detail::store(out.w_hat2, raw.w_hat2.cast<float>());
+		compact_detail::store(out.a_hat2, raw.a_hat2.cast<float>());
+		compact_detail::store(out.pos, raw.pos.cast<float>());
+		compact_detail::store(out.vel, raw.vel.cast<float>());
+		compact_detail::store(out.quat, raw.quat.cast<float>());
+		return out;
+	}
+
+	inline imu_raw_type from_compact(const imu_raw_compact& in, const clock_domain& clock = clock_domain::process()) {
+		return imu_raw_type {
+			in.w_hat_vec().cast<double>(),
+			in.a_hat_vec().cast<double>(),
+			in.w_hat2_vec().cast<double>(),
+			in.a_hat2_vec().cast<double>(),
+			in.pos_vec().cast<double>(),
+			in.vel_vec().cast<double>(),
+			in.quat_q().cast<double>(),
+			clock.to_system(in.imu_time),
+		};
+	}
+
+	inline pose_compact to_compact(const pose_type& pose, const clock_domain& clock = clock_domain::process()) {
+		pose_compact out {};
+		out.version = pose_compact::current_version;
+		out.sensor_time = clock.from_system(pose.sensor_time);
+		compact_detail::store(out.position, pose.position);
+		compact_detail::store(out.orientation, pose.orientation);
+		return out;
+	}
+
+	inline pose_type from_compact(const pose_compact& in, const clock_domain& clock = clock_domain::process()) {
+		return pose_type {
+			clock.to_system(in.sensor_time),
+			in.position_vec(),
+			in.orientation_q(),
+		};
+	}
+
+	inline fast_pose_compact to_compact(const fast_pose_type& fast_pose, const clock_domain& clock = clock_domain::process()) {
+		fast_pose_compact out {};
+		out.version = fast_pose_compact::current_version;
+		out.sensor_time = clock.from_system(fast_pose.pose.sensor_time);
+		out.predict_computed_time = clock.from_system(fast_pose.predict_computed_time);
+		out.predict_target_time = clock.from_system(fast_pose.predict_target_time);
+		compact_detail::store(out.position, fast_pose.pose.position);
+		compact_detail::store(out.orientation, fast_pose.pose.orientation);
+		return out;
+	}
+
+	inline fast_pose_type from_compact(const fast_pose_compact& in, const clock_domain& clock = clock_domain::process()) {
+		return fast_pose_type {
+			pose_type {
+				clock.to_system(in.sensor_time),
+				in.position_vec(),
+				in.orientation_q(),
+			},
+			clock.to_system(in.predict_computed_time),
+			clock.to_system(in.predict_target_time),
+		};
+	}
+
+}
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <chrono>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 #include <boost/optional.hpp>
 
 #include <opencv2/core/mat.hpp>
@@ -48,21 +51,193 @@ namespace ILLIXR {
 		{ }
 	};
 
-    class rgb_depth_type : public switchboard::event {
-        std::optional<cv::Mat> rgb;
-        std::optional<cv::Mat> depth;
-        [[maybe_unused]] ullong timestamp;
-	public:
+	// A single IMU sample, published on the "imu" topic.
+	// time is the current UNIX time where dataset_time is the sensor's (or dataset's) timestamp
+	struct imu_sample : public switchboard::event {
+		time_type time;
+		Eigen::Vector3f angular_v;
+		Eigen::Vector3f linear_a;
+		ullong dataset_time;
+		imu_sample(time_type time_,
+				   Eigen::Vector3f angular_v_,
+				   Eigen::Vector3f linear_a_,
+				   ullong dataset_time_)
+			: time{time_}
+			, angular_v{angular_v_}
+			, linear_a{linear_a_}
+			, dataset_time{dataset_time_}
+		{ }
+	};
+
+	// imu_batch_type (the "imu_batch" topic) is in compact_format.hpp
+
+	// A stereo pair, published on the "stereo_frame" topic
+	struct stereo_frame_type : public switchboard::event {
+		time_type time;
+		cv::Mat img0;
+		cv::Mat img1;
+		ullong dataset_time;
+		stereo_frame_type(time_type time_,
+						  cv::Mat img0_,
+						  cv::Mat img1_,
+						  ullong dataset_time_)
+			: time{time_}
+			, img0{img0_}
+			, img1{img1_}
+			, dataset_time{dataset_time_}
+		{ }
+	};
+
+	// What an image plane holds, which also fixes its cv::Mat type
+	enum class image_plane {
+		gray,	// CV_8UC1 tracking camera
+		color,	// CV_8UC3 or CV_8UC4
+		depth,	// CV_16UC1 or CV_32FC1, in the sensor's units (see camera_image::depth_scale)
+	};
+
+	// One camera's image within a frame set.
+	// camera_id names the camera (and its topic, see camera_topic()); calibration_id selects its
+	// intrinsics/extrinsics, so that cameras can be swapped without renaming topics.
+	// Cameras in a rig are not necessarily triggered together, so each image has its own timestamps.
+	struct camera_image {
+		std::string camera_id;
+		std::string calibration_id;
+		image_plane plane;
+		time_type time;
+		ullong dataset_time;
+		cv::Mat image;
+		// Depth planes only: meters per unit of image (0 or NaN pixels have no depth)
+		float depth_scale = 0.f;
+	};
+
+	// Every image captured together by a (multi-)camera rig, published on the "frame_set" topic.
+	// Each image is also published on its own on camera_topic(camera_id), for consumers which only need some cameras.
+	struct frame_set_type : public switchboard::event {
+		time_type time;
+		ullong dataset_time;
+		std::vector<camera_image> images;
+		frame_set_type(time_type time_,
+					   ullong dataset_time_,
+					   std::vector<camera_image> images_)
+			: time{time_}
+			, dataset_time{dataset_time_}
+			, images{std::move(images_)}
+		{ }
+
+		// The image from camera_id, or nullptr if this set does not have one
+		const camera_image* find(const std::string& camera_id) const {
+			for (const camera_image& image : images) {
+				if (image.camera_id == camera_id) {
+					return &image;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	// A single camera's image, published on camera_topic(camera_id)
+	struct camera_frame_type : public switchboard::event {
+		camera_image frame;
+		camera_frame_type(camera_image frame_)
+			: frame{std::move(frame_)}
+		{ }
+	};
+
+	inline std::string camera_topic(const std::string& camera_id) {
+		return "camera/" + camera_id;
+	}
+
+	// Acknowledges that a consumer has finished processing the imu_cam sample
+	// with the given dataset_time. offline_imu_cam waits on these in lockstep mode.
+	// Consumers also send one with dataset_time 0 from start(), so offline_imu_cam knows who acknowledges.
+	struct imu_cam_ack : public switchboard::event {
+		plugin_id_t plugin_id;
+		ullong dataset_time;
+		imu_cam_ack(plugin_id_t plugin_id_, ullong dataset_time_)
+			: plugin_id{plugin_id_}
+			, dataset_time{dataset_time_}
+		{ }
+	};
+
+	// Stereo images after the preprocessing stage, shared read-only by every consumer.
+	// pyramid0/pyramid1 hold the Gaussian pyramids; level 0 is the full-resolution image.
+	// rectified is false if the images did not match the calibration and were passed through.
+	struct preprocessed_stereo_type : public switchboard::event {
+		time_type time;
+		ullong dataset_time;
+		std::vector<cv::Mat> pyramid0;
+		std::vector<cv::Mat> pyramid1;
+		bool rectified;
+		bool equalized;
+		preprocessed_stereo_type(time_type time_,
+								 ullong dataset_time_,
+								 std::vector<cv::Mat> pyramid0_,
+								 std::vector<cv::Mat> pyramid1_,
+								 bool rectified_,
+								 bool equalized_)
+			: time{time_}
+			, dataset_time{dataset_time_}
+			, pyramid0{std::move(pyramid0_)}
+			, pyramid1{std::move(pyramid1_)}
+			, rectified{rectified_}
+			, equalized{equalized_}
+		{ }
+	};
+
+	// Pinhole intrinsics of a depth image, in pixels
+	struct depth_intrinsics {
+		float fx;
+		float fy;
+		float cx;
+		float cy;
+	};
+
+	// The same images are also published as the "rgb" and "depth" planes of frame_set.
+	// depth is in the sensor's own units (CV_16UC1 or CV_32FC1); multiply by depth_scale for meters.
+	// 0 (or NaN) means no depth at that pixel.
+	struct rgb_depth_type : public switchboard::event {
+		std::optional<cv::Mat> rgb;
+		std::optional<cv::Mat> depth;
+		ullong timestamp;
+		float depth_scale;
+		depth_intrinsics intrinsics;
 		rgb_depth_type(
 					   std::optional<cv::Mat> _rgb,
 					   std::optional<cv::Mat> _depth,
-					   ullong _timestamp
+					   ullong _timestamp,
+					   float _depth_scale,
+					   depth_intrinsics _intrinsics
 					   )
 			: rgb{_rgb}
 			, depth{_depth}
 			, timestamp{_timestamp}
+			, depth_scale{_depth_scale}
+			, intrinsics{_intrinsics}
 		{ }
-    };
+	};
+
+	// One point (x, y, z in meters, in the depth camera's frame) per depth pixel, as a CV_32FC3 image.
+	// Pixels without depth are NaN.
+	struct organized_cloud_type : public switchboard::event {
+		ullong timestamp;
+		cv::Mat points;
+		organized_cloud_type(ullong timestamp_, cv::Mat points_)
+			: timestamp{timestamp_}
+			, points{std::move(points_)}
+		{ }
+	};
+
+	// The centroid of the points in each occupied voxel (meters, in the depth camera's frame)
+	struct voxel_cloud_type : public switchboard::event {
+		ullong timestamp;
+		float voxel_size;
+		std::vector<Eigen::Vector3f> points;
+		voxel_cloud_type(ullong timestamp_, float voxel_size_, std::vector<Eigen::Vector3f> points_)
+			: timestamp{timestamp_}
+			, voxel_size{voxel_size_}
+			, points{std::move(points_)}
+		{ }
+	};
 
 	// Values needed to initialize the IMU integrator
 	typedef struct {
@@ -159,6 +334,36 @@ namespace ILLIXR {
 		time_type predict_target_time; // Time that prediction targeted.
 	} fast_pose_type;
 
+	// When a frame reached the display (timewarp's swap), with the pose it was warped to
+	// and the vsync estimate that pose was meant for
+	struct mtp_sample : public switchboard::event {
+		time_type vsync_estimate;
+		time_type display_time;
+		fast_pose_type pose;
+		mtp_sample(time_type vsync_estimate_,
+				   time_type display_time_,
+				   fast_pose_type pose_)
+			: vsync_estimate{vsync_estimate_}
+			, display_time{display_time_}
+			, pose{pose_}
+		{ }
+	};
+
+	// A fast pose published by pose_prediction's streaming thread, with its derivatives
+	// (in the same frame as the pose; angular velocity in the body frame, rad/s)
+	struct pose_stream_type : public switchboard::event {
+		fast_pose_type fast_pose;
+		Eigen::Vector3f linear_velocity;
+		Eigen::Vector3f angular_velocity;
+		pose_stream_type(fast_pose_type fast_pose_,
+						 Eigen::Vector3f linear_velocity_,
+						 Eigen::Vector3f angular_velocity_)
+			: fast_pose{fast_pose_}
+			, linear_velocity{linear_velocity_}
+			, angular_velocity{angular_velocity_}
+		{ }
+	};
+
 	// Using arrays as a swapchain
 	// Array of left eyes, array of right eyes
 	// This more closely matches the format used by Monado
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "phonebook.hpp"
+#include "data_format.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief An immutable stream of readings, sorted by (dataset) timestamp.
+	 *
+	 * Iterators double as cursors: plugins keep one per stream and advance it as they replay.
+	 */
+	template <typename T>
+	class timed_stream {
+	public:
+		struct entry {
+			ullong time;
+			T value;
+		};
+		using const_iterator = typename std::vector<entry>::const_iterator;
+
+		timed_stream() { }
+
+		/// @param entries must already be sorted by time.
+		timed_stream(std::vector<entry>&& entries)
+			: _m_entries{std::move(entries)}
+		{ }
+
+		const_iterator begin() const { return _m_entries.cbegin(); }
+		const_iterator end() const { return _m_entries.cend(); }
+		std::size_t size() const { return _m_entries.size(); }
+		bool empty() const { return _m_entries.empty(); }
+		const entry& front() const { return _m_entries.front(); }
+		const entry& back() const { return _m_entries.back(); }
+
+		/// First entry at or after `time`.
+		const_iterator lower_bound(ullong time) const {
+			return std::lower_bound(begin(), end(), time, [](const entry& e, ullong t) { return e.time < t; });
+		}
+
+		/// First entry strictly after `time`.
+		const_iterator upper_bound(ullong time) const {
+			return std::upper_bound(begin(), end(), time, [](ullong t, const entry& e) { return t < e.time; });
+		}
+
+		/// The entry at exactly `time`, or end().
+		const_iterator find(ullong time) const {
+			const_iterator it = lower_bound(time);
+			return (it != end() && it->time == time) ? it : end();
+		}
+
+	private:
+		std::vector<entry> _m_entries;
+	};
+
+	/**
+	 * @brief Offline sensor data (EuRoC layout), loaded once and shared by every offline plugin.
+	 *
+	 * A dataset holds one or more sequences (see `ILLIXR_DATA_SEQUENCES`); plugins which only know about a single
+	 * sequence use sequence 0. Streams may be loaded lazily, so the first access to a stream can block.
+	 */
+	class dataset : public phonebook::service {
+	public:
+		struct imu_reading {
+			Eigen::Vector3d angular_v;
+			Eigen::Vector3d linear_a;
+		};
+
+		virtual std::size_t num_sequences() const = 0;
+		/// The directory the sequence was loaded from.
+		virtual const std::string& path(std::size_t sequence) const = 0;
+		virtual const timed_stream<imu_reading>& imu0(std::size_t sequence) const = 0;
+		/// Paths of the images (not the images themselves)
+		virtual const timed_stream<std::string>& cam0(std::size_t sequence) const = 0;
+		virtual const timed_stream<std::string>& cam1(std::size_t sequence) const = 0;
+		/// Ground-truth poses; `sensor_time` is unset.
+		virtual const timed_stream<pose_type>& ground_truth(std::size_t sequence) const = 0;
+		virtual ~dataset() { }
+	};
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "phonebook.hpp"
+#include "global_module_defs.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Recycled, cache-line-aligned pixel buffers for camera frames, shared by every sensor plugin.
+	 *
+	 * Frames are ordinary `cv::Mat`s, so OpenCV's reference count decides when a buffer is free:
+	 * once the last `cv::Mat` (in any event, cache, or consumer) lets go, the buffer returns to the pool
+	 * instead of the heap. Producers should write each image exactly once, straight into an `acquire()`d
+	 * buffer (or pass an `empty()` Mat as the output of an OpenCV call, which then allocates from the pool).
+	 *
+	 * Vendor frames which are already refcounted can be published zero-copy with `wrap()`;
+	 * the vendor's handle is kept alive until the last `cv::Mat` is released.
+	 *
+	 * At most `ILLIXR_FRAME_POOL_MB` (default 64) megabytes of idle buffers are kept.
+	 *
+	 * Registered by the runtime. Buffers may outlive the service; they are freed when released.
+	 * A `cv::Mat` keeps pointing at the pool's allocator even once released, so the allocator (a few bytes)
+	 * is never freed; after the pool is gone, it hands new buffers to OpenCV's default allocator instead.
+	 */
+	class frame_pool : public phonebook::service {
+	public:
+		frame_pool()
+			: frame_pool{std::stoul(ILLIXR::getenv_or("ILLIXR_FRAME_POOL_MB", "64")) * 1024 * 1024}
+		{ }
+
+		frame_pool(std::size_t max_idle_bytes)
+			: _m_allocator{new allocator{max_idle_bytes}}
+		{ }
+
+		frame_pool(const frame_pool&) = delete;
+		frame_pool& operator=(const frame_pool&) = delete;
+
+		~frame_pool() override {
+			_m_allocator->close();
+		}
+
+		/// An empty `cv::Mat` whose storage, once created, comes from the pool.
+		cv::Mat empty() const {
+			cv::Mat mat;
+			mat.allocator = _m_allocator;
+			return mat;
+		}
+
+		/// A pooled buffer of the given shape. Its contents are unspecified.
+		cv::Mat acquire(int rows, int cols, int type) const {
+			cv::Mat mat = empty();
+			mat.create(rows, cols, type);
+			return mat;
+		}
+
+		/**
+		 * @brief Publish memory owned by someone else without copying it.
+		 *
+		 * @param step Bytes per row, or 0 for tightly packed rows.
+		 * @param owner Keeps `data` valid; it is destroyed with the last `cv::Mat` referencing `data`.
+		 */
+		cv::Mat wrap(int rows, int cols, int type, void* data, std::size_t step, std::shared_ptr<const void> owner) const {
+			cv::Mat mat {rows, cols, type, data, step};
+			cv::UMatData* u = _m_allocator->track(static_cast<cv::uchar*>(data), std::size_t(rows) * mat.step);
+			u->userdata = new std::shared_ptr<const void>{std::move(owner)};
+			u->refcount = 1;
+			mat.u = u;
+			mat.allocator = _m_allocator;
+			return mat;
+		}
+
+		/// Number of buffers which had to be allocated from the heap.
+		std::size_t fresh_allocations() const { return _m_allocator->fresh_allocations(); }
+		/// Number of buffers which were recycled.
+		std::size_t reuses() const { return _m_allocator->reuses(); }
+
+	private:
+		/**
+		 * OpenCV calls back into this when a Mat is created or its last reference is released.
+		 * Once the pool is closed, it stops pooling: buffers that come back are freed, and new ones come from
+		 * OpenCV's default allocator (whose UMatData then routes their release there).
+		 */
+		class allocator : public cv::MatAllocator {
+		public:
+			static constexpr std::size_t alignment = 64;
+
+			allocator(std::size_t max_idle_bytes)
+				: _m_max_idle_bytes{max_idle_bytes}
+			{ }
+
+			cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, std::size_t* step,
+								   int flags, cv::UMatUsageFlags usageFlags) const override {
+				if (closed()) {
+					return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+				}
+
+				// Same layout as OpenCV's default allocator: tightly packed unless the caller gave steps for its own data.
+				std::size_t total = CV_ELEM_SIZE(type);
+				for (int i = dims - 1; i >= 0; i--) {
+					if (step) {
+						if (data0 && step[i] != CV_AUTOSTEP) {
+							total = step[i];
+						} else {
+							step[i] = total;
+						}
+					}
+					total *= sizes[i];
+				}
+
+				if (data0) {
+					return track(static_cast<cv::uchar*>(data0), total);
+				}
+				cv::UMatData* u = track(take(total), total);
+				u->flags &= ~cv::UMatData::USER_ALLOCATED;
+				return u;
+			}
+
+			bool allocate(cv::UMatData* u, int /* accessflags */, cv::UMatUsageFlags /* usageFlags */) const override {
+				return u != nullptr;
+			}
+
+			void deallocate(cv::UMatData* u) const override {
+				if (u == nullptr) {
+					return;
+				}
+				if (u->userdata) {
+					delete static_cast<std::shared_ptr<const void>*>(u->userdata);
+				}
+
+				{
+					const std::lock_guard<std::mutex> lock{_m_mutex};
+					if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+						give_back_locked(u->origdata, u->size);
+					}
+				}
+				delete u;
+			}
+
+			/// A UMatData for `data`, marked as not ours to free.
+			cv::UMatData* track(cv::uchar* data, std::size_t size) const {
+				cv::UMatData* u = new cv::UMatData{this};
+				u->data = u->origdata = data;
+				u->size = size;
+				u->flags |= cv::UMatData::USER_ALLOCATED;
+				return u;
+			}
+
+			/// Frees the idle buffers, and stops pooling. The allocator stays alive (see frame_pool).
+			void close() {
+				{
+					const std::lock_guard<std::mutex> lock{_m_mutex};
+					_m_closed = true;
+					release_idle_locked();
+				}
+				retire(this);
+			}
+
+			bool closed() const {
+				const std::lock_guard<std::mutex> lock{_m_mutex};
+				return _m_closed;
+			}
+
+			std::size_t fresh_allocations() const {
+				const std::lock_guard<std::mutex> lock{_m_mutex};
+				return _m_fresh_allocations;
+			}
+
+			std::size_t reuses() const {
+				const std::lock_guard<std::mutex> lock{_m_mutex};
+				return _m_reuses;
+			}
+
+		private:
+			// Closed allocators stay reachable from here, so leak checkers do not report them
+			static void retire(allocator* closed) {
+				static std::mutex mutex;
+				static std::vector<allocator*>* const retired = new std::vector<allocator*>;
+				const std::lock_guard<std::mutex> lock{mutex};
+				retired->push_back(closed);
+			}
+
+			static std::size_t round_up(std::size_t size) {
+				return (size + alignment - 1) / alignment * alignment;
+			}
+
+			cv::uchar* take(std::size_t size) const {
+				const std::size_t capacity = round_up(size);
+				{
+					const std::lock_guard<std::mutex> lock{_m_mutex};
+					auto found = _m_idle.find(capacity);
+					if (found != _m_idle.end() && !found->second.empty()) {
+						cv::uchar* buffer = found->second.back();
+						found->second.pop_back();
+						_m_idle_bytes -= capacity;
+						++_m_reuses;
+						return buffer;
+					}
+					++_m_fresh_allocations;
+				}
+				void* buffer = std::aligned_alloc(alignment, capacity);
+				if (buffer == nullptr) {
+					throw std::bad_alloc{};
+				}
+				return static_cast<cv::uchar*>(buffer);
+			}
+
+			void give_back_locked(cv::uchar* buffer, std::size_t size) const {
+				const std::size_t capacity = round_up(size);
+				if (_m_closed || _m_idle_bytes + capacity > _m_max_idle_bytes) {
+					std::free(buffer);
+					return;
+				}
+				_m_idle[capacity].push_back(buffer);
+				_m_idle_bytes += capacity;
+			}
+
+			void release_idle_locked() const {
+				for (auto& bucket : _m_idle) {
+					for (cv::uchar* buffer : bucket.second) {
+						std::free(buffer);
+					}
+				}
+				_m_idle.clear();
+				_m_idle_bytes = 0;
+			}
+
+			const std::size_t _m_max_idle_bytes;
+			mutable std::mutex _m_mutex;
+			// Idle buffers, bucketed by their (rounded-up) capacity
+			mutable std::unordered_map<std::size_t, std::vector<cv::uchar*>> _m_idle;
+			mutable std::size_t _m_idle_bytes {0};
+			mutable std::size_t _m_fresh_allocations {0};
+			mutable std::size_t _m_reuses {0};
+			bool _m_closed {false};
+		};
+
+		allocator* const _m_allocator;
+	};
+
+}
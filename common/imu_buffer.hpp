@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+
+#include "global_module_defs.hpp"
+
+namespace ILLIXR {
+
+	// One IMU measurement, as the integrators consume it
+	struct imu_reading {
+		double timestamp; // seconds
+		Eigen::Vector3d wm;
+		Eigen::Vector3d am;
+	};
+
+	// Linearly interpolate (or extrapolate) between two readings (modeled after OpenVINS)
+	inline imu_reading interpolate_imu(const imu_reading& imu_1, const imu_reading& imu_2, double timestamp) {
+		imu_reading data;
+		data.timestamp = timestamp;
+
+		const double lambda = (timestamp - imu_1.timestamp) / (imu_2.timestamp - imu_1.timestamp);
+		data.am = (1 - lambda) * imu_1.am + lambda * imu_2.am;
+		data.wm = (1 - lambda) * imu_1.wm + lambda * imu_2.wm;
+
+		return data;
+	}
+
+	/*
+	 * What one step of the OpenVINS window selection does with the consecutive readings `current` and `next`:
+	 * - window_begin: time_begin falls between them; interpolate `current` forward to time_begin.
+	 * - window_inside: `current` is within [time_begin, time_end]; take it as-is.
+	 * - window_end: `next` is past time_end; interpolate to time_end, and stop.
+	 * - window_skip: both are before the window.
+	 */
+	enum class window_step { skip, begin, inside, end };
+
+	inline window_step classify_window_step(const imu_reading& current, const imu_reading& next, double time_begin, double time_end) {
+		if (next.timestamp > time_begin && current.timestamp < time_begin) {
+			return window_step::begin;
+		}
+		if (current.timestamp >= time_begin && next.timestamp <= time_end) {
+			return window_step::inside;
+		}
+		if (next.timestamp > time_end) {
+			return window_step::end;
+		}
+		return window_step::skip;
+	}
+
+	// Readings this close together are collapsed; a zero dt would give an infinite noise covariance
+	constexpr double imu_min_dt = 1e-12;
+
+	/**
+	 * @brief Fixed-capacity ring buffer of IMU readings, ordered by timestamp.
+	 *
+	 * Expiring old readings and finding the integration window are binary searches,
+	 * and the window is extracted into a scratch buffer that is reused across calls,
+	 * so the per-sample path does no allocation.
+	 *
+	 * When full, the oldest reading is overwritten.
+	 * Capacity is `ILLIXR_IMU_BUFFER_CAPACITY` (default 4096, over 5 s at 800 Hz).
+	 */
+	class imu_buffer {
+	public:
+		imu_buffer()
+			: imu_buffer{std::stoul(ILLIXR::getenv_or("ILLIXR_IMU_BUFFER_CAPACITY", "4096"))}
+		{ }
+
+		explicit imu_buffer(std::size_t capacity)
+			: _m_readings(std::max<std::size_t>(2, capacity))
+		{
+			// A window holds at most every reading plus the two interpolated ends
+			_m_window.reserve(_m_readings.size() + 2);
+		}
+
+		/// Append a reading. Readings older than the newest one are out of order and dropped.
+		bool push(const imu_reading& reading) {
+			if (_m_size > 0 && reading.timestamp < back().timestamp) {
+				return false;
+			}
+			if (_m_size == _m_readings.size()) {
+				pop_front(1);
+			}
+			_m_readings[physical(_m_size)] = reading;
+			++_m_size;
+			return true;
+		}
+
+		/// Drop every reading older than @p cutoff.
+		void expire_before(double cutoff) {
+			pop_front(lower_bound(cutoff));
+		}
+
+		std::size_t size() const { return _m_size; }
+		bool empty() const { return _m_size == 0; }
+		std::size_t capacity() const { return _m_readings.size(); }
+
+		const imu_reading& operator[](std::size_t i) const { return _m_readings[physical(i)]; }
+		const imu_reading& front() const { return (*this)[0]; }
+		const imu_reading& back() const { return (*this)[_m_size - 1]; }
+
+		/// Readings are numbered in the order they were pushed; this is the number of the front one.
+		std::size_t front_seq() const { return _m_front_seq; }
+
+		/**
+		 * @brief Index of the first reading the window [@p time_begin, @p time_end] can start at.
+		 *
+		 * Readings wholly before time_begin contribute nothing, so they are skipped without looking.
+		 * (If time_end < time_begin, the window is cut off at time_end instead.)
+		 */
+		std::size_t window_start(double time_begin, double time_end) const {
+			const std::size_t after_begin = upper_bound(time_begin);
+			const std::size_t after_end = upper_bound(time_end);
+			const std::size_t first = std::min(lower_bound(time_begin), after_begin > 0 ? after_begin - 1 : 0);
+			return std::min(first, after_end > 0 ? after_end - 1 : 0);
+		}
+
+		/**
+		 * @brief The readings to propagate over [@p time_begin, @p time_end], selected like OpenVINS does.
+		 *
+		 * The first reading is interpolated to @p time_begin and the last to @p time_end,
+		 * and readings less than `imu_min_dt` apart are collapsed.
+		 *
+		 * The result is only valid until the next call.
+		 */
+		const std::vector<imu_reading>& select(double time_begin, double time_end) {
+			_m_window.clear();
+			if (_m_size < 2) {
+				return _m_window;
+			}
+
+			for (std::size_t i = window_start(time_begin, time_end); i + 1 < _m_size; i++) {
+				const imu_reading& current = (*this)[i];
+				const imu_reading& next = (*this)[i + 1];
+				const window_step step = classify_window_step(current, next, time_begin, time_end);
+				if (step == window_step::begin) {
+					_m_window.push_back(interpolate_imu(current, next, time_begin));
+				} else if (step == window_step::inside) {
+					_m_window.push_back(current);
+				} else if (step == window_step::end) {
+					_m_window.push_back(interpolate_imu(current, next, time_end));
+					break;
+				}
+			}
+
+			// Drop each reading which is (nearly) simultaneous with the next one, in place
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < _m_window.size(); i++) {
+				const bool last = i + 1 == _m_window.size();
+				if (last || std::abs(_m_window[i + 1].timestamp - _m_window[i].timestamp) >= imu_min_dt) {
+					_m_window[kept++] = _m_window[i];
+				}
+			}
+			_m_window.resize(kept);
+
+			return _m_window;
+		}
+
+	private:
+		std::size_t physical(std::size_t i) const {
+			const std::size_t index = _m_head + i;
+			return index < _m_readings.size() ? index : index - _m_readings.size();
+		}
+
+		void pop_front(std::size_t count) {
+			_m_head = physical(count);
+			_m_size -= count;
+			_m_front_seq += count;
+		}
+
+		/// Index of the first reading at or after @p t
+		std::size_t lower_bound(double t) const {
+			return partition([t](const imu_reading& reading) { return reading.timestamp < t; });
+		}
+
+		/// Index of the first reading after @p t
+		std::size_t upper_bound(double t) const {
+			return partition([t](const imu_reading& reading) { return reading.timestamp <= t; });
+		}
+
+		/// Index of the first reading for which @p before is false
+		template <typename Predicate>
+		std::size_t partition(Predicate before) const {
+			std::size_t low = 0;
+			std::size_t high = _m_size;
+			while (low < high) {
+				const std::size_t middle = low + (high - low) / 2;
+				if (before((*this)[middle])) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+			return low;
+		}
+
+		std::vector<imu_reading> _m_readings;
+		std::size_t _m_head {0};
+		std::size_t _m_size {0};
+		std::size_t _m_front_seq {0};
+		std::vector<imu_reading> _m_window;
+	};
+
+	/**
+	 * @brief Follows the window [time_begin, time_end] of an `imu_buffer` as time_end advances, one reading at a time.
+	 *
+	 * The window is the one `imu_buffer::select` returns, split into steps (pairs of consecutive readings).
+	 * Committed steps can no longer change as time_end advances; the (at most two) steps after them, up to the
+	 * interpolated end, change with every call. An integrator keeps a checkpoint of its state after the committed
+	 * steps and finishes each window on a copy, so each new reading costs a constant number of steps,
+	 * and the result is the same as integrating the whole window again.
+	 */
+	class imu_window_tracker {
+	public:
+		/// Start a new window at @p time_begin.
+		void reset(double time_begin) {
+			_m_time_begin = time_begin;
+			_m_started = false;
+		}
+
+		/**
+		 * @brief Consume the readings of @p buffer up to @p time_end.
+		 *
+		 * @param restart Called first if the checkpoint has to go back to the start of the window:
+		 *                for a new window, if time_end moved backwards, or if consumed readings were dropped from the buffer.
+		 * @param commit Called with (from, to) for each step which became final, in order.
+		 */
+		template <typename Restart, typename Commit>
+		void advance(const imu_buffer& buffer, double time_end, Restart&& restart, Commit&& commit) {
+			if (buffer.size() < 2) {
+				restart();
+				clear();
+				_m_started = false;
+				return;
+			}
+			if (!_m_started || time_end < _m_time_end || buffer.front_seq() > _m_first_seq) {
+				restart();
+				clear();
+				_m_seq = buffer.front_seq() + buffer.window_start(_m_time_begin, time_end);
+				_m_first_seq = _m_seq;
+				_m_started = true;
+			}
+			_m_time_end = time_end;
+
+			_m_end.reset();
+			while (_m_seq + 1 < buffer.front_seq() + buffer.size()) {
+				const imu_reading& current = buffer[_m_seq - buffer.front_seq()];
+				const imu_reading& next = buffer[_m_seq + 1 - buffer.front_seq()];
+				const window_step step = classify_window_step(current, next, _m_time_begin, time_end);
+				if (step == window_step::begin) {
+					accept(interpolate_imu(current, next, _m_time_begin), commit);
+				} else if (step == window_step::inside) {
+					accept(current, commit);
+				} else if (step == window_step::end) {
+					// Not consumed: once more readings arrive, `current` may be inside the window
+					_m_end = interpolate_imu(current, next, time_end);
+					break;
+				}
+				++_m_seq;
+			}
+		}
+
+		/// Call @p step with (from, to) for each step after the committed ones, in order. Returns how many there were.
+		template <typename Step>
+		std::size_t finish(Step&& step) const {
+			std::size_t steps = 0;
+			std::optional<imu_reading> last = _m_last_kept;
+			auto visit = [&](const imu_reading& reading) {
+				if (last) {
+					step(*last, reading);
+					++steps;
+				}
+				last = reading;
+			};
+			if (_m_pending && (!_m_end || std::abs(_m_end->timestamp - _m_pending->timestamp) >= imu_min_dt)) {
+				visit(*_m_pending);
+			}
+			if (_m_end) {
+				visit(*_m_end);
+			}
+			return steps;
+		}
+
+		/// Number of steps committed since the last restart
+		std::size_t committed() const { return _m_committed; }
+
+	private:
+		void clear() {
+			_m_last_kept.reset();
+			_m_pending.reset();
+			_m_end.reset();
+			_m_committed = 0;
+		}
+
+		/// The next reading of the window. The previous one is kept unless the two are (nearly) simultaneous.
+		template <typename Commit>
+		void accept(const imu_reading& reading, Commit& commit) {
+			if (_m_pending && std::abs(reading.timestamp - _m_pending->timestamp) >= imu_min_dt) {
+				if (_m_last_kept) {
+					commit(*_m_last_kept, *_m_pending);
+					++_m_committed;
+				}
+				_m_last_kept = _m_pending;
+			}
+			_m_pending = reading;
+		}
+
+		double _m_time_begin {0};
+		double _m_time_end {0};
+		bool _m_started {false};
+		// Sequence numbers (see imu_buffer::front_seq) of the first reading, and of the next one to consume
+		std::size_t _m_first_seq {0};
+		std::size_t _m_seq {0};
+		std::size_t _m_committed {0};
+		// The last reading of the committed steps
+		std::optional<imu_reading> _m_last_kept;
+		// The newest reading consumed; whether it is kept depends on the one after it
+		std::optional<imu_reading> _m_pending;
+		// The window's end, interpolated to time_end, if the buffer reaches past it
+		std::optional<imu_reading> _m_end;
+	};
+
+}
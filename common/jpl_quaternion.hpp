@@ -0,0 +1,227 @@
+#pragma once
+
+// JPL quaternion and SO(3) helpers shared by the integrators, pose_prediction and pose_lookup,
+// following OpenVINS (https://github.com/rpng/open_vins/blob/master/ov_core/src/utils/quat_ops.h).
+//
+// A JPL quaternion is stored as (x, y, z, w), and rotations compose as in Trawny & Roumeliotis,
+// [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf).
+//
+// Everything takes any fixed-size Eigen expression of the right shape (double or float) and returns a
+// fixed-size matrix, so nothing allocates. They are all forced inline, so a caller compiled for a wider
+// instruction set (e.g. rk4_integrator's AVX2 step) gets its own copy. (Eigen's types are not
+// constexpr, so neither are these.)
+
+#include <cmath>
+#include <eigen3/Eigen/Dense>
+
+namespace ILLIXR {
+
+    /**
+     * @brief Skew-symmetric matrix from a given 3x1 vector
+     *
+     * This is based on equation 6 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf):
+     * \f{align*}{
+     *  \lfloor\mathbf{v}\times\rfloor =
+     *  \begin{bmatrix}
+     *  0 & -v_3 & v_2 \\ v_3 & 0 & -v_1 \\ -v_2 & v_1 & 0
+     *  \end{bmatrix}
+     * @f}
+     *
+     * @param[in] w 3x1 vector to be made a skew-symmetric
+     * @return 3x3 skew-symmetric matrix
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 3, 3> skew_x(const Eigen::MatrixBase<Derived> &w_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 3);
+        const Eigen::Matrix<typename Derived::Scalar, 3, 1> w = w_in;
+        // Element-wise rather than with the comma initializer, which does not inline
+        Eigen::Matrix<typename Derived::Scalar, 3, 3> w_x;
+        w_x(0, 0) = 0;     w_x(0, 1) = -w(2); w_x(0, 2) = w(1);
+        w_x(1, 0) = w(2);  w_x(1, 1) = 0;     w_x(1, 2) = -w(0);
+        w_x(2, 0) = -w(1); w_x(2, 1) = w(0);  w_x(2, 2) = 0;
+        return w_x;
+    }
+
+    /**
+     * @brief Integrated quaternion from angular velocity
+     *
+     * See equation (48) of trawny tech report [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf).
+     *
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 4, 4> Omega(const Eigen::MatrixBase<Derived> &w_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 3);
+        const Eigen::Matrix<typename Derived::Scalar, 3, 1> w = w_in;
+        Eigen::Matrix<typename Derived::Scalar, 4, 4> mat;
+        mat.template block<3, 3>(0, 0) = -skew_x(w);
+        mat.template block<1, 3>(3, 0) = -w.transpose();
+        mat.template block<3, 1>(0, 3) = w;
+        mat(3, 3) = 0;
+        return mat;
+    }
+
+    /**
+     * @brief Normalizes a quaternion to make sure it is unit norm
+     * @param q_t Quaternion to normalized
+     * @return Normalized quaterion
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 4, 1> quatnorm(const Eigen::MatrixBase<Derived> &q_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 4);
+        Eigen::Matrix<typename Derived::Scalar, 4, 1> q_t = q_in;
+        if (q_t(3, 0) < 0) {
+            q_t *= -1;
+        }
+        return q_t / q_t.norm();
+    }
+
+    /**
+     * @brief Converts JPL quaterion to SO(3) rotation matrix
+     *
+     * This is based on equation 62 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf):
+     * \f{align*}{
+     *  \mathbf{R} = (2q_4^2-1)\mathbf{I}_3-2q_4\lfloor\mathbf{q}\times\rfloor+2\mathbf{q}^\top\mathbf{q}
+     * @f}
+     *
+     * @param[in] q JPL quaternion
+     * @return 3x3 SO(3) rotation matrix
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 3, 3> quat_2_Rot(const Eigen::MatrixBase<Derived> &q_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 4);
+        using Scalar = typename Derived::Scalar;
+        const Eigen::Matrix<Scalar, 4, 1> q = q_in;
+        const Eigen::Matrix<Scalar, 3, 1> q_v = q.template head<3>();
+        return (2 * (q(3, 0) * q(3, 0)) - 1) * Eigen::Matrix<Scalar, 3, 3>::Identity()
+               - 2 * q(3, 0) * skew_x(q_v)
+               + 2 * q_v * q_v.transpose();
+    }
+
+    /**
+     * @brief Multiply two JPL quaternions
+     *
+     * This is based on equation 9 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf).
+     * We also enforce that the quaternion is unique by having q_4 be greater than zero.
+     * \f{align*}{
+     *  \bar{q}\otimes\bar{p}=
+     *  \mathcal{L}(\bar{q})\bar{p}=
+     *  \begin{bmatrix}
+     *  q_4\mathbf{I}_3+\lfloor\mathbf{q}\times\rfloor & \mathbf{q} \\
+     *  -\mathbf{q}^\top & q_4
+     *  \end{bmatrix}
+     *  \begin{bmatrix}
+     *  \mathbf{p} \\ p_4
+     *  \end{bmatrix}
+     * @f}
+     *
+     * @param[in] q First JPL quaternion
+     * @param[in] p Second JPL quaternion
+     * @return 4x1 resulting p*q quaternion
+     */
+    template <typename DerivedQ, typename DerivedP>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename DerivedQ::Scalar, 4, 1> quat_multiply(const Eigen::MatrixBase<DerivedQ> &q_in, const Eigen::MatrixBase<DerivedP> &p) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(DerivedQ, 4);
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(DerivedP, 4);
+        using Scalar = typename DerivedQ::Scalar;
+        const Eigen::Matrix<Scalar, 4, 1> q = q_in;
+        const Eigen::Matrix<Scalar, 3, 1> q_v = q.template head<3>();
+        Eigen::Matrix<Scalar, 4, 1> q_t;
+        Eigen::Matrix<Scalar, 4, 4> Qm;
+        // create big L matrix
+        Qm.template block<3, 3>(0, 0) = q(3, 0) * Eigen::Matrix<Scalar, 3, 3>::Identity() - skew_x(q_v);
+        Qm.template block<3, 1>(0, 3) = q_v;
+        Qm.template block<1, 3>(3, 0) = -q_v.transpose();
+        Qm(3, 3) = q(3, 0);
+        q_t = Qm * p;
+        // ensure unique by forcing q_4 to be >0
+        if (q_t(3, 0) < 0) {
+            q_t *= -1;
+        }
+        // normalize and return
+        return q_t / q_t.norm();
+    }
+
+    /**
+     * @brief Inverse of a unit JPL quaternion
+     * @param[in] q JPL quaternion
+     * @return 4x1 inverse quaternion
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 4, 1> quat_inverse(const Eigen::MatrixBase<Derived> &q) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 4);
+        Eigen::Matrix<typename Derived::Scalar, 4, 1> q_inv;
+        q_inv.template head<3>() = -q.template head<3>();
+        q_inv(3) = q(3);
+        return q_inv;
+    }
+
+    /**
+     * @brief SO(3) matrix exponential (Rodrigues' formula)
+     *
+     * \f{align*}{
+     *  \exp(\lfloor\mathbf{w}\times\rfloor) = \mathbf{I} + \frac{\sin\theta}{\theta}\lfloor\mathbf{w}\times\rfloor
+     *      + \frac{1-\cos\theta}{\theta^2}\lfloor\mathbf{w}\times\rfloor^2, \quad \theta = |\mathbf{w}|
+     * @f}
+     *
+     * Near zero, the coefficients come from their Taylor series.
+     *
+     * @param[in] w 3x1 rotation vector
+     * @return 3x3 SO(3) rotation matrix
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 3, 3> exp_so3(const Eigen::MatrixBase<Derived> &w_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 3);
+        using Scalar = typename Derived::Scalar;
+        const Eigen::Matrix<Scalar, 3, 1> w = w_in;
+        const Eigen::Matrix<Scalar, 3, 3> w_x = skew_x(w);
+        const Scalar theta2 = w.squaredNorm();
+        Scalar A, B;
+        if (theta2 < std::sqrt(Eigen::NumTraits<Scalar>::epsilon())) {
+            A = 1 - theta2 / 6;
+            B = Scalar(0.5) - theta2 / 24;
+        } else {
+            const Scalar theta = std::sqrt(theta2);
+            A = std::sin(theta) / theta;
+            B = (1 - std::cos(theta)) / theta2;
+        }
+        return Eigen::Matrix<Scalar, 3, 3>::Identity() + A * w_x + B * w_x * w_x;
+    }
+
+    /**
+     * @brief JPL quaternion of a rotation vector: the closed form of \f$\exp(\frac{1}{2}\Omega(\mathbf{w}))\f$ applied to the identity
+     *
+     * \f{align*}{
+     *  \delta\bar{q} = \begin{bmatrix} \frac{\mathbf{w}}{\theta}\sin\frac{\theta}{2} \\ \cos\frac{\theta}{2} \end{bmatrix}, \quad \theta = |\mathbf{w}|
+     * @f}
+     *
+     * So a constant angular velocity \f$\omega\f$ over \f$\Delta t\f$ takes \f$\bar{q}\f$ to
+     * `quat_multiply(quat_exp(omega * dt), q)` (the zeroth-order integrator, equation 101 in the Trawny report),
+     * and `quat_2_Rot(quat_exp(w)) == exp_so3(-w)`.
+     *
+     * @param[in] w 3x1 rotation vector
+     * @return 4x1 unit JPL quaternion
+     */
+    template <typename Derived>
+    EIGEN_ALWAYS_INLINE Eigen::Matrix<typename Derived::Scalar, 4, 1> quat_exp(const Eigen::MatrixBase<Derived> &w_in) {
+        EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 3);
+        using Scalar = typename Derived::Scalar;
+        const Eigen::Matrix<Scalar, 3, 1> w = w_in;
+        const Scalar theta2 = w.squaredNorm();
+        // sin(theta / 2) / theta
+        Scalar half_sinc;
+        Scalar c;
+        if (theta2 < std::sqrt(Eigen::NumTraits<Scalar>::epsilon())) {
+            half_sinc = Scalar(0.5) - theta2 / 48;
+            c = 1 - theta2 / 8;
+        } else {
+            const Scalar theta = std::sqrt(theta2);
+            half_sinc = std::sin(theta / 2) / theta;
+            c = std::cos(theta / 2);
+        }
+        Eigen::Matrix<Scalar, 4, 1> q;
+        q.template head<3>() = half_sinc * w;
+        q(3) = c;
+        return q;
+    }
+
+}
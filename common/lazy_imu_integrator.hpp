@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "phonebook.hpp"
+#include "switchboard.hpp"
+#include "data_format.hpp"
+#include "global_module_defs.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Whether the IMU integrator propagates on demand (ILLIXR_LAZY_IMU_INTEGRATION).
+	 *
+	 * Read by both the integrator and pose_prediction, so they agree on who drives propagation.
+	 */
+	inline bool lazy_imu_integration_enabled() {
+		return str_to_bool(getenv_or("ILLIXR_LAZY_IMU_INTEGRATION", "False"));
+	}
+
+	/**
+	 * @brief An IMU integrator which only buffers samples, and propagates when a pose is requested.
+	 *
+	 * Registered by the integrator in lazy mode; pose_prediction calls `propagate()` from `get_fast_pose`.
+	 */
+	class lazy_imu_integrator : public phonebook::service {
+	public:
+		/**
+		 * @brief Propagate to the newest buffered IMU sample, and publish the result on `imu_raw`.
+		 *
+		 * Memoized per sample: until another sample arrives, this returns the same result without propagating.
+		 * Null if nothing could be propagated yet (no sample or no `imu_integrator_input`).
+		 */
+		virtual switchboard::ptr<const imu_raw_type> propagate() = 0;
+		virtual ~lazy_imu_integrator() { }
+	};
+
+	/**
+	 * @brief The `lazy_imu_integrator` for an integrator with a `propagate_to(timestamp, real_time)`.
+	 *
+	 * The integrator's IMU callback holds `lock()` while it buffers samples, then reports the newest with `sample_arrived`.
+	 * `propagate()` holds the same lock, so `propagate_to` never sees the buffer mid-update.
+	 */
+	class lazy_imu_propagation : public lazy_imu_integrator {
+	public:
+		using propagate_function = std::function<switchboard::ptr<const imu_raw_type>(double timestamp, time_type real_time)>;
+
+		explicit lazy_imu_propagation(propagate_function propagate_to)
+			: _m_propagate_to{std::move(propagate_to)}
+		{ }
+
+		std::unique_lock<std::mutex> lock() {
+			return std::unique_lock<std::mutex>{_m_mutex};
+		}
+
+		/// Call with `lock()` held
+		void sample_arrived(double timestamp, time_type real_time) {
+			_m_latest_timestamp = timestamp;
+			_m_latest_time = real_time;
+			_m_latest_seq++;
+		}
+
+		virtual switchboard::ptr<const imu_raw_type> propagate() override {
+			std::lock_guard<std::mutex> lock{_m_mutex};
+			if (_m_latest_seq != _m_propagated_seq) {
+				_m_propagated = _m_propagate_to(_m_latest_timestamp, _m_latest_time);
+				_m_propagated_seq = _m_latest_seq;
+				_m_propagations++;
+			}
+			return _m_propagated;
+		}
+
+		/// Samples which arrived so far
+		std::uint64_t samples() {
+			std::lock_guard<std::mutex> lock{_m_mutex};
+			return _m_latest_seq;
+		}
+
+		/// Times `propagate_to` actually ran
+		std::uint64_t propagations() {
+			std::lock_guard<std::mutex> lock{_m_mutex};
+			return _m_propagations;
+		}
+
+	private:
+		const propagate_function _m_propagate_to;
+		std::mutex _m_mutex;
+
+		double _m_latest_timestamp = 0;
+		time_type _m_latest_time;
+		// 0 means no sample yet, which propagate() treats as already propagated
+		std::uint64_t _m_latest_seq = 0;
+		std::uint64_t _m_propagated_seq = 0;
+		std::uint64_t _m_propagations = 0;
+		switchboard::ptr<const imu_raw_type> _m_propagated;
+	};
+
+}
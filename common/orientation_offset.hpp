@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <eigen3/Eigen/Dense>
+
+#include "seqlock.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief The orientation offset which pose_prediction and pose_lookup apply to every pose (see `pose_prediction::set_offset`).
+	 *
+	 * It is read on every pose query, from several render threads, and almost never written.
+	 * Readers copy it out of a `seqlock`, so they never write to a shared cache line;
+	 * writers, which read-modify-write, are serialized by a mutex.
+	 */
+	class orientation_offset {
+	public:
+		Eigen::Quaternionf get() const {
+			return _m_state.load().orientation();
+		}
+
+		/// Bumped on every change, for caches of corrected poses
+		std::uint64_t version() const {
+			return _m_state.load().version;
+		}
+
+		Eigen::Quaternionf apply(const Eigen::Quaternionf& orientation) const {
+			return orientation * get();
+		}
+
+		/**
+		 * @brief Change the offset so that @p raw_o_times_offset, an orientation with the current offset applied,
+		 * maps to the identity.
+		 */
+		void set(const Eigen::Quaternionf& raw_o_times_offset) {
+			std::lock_guard<std::mutex> lock {_m_write_mutex};
+			const state current = _m_state.load();
+			const Eigen::Quaternionf raw_o = raw_o_times_offset * current.orientation().inverse();
+			/*
+			  Now, `raw_o` maps to the identity quaternion.
+			  Proof:
+			  apply(raw_o)
+			      = raw_o * offset
+			      = raw_o * raw_o.inverse()
+			      = Identity.
+			 */
+			_m_state.store(state::from(raw_o.inverse(), current.version + 1));
+		}
+
+		/// Replace the offset
+		void assign(const Eigen::Quaternionf& offset) {
+			std::lock_guard<std::mutex> lock {_m_write_mutex};
+			_m_state.store(state::from(offset, _m_state.load().version + 1));
+		}
+
+	private:
+		// Trivially copyable, for the seqlock
+		struct state {
+			// w, x, y, z
+			float wxyz[4];
+			std::uint64_t version;
+
+			static state from(const Eigen::Quaternionf& q, std::uint64_t version) {
+				return state{{q.w(), q.x(), q.y(), q.z()}, version};
+			}
+
+			Eigen::Quaternionf orientation() const {
+				return Eigen::Quaternionf{wxyz[0], wxyz[1], wxyz[2], wxyz[3]};
+			}
+		};
+
+		seqlock<state> _m_state {state{{1.f, 0.f, 0.f, 0.f}, 0}};
+		std::mutex _m_write_mutex;
+	};
+
+}
@@ -1,3 +1,4 @@
+#include <vector>
 #include "phonebook.hpp"
 #include "data_format.hpp"
 
@@ -8,6 +9,22 @@ public:
 	virtual fast_pose_type get_fast_pose() const = 0;
 	virtual pose_type get_true_pose() const = 0;
 	virtual fast_pose_type get_fast_pose(time_type future_time) const = 0;
+
+	/**
+	 * @brief Poses for several times at once (e.g. the start and end of scanout, or one per eye),
+	 * predicted from the same state.
+	 *
+	 * Implementations which can share work between the times override this.
+	 */
+	virtual std::vector<fast_pose_type> get_fast_poses(const std::vector<time_type>& future_times) const {
+		std::vector<fast_pose_type> fast_poses;
+		fast_poses.reserve(future_times.size());
+		for (const time_type future_time : future_times) {
+			fast_poses.push_back(get_fast_pose(future_time));
+		}
+		return fast_poses;
+	}
+
 	virtual bool fast_pose_reliable() const = 0;
 	virtual bool true_pose_reliable() const = 0;
 	virtual void set_offset(const Eigen::Quaternionf& orientation) = 0;
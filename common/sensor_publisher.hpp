@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "switchboard.hpp"
+#include "data_format.hpp"
+#include "compact_format.hpp"
+#include "global_module_defs.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Publishes IMU and camera samples from a sensor plugin on the split topics.
+	 *
+	 * - Every IMU sample goes on `imu`.
+	 * - If `ILLIXR_IMU_BATCH_SIZE` > 1, IMU samples are also grouped into `imu_batch` events of that many samples
+	 *   (as `imu_cam_compact`).
+	 *   A pending batch is flushed before each frame, so a batch never spans a frame.
+	 * - Every set of images goes on `frame_set`, and each image also goes on its camera's topic (`camera/<id>`).
+	 *   The stereo tracking cameras are `cam0` and `cam1`.
+	 * - Every stereo pair also goes on `stereo_frame`.
+	 * - If `ILLIXR_IMU_CAM_COMPAT` (default True), samples are also published as `imu_cam_type` on `imu_cam`,
+	 *   for plugins which have not moved to the split topics.
+	 *
+	 * Producers should check `wants()` before capturing or decoding a camera, so that cameras nobody
+	 * consumes cost nothing.
+	 */
+	class sensor_publisher {
+	public:
+		/// @param rig Prefix of the calibration ids of this plugin's cameras (`<rig>/<camera id>`).
+		sensor_publisher(const std::shared_ptr<switchboard>& sb, std::string rig = "default")
+			: _m_sb{sb}
+			, _m_rig{std::move(rig)}
+			, _m_imu{sb->get_writer<imu_sample>("imu")}
+			, _m_imu_batch{sb->get_writer<imu_batch_type>("imu_batch")}
+			, _m_stereo_frame{sb->get_writer<stereo_frame_type>("stereo_frame")}
+			, _m_frame_set{sb->get_writer<frame_set_type>("frame_set")}
+			, _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
+			, _m_batch_size{std::max<std::size_t>(1, std::stoul(ILLIXR::getenv_or("ILLIXR_IMU_BATCH_SIZE", "1")))}
+			, _m_compat{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_IMU_CAM_COMPAT", "True"))}
+		{
+			_m_pending.reserve(_m_batch_size);
+		}
+
+		/// Whether any plugin consumes images from @p camera_id, on any topic they are published to.
+		bool wants(const std::string& camera_id) {
+			if (_m_frame_set.has_consumers() || camera_writer(camera_id).has_consumers()) {
+				return true;
+			}
+			const bool stereo_camera = camera_id == "cam0" || camera_id == "cam1";
+			return stereo_camera && (_m_stereo_frame.has_consumers() || (_m_compat && _m_imu_cam.has_consumers()));
+		}
+
+		/// A camera_image from one of this rig's cameras.
+		camera_image image(const std::string& camera_id, image_plane plane, time_type time, ullong dataset_time, cv::Mat mat) const {
+			return camera_image{camera_id, _m_rig + "/" + camera_id, plane, time, dataset_time, std::move(mat)};
+		}
+
+		/// A depth image from one of this rig's cameras, in units of @p depth_scale meters.
+		camera_image depth_image(const std::string& camera_id, time_type time, ullong dataset_time, cv::Mat mat, float depth_scale) const {
+			camera_image depth = image(camera_id, image_plane::depth, time, dataset_time, std::move(mat));
+			depth.depth_scale = depth_scale;
+			return depth;
+		}
+
+		/**
+		 * @brief Publish an IMU sample, and the images taken at the same time if there are any.
+		 *
+		 * @param extra Images from the rig's other cameras (e.g. RGB-D), published in the same frame set.
+		 */
+		void put(time_type time,
+				 const Eigen::Vector3f& angular_v,
+				 const Eigen::Vector3f& linear_a,
+				 const std::optional<cv::Mat>& img0,
+				 const std::optional<cv::Mat>& img1,
+				 ullong dataset_time,
+				 std::vector<camera_image> extra = {}) {
+			if (img0 && img1) {
+				put_stereo(time, *img0, *img1, dataset_time);
+			}
+
+			std::vector<camera_image> images;
+			images.reserve(2 + extra.size());
+			if (img0) {
+				images.push_back(image("cam0", image_plane::gray, time, dataset_time, *img0));
+			}
+			if (img1) {
+				images.push_back(image("cam1", image_plane::gray, time, dataset_time, *img1));
+			}
+			std::move(extra.begin(), extra.end(), std::back_inserter(images));
+			if (!images.empty()) {
+				put_frame_set(time, dataset_time, std::move(images));
+			}
+
+			put_imu(time, angular_v, linear_a, dataset_time);
+
+			if (_m_compat) {
+				_m_imu_cam.put(_m_imu_cam.allocate<imu_cam_type>(
+					imu_cam_type {
+						time,
+						angular_v,
+						linear_a,
+						img0,
+						img1,
+						dataset_time
+					}
+				));
+			}
+		}
+
+		void put_imu(time_type time, const Eigen::Vector3f& angular_v, const Eigen::Vector3f& linear_a, ullong dataset_time) {
+			imu_sample sample {time, angular_v, linear_a, dataset_time};
+			if (_m_batch_size > 1) {
+				_m_pending.push_back(to_compact(sample));
+				if (_m_pending.size() >= _m_batch_size) {
+					flush_imu_batch();
+				}
+			}
+			_m_imu.put(_m_imu.allocate<imu_sample>(std::move(sample)));
+		}
+
+		void put_stereo(time_type time, const cv::Mat& img0, const cv::Mat& img1, ullong dataset_time) {
+			flush_imu_batch();
+			_m_stereo_frame.put(_m_stereo_frame.allocate<stereo_frame_type>(
+				stereo_frame_type {
+					time,
+					img0,
+					img1,
+					dataset_time
+				}
+			));
+		}
+
+		/// Publish each image on its camera's topic, then all of them on `frame_set`.
+		void put_frame_set(time_type time, ullong dataset_time, std::vector<camera_image> images) {
+			flush_imu_batch();
+			for (const camera_image& image : images) {
+				switchboard::writer<camera_frame_type>& writer = camera_writer(image.camera_id);
+				writer.put(writer.allocate<camera_frame_type>(camera_frame_type{image}));
+			}
+			_m_frame_set.put(_m_frame_set.allocate<frame_set_type>(
+				frame_set_type {
+					time,
+					dataset_time,
+					std::move(images)
+				}
+			));
+		}
+
+		/// Publish the IMU samples of a partial batch now.
+		void flush_imu_batch() {
+			if (_m_pending.empty()) {
+				return;
+			}
+			_m_imu_batch.put(_m_imu_batch.allocate<imu_batch_type>(imu_batch_type{std::move(_m_pending)}));
+			_m_pending = std::vector<imu_cam_compact>{};
+			_m_pending.reserve(_m_batch_size);
+		}
+
+		std::size_t batch_size() const {
+			return _m_batch_size;
+		}
+
+	private:
+		switchboard::writer<camera_frame_type>& camera_writer(const std::string& camera_id) {
+			auto found = _m_cameras.find(camera_id);
+			if (found == _m_cameras.end()) {
+				found = _m_cameras.emplace(camera_id, _m_sb->get_writer<camera_frame_type>(camera_topic(camera_id))).first;
+			}
+			return found->second;
+		}
+
+		const std::shared_ptr<switchboard> _m_sb;
+		const std::string _m_rig;
+		switchboard::writer<imu_sample> _m_imu;
+		switchboard::writer<imu_batch_type> _m_imu_batch;
+		switchboard::writer<stereo_frame_type> _m_stereo_frame;
+		switchboard::writer<frame_set_type> _m_frame_set;
+		switchboard::writer<imu_cam_type> _m_imu_cam;
+		std::map<std::string, switchboard::writer<camera_frame_type>> _m_cameras;
+		const std::size_t _m_batch_size;
+		const bool _m_compat;
+		std::vector<imu_cam_compact> _m_pending;
+	};
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ILLIXR {
+
+	/**
+	 * @brief A value which readers copy without locking, and writers replace without blocking readers.
+	 *
+	 * Writers bump a sequence number to odd, store the value, and bump it back to even; a reader retries
+	 * (or gives up, with `try_load`) if the sequence number was odd or changed while it copied.
+	 * The value is held as relaxed atomic words, so a torn copy is discarded instead of being a data race.
+	 *
+	 * Readers never write shared state, so they do not contend with each other.
+	 * `T` must be trivially copyable (Eigen types are not: copy their coefficients into plain arrays).
+	 */
+	template <typename T>
+	class seqlock {
+		static_assert(std::is_trivially_copyable<T>::value, "seqlock values are copied word by word");
+
+	public:
+		seqlock() : seqlock{T{}} { }
+
+		explicit seqlock(const T& value) {
+			store_words(value);
+		}
+
+		/// Copy the value into @p out, unless a write is in progress or raced with the copy.
+		bool try_load(T& out) const {
+			const std::uint64_t before = _m_seq.load(std::memory_order_acquire);
+			if (before & 1) {
+				return false;
+			}
+			std::array<std::uint64_t, words> buffer;
+			for (std::size_t i = 0; i < words; i++) {
+				buffer[i] = _m_words[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_m_seq.load(std::memory_order_relaxed) != before) {
+				return false;
+			}
+			std::memcpy(&out, buffer.data(), sizeof(T));
+			return true;
+		}
+
+		T load() const {
+			T value;
+			while (!try_load(value)) { }
+			return value;
+		}
+
+		/// Store @p value, unless another writer is storing (then its value wins, and this returns false).
+		bool try_store(const T& value) {
+			std::uint64_t seq = _m_seq.load(std::memory_order_relaxed);
+			if ((seq & 1) || !_m_seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				return false;
+			}
+			std::atomic_thread_fence(std::memory_order_release);
+			store_words(value);
+			_m_seq.store(seq + 2, std::memory_order_release);
+			return true;
+		}
+
+		void store(const T& value) {
+			while (!try_store(value)) { }
+		}
+
+	private:
+		static constexpr std::size_t words = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+		void store_words(const T& value) {
+			std::array<std::uint64_t, words> buffer {};
+			std::memcpy(buffer.data(), &value, sizeof(T));
+			for (std::size_t i = 0; i < words; i++) {
+				_m_words[i].store(buffer[i], std::memory_order_relaxed);
+			}
+		}
+
+		std::atomic<std::uint64_t> _m_seq {0};
+		std::array<std::atomic<std::uint64_t>, words> _m_words;
+	};
+
+}
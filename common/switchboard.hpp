@@ -278,6 +278,8 @@ private:
 		std::array<ptr<const event>, _m_latest_buffer_size> _m_latest_buffer;
         std::list<topic_subscription> _m_subscriptions;
         std::shared_mutex _m_subscriptions_lock;
+        // Subscriptions plus readers; lets producers skip work nobody will look at.
+        std::atomic<std::size_t> _m_consumers {0};
 
     public:
         topic(
@@ -294,6 +296,15 @@ private:
 
         const std::type_info& ty() { return _m_ty; }
 
+        /**
+         * @brief Number of subscriptions and readers which have been created for this topic.
+         *
+         * Thread-safe
+         */
+        std::size_t consumers() const { return _m_consumers.load(); }
+
+        void add_consumer() { ++_m_consumers; }
+
         /**
          * @brief Gets a read-only copy of the most recent event on the topic.
          */
@@ -356,6 +367,7 @@ private:
             // Must acquire unique state on _m_subscriptions_lock
             const std::unique_lock lock{_m_subscriptions_lock};
             _m_subscriptions.emplace_back(_m_name, plugin_id, callback, _m_record_logger);
+            add_consumer();
         }
 
         /**
@@ -393,6 +405,7 @@ public:
                 abort();
             }
 #endif
+            _m_topic.add_consumer();
         }
 
        /**
@@ -456,6 +469,16 @@ public:
             : _m_topic{topic_}
         { }
 
+        /**
+         * @brief Whether any plugin has subscribed to, or asked for a reader of, this topic (so far).
+         *
+         * Producers can use this to skip expensive work (e.g. decoding a camera nobody uses).
+         * Consumers may appear at any time, so check again before each publish.
+         */
+        bool has_consumers() const {
+            return _m_topic.consumers() > 0;
+        }
+
         /**
          * @brief Like `new`/`malloc` but more efficient for this specific case.
          *
@@ -0,0 +1,95 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "../compact_format.hpp"
+
+namespace ILLIXR {
+
+class CompactFormatTest : public ::testing::Test { };
+
+TEST_F(CompactFormatTest, ClockDomainRoundTrip) {
+	const clock_domain& clock = clock_domain::process();
+	const time_type now = std::chrono::system_clock::now();
+	const mono_ns mono = clock.from_system(now);
+
+	// Within a millisecond of the monotonic clock sampled right now
+	ASSERT_LT(std::abs(mono - mono_now()), 1000000);
+	ASSERT_EQ(clock.to_system(mono), now);
+}
+
+TEST_F(CompactFormatTest, MonoNowIsMonotonic) {
+	mono_ns last = mono_now();
+	for (int i = 0; i < 1000; ++i) {
+		const mono_ns now = mono_now();
+		ASSERT_GE(now, last);
+		last = now;
+	}
+	ASSERT_EQ(seconds_to_mono(mono_to_seconds(1234567890123)), 1234567890123);
+}
+
+TEST_F(CompactFormatTest, ImuSampleRoundTrip) {
+	const imu_sample sample {
+		std::chrono::system_clock::now(),
+		Eigen::Vector3f{0.1f, -0.2f, 0.3f},
+		Eigen::Vector3f{9.81f, 0.0f, -1.5f},
+		1403636579758555392ULL,
+	};
+	const imu_cam_compact compact = to_compact(sample, 7);
+	ASSERT_EQ(compact.version, imu_cam_compact::current_version);
+	ASSERT_TRUE(compact.has_frame());
+	ASSERT_EQ(compact.frame_seq, 7U);
+	ASSERT_FALSE(to_compact(sample).has_frame());
+
+	const imu_sample back = from_compact(compact);
+	ASSERT_EQ(back.time, sample.time);
+	ASSERT_EQ(back.dataset_time, sample.dataset_time);
+	ASSERT_EQ(back.angular_v, sample.angular_v);
+	ASSERT_EQ(back.linear_a, sample.linear_a);
+}
+
+TEST_F(CompactFormatTest, ImuRawRoundTrip) {
+	const Eigen::Quaterniond quat = Eigen::Quaterniond{0.9, 0.1, -0.3, 0.2}.normalized();
+	const imu_raw_type raw {
+		Eigen::Vector3d{1e-3, 2e-3, 3e-3},
+		Eigen::Vector3d{-1e-2, 0.0, 5e-2},
+		Eigen::Vector3d{1.1e-3, 2.1e-3, 3.1e-3},
+		Eigen::Vector3d{-1.1e-2, 0.0, 5.1e-2},
+		Eigen::Vector3d{12.345678, -3.5, 1.75},
+		Eigen::Vector3d{0.5, 0.25, -0.125},
+		quat,
+		std::chrono::system_clock::now(),
+	};
+	const imu_raw_type back = from_compact(to_compact(raw));
+	ASSERT_EQ(back.imu_time, raw.imu_time);
+	ASSERT_TRUE(back.w_hat.isApprox(raw.w_hat, 1e-6));
+	ASSERT_TRUE(back.a_hat2.isApprox(raw.a_hat2, 1e-6));
+	ASSERT_TRUE(back.pos.isApprox(raw.pos, 1e-6));
+	ASSERT_TRUE(back.vel.isApprox(raw.vel, 1e-6));
+	ASSERT_NEAR(back.quat.angularDistance(raw.quat), 0.0, 1e-6);
+}
+
+TEST_F(CompactFormatTest, FastPoseRoundTrip) {
+	const time_type now = std::chrono::system_clock::now();
+	const fast_pose_type fast_pose {
+		pose_type {
+			now,
+			Eigen::Vector3f{1.0f, 2.0f, 3.0f},
+			Eigen::Quaternionf{0.5f, 0.5f, 0.5f, 0.5f},
+		},
+		now + std::chrono::milliseconds{1},
+		now + std::chrono::milliseconds{16},
+	};
+	const fast_pose_compact compact = to_compact(fast_pose);
+	ASSERT_EQ(compact.predict_target_time - compact.predict_computed_time, 15000000);
+
+	const fast_pose_type back = from_compact(compact);
+	ASSERT_EQ(back.pose.sensor_time, fast_pose.pose.sensor_time);
+	ASSERT_EQ(back.predict_computed_time, fast_pose.predict_computed_time);
+	ASSERT_EQ(back.predict_target_time, fast_pose.predict_target_time);
+	ASSERT_EQ(back.pose.position, fast_pose.pose.position);
+	ASSERT_TRUE(back.pose.orientation.coeffs() == fast_pose.pose.orientation.coeffs());
+
+	const pose_type pose = from_compact(to_compact(fast_pose.pose));
+	ASSERT_EQ(pose.position, fast_pose.pose.position);
+}
+
+}
@@ -0,0 +1,100 @@
+#include <memory>
+#include "gtest/gtest.h"
+#include "../frame_pool.hpp"
+
+namespace ILLIXR {
+
+class FramePoolTest : public ::testing::Test { };
+
+TEST_F(FramePoolTest, ReleasedBuffersAreRecycled) {
+	frame_pool pool {1024 * 1024};
+	const cv::uchar* first_data;
+	{
+		cv::Mat first = pool.acquire(480, 752, CV_8UC1);
+		first_data = first.data;
+		ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first_data) % 64, 0U);
+		ASSERT_EQ(pool.fresh_allocations(), 1U);
+	}
+
+	cv::Mat second = pool.acquire(480, 752, CV_8UC1);
+	ASSERT_EQ(second.data, first_data);
+	ASSERT_EQ(pool.fresh_allocations(), 1U);
+	ASSERT_EQ(pool.reuses(), 1U);
+}
+
+TEST_F(FramePoolTest, SharedFramesAreNotRecycledEarly) {
+	frame_pool pool {1024 * 1024};
+	cv::Mat copy;
+	{
+		cv::Mat original = pool.acquire(10, 10, CV_8UC1);
+		copy = original;
+	}
+
+	// `copy` still holds the only buffer, so this needs a new one
+	cv::Mat other = pool.acquire(10, 10, CV_8UC1);
+	ASSERT_NE(other.data, copy.data);
+	ASSERT_EQ(pool.fresh_allocations(), 2U);
+}
+
+TEST_F(FramePoolTest, EmptyMatAllocatesFromPool) {
+	frame_pool pool {1024 * 1024};
+	cv::Mat mat = pool.empty();
+	mat.create(4, 4, CV_8UC1);
+	ASSERT_FALSE(mat.empty());
+	ASSERT_EQ(pool.fresh_allocations(), 1U);
+}
+
+TEST_F(FramePoolTest, IdleBytesAreBounded) {
+	frame_pool pool {0};
+	{
+		cv::Mat first = pool.acquire(10, 10, CV_8UC1);
+	}
+	cv::Mat second = pool.acquire(10, 10, CV_8UC1);
+	ASSERT_EQ(pool.fresh_allocations(), 2U);
+	ASSERT_EQ(pool.reuses(), 0U);
+}
+
+TEST_F(FramePoolTest, WrapKeepsOwnerAlive) {
+	frame_pool pool {1024 * 1024};
+	auto pixels = std::make_shared<std::vector<cv::uchar>>(16, 7);
+	std::weak_ptr<std::vector<cv::uchar>> watch = pixels;
+
+	cv::Mat wrapped = pool.wrap(4, 4, CV_8UC1, pixels->data(), 4, pixels);
+	pixels.reset();
+	ASSERT_FALSE(watch.expired());
+	ASSERT_EQ(wrapped.data[15], 7);
+
+	cv::Mat copy = wrapped;
+	wrapped.release();
+	ASSERT_FALSE(watch.expired());
+	copy.release();
+	ASSERT_TRUE(watch.expired());
+	ASSERT_EQ(pool.fresh_allocations(), 0U);
+}
+
+TEST_F(FramePoolTest, FramesOutliveThePool) {
+	cv::Mat survivor;
+	{
+		frame_pool pool {1024 * 1024};
+		survivor = pool.acquire(8, 8, CV_8UC1);
+		cv::Mat idle = pool.acquire(8, 8, CV_8UC1);
+	}
+	survivor.data[63] = 1;
+	survivor.release();
+}
+
+TEST_F(FramePoolTest, MatsAllocateAfterThePoolIsGone) {
+	cv::Mat later;
+	{
+		frame_pool pool {1024 * 1024};
+		later = pool.empty();
+	}
+	// Still points at the pool's allocator, which now hands out OpenCV's own buffers
+	later.create(8, 8, CV_8UC1);
+	later.data[63] = 1;
+	later.release();
+	later.create(4, 4, CV_8UC1);
+	ASSERT_FALSE(later.empty());
+}
+
+}
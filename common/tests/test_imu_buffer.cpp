@@ -0,0 +1,168 @@
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../imu_buffer.hpp"
+
+namespace ILLIXR {
+
+class ImuBufferTest : public ::testing::Test {
+protected:
+	// Extrapolating between two readings with the same timestamp gives NaN, in both implementations
+	static bool same(const Eigen::Vector3d& a, const Eigen::Vector3d& b) {
+		return (a.array() == b.array() || (a.array().isNaN() && b.array().isNaN())).all();
+	}
+
+	static imu_reading reading(double timestamp) {
+		return imu_reading{timestamp, Eigen::Vector3d::Constant(timestamp), Eigen::Vector3d::Constant(-timestamp)};
+	}
+
+	// The linear scan the integrators used before the ring buffer
+	static std::vector<imu_reading> select_linear(const std::vector<imu_reading>& imu_data, double time_begin, double time_end) {
+		std::vector<imu_reading> prop_data;
+		if (imu_data.size() < 2) {
+			return prop_data;
+		}
+		for (std::size_t i = 0; i < imu_data.size() - 1; i++) {
+			if (imu_data[i + 1].timestamp > time_begin && imu_data[i].timestamp < time_begin) {
+				prop_data.push_back(interpolate_imu(imu_data[i], imu_data[i + 1], time_begin));
+				continue;
+			}
+			if (imu_data[i].timestamp >= time_begin && imu_data[i + 1].timestamp <= time_end) {
+				prop_data.push_back(imu_data[i]);
+				continue;
+			}
+			if (imu_data[i + 1].timestamp > time_end) {
+				prop_data.push_back(interpolate_imu(imu_data[i], imu_data[i + 1], time_end));
+				break;
+			}
+		}
+		for (std::size_t i = 0; i + 1 < prop_data.size(); i++) {
+			if (std::abs(prop_data[i + 1].timestamp - prop_data[i].timestamp) < 1e-12) {
+				prop_data.erase(prop_data.begin() + i);
+				i--;
+			}
+		}
+		return prop_data;
+	}
+};
+
+TEST_F(ImuBufferTest, OldestReadingIsOverwrittenWhenFull) {
+	imu_buffer buffer {4};
+	for (int i = 0; i < 6; i++) {
+		buffer.push(reading(i));
+	}
+	ASSERT_EQ(buffer.size(), 4U);
+	ASSERT_EQ(buffer.front().timestamp, 2);
+	ASSERT_EQ(buffer.back().timestamp, 5);
+	for (std::size_t i = 0; i < buffer.size(); i++) {
+		ASSERT_EQ(buffer[i].timestamp, double(i + 2));
+	}
+}
+
+TEST_F(ImuBufferTest, OutOfOrderReadingsAreDropped) {
+	imu_buffer buffer {4};
+	ASSERT_TRUE(buffer.push(reading(1)));
+	ASSERT_FALSE(buffer.push(reading(0.5)));
+	ASSERT_TRUE(buffer.push(reading(1)));
+	ASSERT_EQ(buffer.size(), 2U);
+}
+
+TEST_F(ImuBufferTest, ExpireDropsOnlyOlderReadings) {
+	imu_buffer buffer {8};
+	for (int i = 0; i < 8; i++) {
+		buffer.push(reading(i));
+	}
+	buffer.expire_before(3);
+	ASSERT_EQ(buffer.size(), 5U);
+	ASSERT_EQ(buffer.front().timestamp, 3);
+
+	buffer.expire_before(100);
+	ASSERT_TRUE(buffer.empty());
+	ASSERT_TRUE(buffer.select(0, 100).empty());
+}
+
+TEST_F(ImuBufferTest, WindowIsInterpolatedAtBothEnds) {
+	imu_buffer buffer {16};
+	for (int i = 0; i < 10; i++) {
+		buffer.push(reading(i));
+	}
+	const std::vector<imu_reading>& window = buffer.select(2.5, 6.25);
+	ASSERT_EQ(window.size(), 5U);
+	ASSERT_DOUBLE_EQ(window.front().timestamp, 2.5);
+	ASSERT_DOUBLE_EQ(window.front().wm.x(), 2.5);
+	ASSERT_EQ(window[1].timestamp, 3);
+	ASSERT_DOUBLE_EQ(window.back().timestamp, 6.25);
+	ASSERT_DOUBLE_EQ(window.back().am.x(), -6.25);
+}
+
+TEST_F(ImuBufferTest, MatchesLinearScan) {
+	std::mt19937 rng {42};
+	std::uniform_real_distribution<double> step {0., 0.01};
+	std::uniform_real_distribution<double> offset {-0.05, 0.6};
+	std::bernoulli_distribution duplicate {0.1};
+
+	imu_buffer buffer {256};
+	std::vector<imu_reading> all;
+	double t = 0;
+	for (int iteration = 0; iteration < 2000; iteration++) {
+		t += duplicate(rng) ? 0. : step(rng);
+		buffer.push(reading(t));
+		all.push_back(reading(t));
+
+		// The buffer keeps the newest readings once it wraps around
+		const std::vector<imu_reading> kept {all.end() - std::min(all.size(), buffer.capacity()), all.end()};
+		const double time_begin = t - offset(rng);
+		const double time_end = t - offset(rng);
+
+		const std::vector<imu_reading> expected = select_linear(kept, time_begin, time_end);
+		const std::vector<imu_reading>& actual = buffer.select(time_begin, time_end);
+		ASSERT_EQ(actual.size(), expected.size()) << "iteration " << iteration;
+		for (std::size_t i = 0; i < actual.size(); i++) {
+			ASSERT_EQ(actual[i].timestamp, expected[i].timestamp);
+			ASSERT_TRUE(same(actual[i].wm, expected[i].wm));
+			ASSERT_TRUE(same(actual[i].am, expected[i].am));
+		}
+	}
+}
+
+TEST_F(ImuBufferTest, WindowTrackerStepsMatchSelect) {
+	std::mt19937 rng {7};
+	std::uniform_real_distribution<double> step {0., 0.01};
+	std::bernoulli_distribution duplicate {0.1};
+	std::bernoulli_distribution new_window {0.05};
+
+	imu_buffer buffer {256};
+	imu_window_tracker tracker;
+	std::vector<std::pair<imu_reading, imu_reading>> committed;
+	double t = 0;
+	double time_begin = 0;
+	tracker.reset(time_begin);
+	for (int iteration = 0; iteration < 2000; iteration++) {
+		t += duplicate(rng) ? 0. : step(rng);
+		buffer.push(reading(t));
+		buffer.expire_before(t - 1.);
+		if (new_window(rng)) {
+			time_begin = t - 0.2;
+			tracker.reset(time_begin);
+		}
+
+		tracker.advance(buffer, t,
+			[&]() { committed.clear(); },
+			[&](const imu_reading& from, const imu_reading& to) { committed.emplace_back(from, to); }
+		);
+		std::vector<std::pair<imu_reading, imu_reading>> steps = committed;
+		tracker.finish([&](const imu_reading& from, const imu_reading& to) { steps.emplace_back(from, to); });
+		ASSERT_EQ(tracker.committed(), committed.size());
+
+		const std::vector<imu_reading>& window = buffer.select(time_begin, t);
+		ASSERT_EQ(steps.size(), window.size() < 2 ? 0 : window.size() - 1) << "iteration " << iteration;
+		for (std::size_t i = 0; i < steps.size(); i++) {
+			ASSERT_EQ(steps[i].first.timestamp, window[i].timestamp);
+			ASSERT_EQ(steps[i].second.timestamp, window[i + 1].timestamp);
+			ASSERT_TRUE(same(steps[i].first.wm, window[i].wm));
+			ASSERT_TRUE(same(steps[i].second.am, window[i + 1].am));
+		}
+	}
+}
+
+}
@@ -0,0 +1,140 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "../jpl_quaternion.hpp"
+
+namespace ILLIXR {
+
+// The helpers as pose_prediction and rk4_integrator had them, with dynamic-size temporaries
+namespace dynamic {
+
+	static Eigen::Matrix<double, 3, 3> skew_x(const Eigen::Matrix<double, 3, 1> &w) {
+		Eigen::Matrix<double, 3, 3> w_x;
+		w_x << 0, -w(2), w(1),
+				w(2), 0, -w(0),
+				-w(1), w(0), 0;
+		return w_x;
+	}
+
+	static Eigen::Matrix<double, 4, 4> Omega(Eigen::Matrix<double, 3, 1> w) {
+		Eigen::Matrix<double, 4, 4> mat;
+		mat.block(0, 0, 3, 3) = -skew_x(w);
+		mat.block(3, 0, 1, 3) = -w.transpose();
+		mat.block(0, 3, 3, 1) = w;
+		mat(3, 3) = 0;
+		return mat;
+	}
+
+	static Eigen::Matrix<double, 4, 1> quatnorm(Eigen::Matrix<double, 4, 1> q_t) {
+		if (q_t(3, 0) < 0) {
+			q_t *= -1;
+		}
+		return q_t / q_t.norm();
+	}
+
+	static Eigen::Matrix<double, 3, 3> quat_2_Rot(const Eigen::Matrix<double, 4, 1> &q) {
+		Eigen::Matrix<double, 3, 3> q_x = skew_x(q.block(0, 0, 3, 1));
+		Eigen::MatrixXd Rot = (2 * std::pow(q(3, 0), 2) - 1) * Eigen::MatrixXd::Identity(3, 3)
+							  - 2 * q(3, 0) * q_x +
+							  2 * q.block(0, 0, 3, 1) * (q.block(0, 0, 3, 1).transpose());
+		return Rot;
+	}
+
+	static Eigen::Matrix<double, 4, 1> quat_multiply(const Eigen::Matrix<double, 4, 1> &q, const Eigen::Matrix<double, 4, 1> &p) {
+		Eigen::Matrix<double, 4, 1> q_t;
+		Eigen::Matrix<double, 4, 4> Qm;
+		Qm.block(0, 0, 3, 3) = q(3, 0) * Eigen::MatrixXd::Identity(3, 3) - skew_x(q.block(0, 0, 3, 1));
+		Qm.block(0, 3, 3, 1) = q.block(0, 0, 3, 1);
+		Qm.block(3, 0, 1, 3) = -q.block(0, 0, 3, 1).transpose();
+		Qm(3, 3) = q(3, 0);
+		q_t = Qm * p;
+		if (q_t(3, 0) < 0) {
+			q_t *= -1;
+		}
+		return q_t / q_t.norm();
+	}
+
+}
+
+class JplQuaternionTest : public ::testing::Test {
+protected:
+	Eigen::Vector3d vector3() {
+		return Eigen::Vector3d{noise(rng), noise(rng), noise(rng)};
+	}
+
+	Eigen::Vector4d quaternion() {
+		return Eigen::Vector4d{noise(rng), noise(rng), noise(rng), noise(rng)}.normalized();
+	}
+
+	std::mt19937 rng {5};
+	std::normal_distribution<double> noise {0., 1.};
+};
+
+TEST_F(JplQuaternionTest, MatchesDynamicImplementation) {
+	for (int i = 0; i < 1000; i++) {
+		const Eigen::Vector3d w = vector3();
+		const Eigen::Vector4d q = quaternion();
+		const Eigen::Vector4d p = quaternion();
+		const Eigen::Vector4d unnormalized = q * 3.;
+
+		ASSERT_TRUE(skew_x(w) == dynamic::skew_x(w));
+		ASSERT_TRUE(Omega(w) == dynamic::Omega(w));
+		ASSERT_TRUE(quatnorm(unnormalized) == dynamic::quatnorm(unnormalized));
+		ASSERT_TRUE(quat_2_Rot(q) == dynamic::quat_2_Rot(q));
+		ASSERT_TRUE(quat_multiply(q, p) == dynamic::quat_multiply(q, p));
+	}
+}
+
+TEST_F(JplQuaternionTest, AcceptsExpressionsAndFloat) {
+	const Eigen::Vector4d q = quaternion();
+	const Eigen::Matrix<double, 7, 1> state = (Eigen::Matrix<double, 7, 1>() << q, 1., 2., 3.).finished();
+	ASSERT_TRUE(quat_2_Rot(state.head<4>()) == quat_2_Rot(q));
+	ASSERT_TRUE(quatnorm(q * 2.) == quatnorm(Eigen::Vector4d{q * 2.}));
+
+	const Eigen::Vector4f qf = q.cast<float>();
+	ASSERT_TRUE(quat_2_Rot(qf).cast<double>().isApprox(quat_2_Rot(q), 1e-6));
+}
+
+TEST_F(JplQuaternionTest, InverseUndoesMultiply) {
+	for (int i = 0; i < 100; i++) {
+		const Eigen::Vector4d q = quaternion();
+		const Eigen::Vector4d identity = quat_multiply(q, quat_inverse(q));
+		ASSERT_TRUE(identity.isApprox(Eigen::Vector4d{0, 0, 0, 1}, 1e-12));
+	}
+}
+
+TEST_F(JplQuaternionTest, ExpSo3MatchesAngleAxis) {
+	for (int i = 0; i < 100; i++) {
+		const Eigen::Vector3d w = vector3();
+		const Eigen::Matrix3d expected = Eigen::AngleAxisd{w.norm(), w.normalized()}.toRotationMatrix();
+		ASSERT_TRUE(exp_so3(w).isApprox(expected, 1e-12));
+	}
+	ASSERT_TRUE(exp_so3(Eigen::Vector3d::Zero()) == Eigen::Matrix3d::Identity());
+}
+
+TEST_F(JplQuaternionTest, QuatExpIsAConsistentRotation) {
+	for (int i = 0; i < 100; i++) {
+		const Eigen::Vector3d w = vector3();
+		const Eigen::Vector4d q = quat_exp(w);
+		ASSERT_NEAR(q.norm(), 1., 1e-15);
+		// JPL rotation matrices are the transpose of the (Hamilton) active rotation
+		ASSERT_TRUE(quat_2_Rot(q).isApprox(exp_so3(-w), 1e-12));
+		// Rotating by w in two halves
+		ASSERT_TRUE(quat_multiply(quat_exp(w / 2.), quat_exp(w / 2.)).isApprox(quatnorm(q), 1e-12));
+	}
+	ASSERT_TRUE(quat_exp(Eigen::Vector3d::Zero()) == (Eigen::Vector4d{0, 0, 0, 1}));
+}
+
+TEST_F(JplQuaternionTest, SmallAnglesAreContinuous) {
+	const Eigen::Vector3d axis = Eigen::Vector3d{1., -2., 0.5}.normalized();
+	for (double theta : {1e-10, 1e-6, 1e-4, 1.2e-4, 1e-3}) {
+		const Eigen::Vector3d w = axis * theta;
+		const Eigen::Matrix3d expected = Eigen::AngleAxisd{theta, axis}.toRotationMatrix();
+		EXPECT_TRUE(exp_so3(w).isApprox(expected, 1e-15)) << theta;
+		const Eigen::Vector4d q = quat_exp(w);
+		EXPECT_NEAR(q(3), std::cos(theta / 2.), 1e-16) << theta;
+		EXPECT_TRUE(q.head<3>().isApprox(axis * std::sin(theta / 2.), 1e-15)) << theta;
+	}
+}
+
+}
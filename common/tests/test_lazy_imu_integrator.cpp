@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "../lazy_imu_integrator.hpp"
+
+namespace ILLIXR {
+
+class LazyImuIntegratorTest : public ::testing::Test { };
+
+namespace {
+	switchboard::ptr<const imu_raw_type> make_imu_raw(double timestamp, time_type real_time) {
+		return std::make_shared<const imu_raw_type>(
+			Eigen::Vector3d::Zero(),
+			Eigen::Vector3d::Zero(),
+			Eigen::Vector3d::Zero(),
+			Eigen::Vector3d::Zero(),
+			Eigen::Vector3d{timestamp, 0, 0},
+			Eigen::Vector3d::Zero(),
+			Eigen::Quaterniond::Identity(),
+			real_time
+		);
+	}
+}
+
+TEST_F(LazyImuIntegratorTest, PropagatesOncePerSample) {
+	std::vector<double> propagated_to;
+	lazy_imu_propagation lazy {[&](double timestamp, time_type real_time) {
+		propagated_to.push_back(timestamp);
+		return make_imu_raw(timestamp, real_time);
+	}};
+
+	// Nothing to propagate before the first sample
+	ASSERT_EQ(lazy.propagate(), nullptr);
+	ASSERT_TRUE(propagated_to.empty());
+
+	const time_type now = std::chrono::system_clock::now();
+	{
+		auto lock = lazy.lock();
+		lazy.sample_arrived(1., now);
+	}
+	const switchboard::ptr<const imu_raw_type> first = lazy.propagate();
+	ASSERT_NE(first, nullptr);
+	ASSERT_EQ(first->pos.x(), 1.);
+	ASSERT_EQ(lazy.propagate(), first);
+	ASSERT_EQ(lazy.propagate(), first);
+
+	// Only the newest of several samples is propagated to
+	{
+		auto lock = lazy.lock();
+		lazy.sample_arrived(2., now);
+		lazy.sample_arrived(3., now);
+	}
+	ASSERT_EQ(lazy.propagate()->pos.x(), 3.);
+	ASSERT_EQ(lazy.propagate()->pos.x(), 3.);
+
+	ASSERT_EQ(propagated_to, (std::vector<double>{1., 3.}));
+	ASSERT_EQ(lazy.samples(), 3U);
+	ASSERT_EQ(lazy.propagations(), 2U);
+}
+
+TEST_F(LazyImuIntegratorTest, NullPropagationIsMemoizedUntilTheNextSample) {
+	bool has_input = false;
+	std::size_t calls = 0;
+	lazy_imu_propagation lazy {[&](double timestamp, time_type real_time) {
+		calls++;
+		return has_input ? make_imu_raw(timestamp, real_time) : nullptr;
+	}};
+
+	const time_type now = std::chrono::system_clock::now();
+	{
+		auto lock = lazy.lock();
+		lazy.sample_arrived(1., now);
+	}
+	ASSERT_EQ(lazy.propagate(), nullptr);
+	has_input = true;
+	ASSERT_EQ(lazy.propagate(), nullptr);
+	ASSERT_EQ(calls, 1U);
+
+	{
+		auto lock = lazy.lock();
+		lazy.sample_arrived(2., now);
+	}
+	ASSERT_NE(lazy.propagate(), nullptr);
+	ASSERT_EQ(calls, 2U);
+}
+
+}
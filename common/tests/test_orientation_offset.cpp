@@ -0,0 +1,33 @@
+#include "gtest/gtest.h"
+#include "../orientation_offset.hpp"
+
+namespace ILLIXR {
+
+class OrientationOffsetTest : public ::testing::Test { };
+
+TEST_F(OrientationOffsetTest, SetMapsTheCurrentOrientationToIdentity) {
+	orientation_offset offset;
+	ASSERT_EQ(offset.version(), 0U);
+	ASSERT_TRUE(offset.get().isApprox(Eigen::Quaternionf::Identity()));
+
+	const Eigen::Quaternionf raw {Eigen::AngleAxisf{0.5f, Eigen::Vector3f{1.f, 2.f, 3.f}.normalized()}};
+	offset.set(offset.apply(raw));
+	ASSERT_EQ(offset.version(), 1U);
+	ASSERT_TRUE(offset.apply(raw).isApprox(Eigen::Quaternionf::Identity()));
+
+	// Recentering again, after the head turned further
+	const Eigen::Quaternionf turned = raw * Eigen::Quaternionf{Eigen::AngleAxisf{0.25f, Eigen::Vector3f::UnitY()}};
+	offset.set(offset.apply(turned));
+	ASSERT_EQ(offset.version(), 2U);
+	ASSERT_TRUE(offset.apply(turned).isApprox(Eigen::Quaternionf::Identity()));
+}
+
+TEST_F(OrientationOffsetTest, AssignReplacesTheOffset) {
+	orientation_offset offset;
+	const Eigen::Quaternionf q {Eigen::AngleAxisf{1.f, Eigen::Vector3f::UnitX()}};
+	offset.assign(q);
+	ASSERT_EQ(offset.version(), 1U);
+	ASSERT_TRUE(offset.get().isApprox(q));
+}
+
+}
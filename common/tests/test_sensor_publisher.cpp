@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "../sensor_publisher.hpp"
+
+namespace ILLIXR {
+
+class SensorPublisherTest : public ::testing::Test { };
+
+TEST_F(SensorPublisherTest, CamerasAreOnlyWantedWhenConsumed) {
+	auto sb = std::make_shared<switchboard>(nullptr);
+	sensor_publisher publisher {sb, "rig"};
+	ASSERT_FALSE(publisher.wants("cam0"));
+	ASSERT_FALSE(publisher.wants("cam2"));
+
+	[[maybe_unused]] auto cam2 = sb->get_reader<camera_frame_type>(camera_topic("cam2"));
+	ASSERT_TRUE(publisher.wants("cam2"));
+	ASSERT_FALSE(publisher.wants("cam3"));
+
+	// Stereo consumers want both tracking cameras, but not the others
+	[[maybe_unused]] auto stereo = sb->get_reader<stereo_frame_type>("stereo_frame");
+	ASSERT_TRUE(publisher.wants("cam0"));
+	ASSERT_TRUE(publisher.wants("cam1"));
+	ASSERT_FALSE(publisher.wants("cam3"));
+
+	// Frame set consumers want everything
+	[[maybe_unused]] auto frame_set = sb->get_reader<frame_set_type>("frame_set");
+	ASSERT_TRUE(publisher.wants("cam3"));
+}
+
+TEST_F(SensorPublisherTest, EachCameraHasItsOwnTopic) {
+	auto sb = std::make_shared<switchboard>(nullptr);
+	sensor_publisher publisher {sb, "rig"};
+	auto frame_set = sb->get_reader<frame_set_type>("frame_set");
+	auto cam2 = sb->get_reader<camera_frame_type>(camera_topic("cam2"));
+	auto stereo = sb->get_reader<stereo_frame_type>("stereo_frame");
+
+	const time_type now = std::chrono::system_clock::now();
+	publisher.put_frame_set(now, 42, {
+		publisher.image("cam2", image_plane::gray, now, 41, cv::Mat{}),
+		publisher.image("cam3", image_plane::gray, now, 43, cv::Mat{}),
+	});
+
+	auto latest_set = frame_set.get_ro();
+	ASSERT_EQ(latest_set->images.size(), 2U);
+	ASSERT_EQ(latest_set->find("cam3")->dataset_time, 43U);
+	ASSERT_EQ(latest_set->find("cam0"), nullptr);
+
+	auto latest_cam2 = cam2.get_ro();
+	ASSERT_EQ(latest_cam2->frame.camera_id, "cam2");
+	ASSERT_EQ(latest_cam2->frame.calibration_id, "rig/cam2");
+	ASSERT_EQ(latest_cam2->frame.dataset_time, 41U);
+
+	// Not a stereo pair
+	ASSERT_EQ(stereo.get_ro_nullable(), nullptr);
+}
+
+TEST_F(SensorPublisherTest, DepthImagesCarryTheirScale) {
+	auto sb = std::make_shared<switchboard>(nullptr);
+	sensor_publisher publisher {sb, "rig"};
+	const time_type now = std::chrono::system_clock::now();
+
+	const camera_image depth = publisher.depth_image("depth", now, 1, cv::Mat{}, 0.001f);
+	ASSERT_EQ(depth.plane, image_plane::depth);
+	ASSERT_EQ(depth.calibration_id, "rig/depth");
+	ASSERT_EQ(depth.depth_scale, 0.001f);
+	ASSERT_EQ(publisher.image("rgb", image_plane::color, now, 1, cv::Mat{}).depth_scale, 0.f);
+}
+
+TEST_F(SensorPublisherTest, StereoSamplesFillEveryTopic) {
+	auto sb = std::make_shared<switchboard>(nullptr);
+	sensor_publisher publisher {sb, "rig"};
+	auto frame_set = sb->get_reader<frame_set_type>("frame_set");
+	auto cam1 = sb->get_reader<camera_frame_type>(camera_topic("cam1"));
+	auto stereo = sb->get_reader<stereo_frame_type>("stereo_frame");
+	auto imu = sb->get_reader<imu_sample>("imu");
+
+	const time_type now = std::chrono::system_clock::now();
+	publisher.put(now, Eigen::Vector3f::Zero(), Eigen::Vector3f::UnitZ(), cv::Mat{}, cv::Mat{}, 7);
+
+	ASSERT_EQ(stereo.get_ro()->dataset_time, 7U);
+	ASSERT_EQ(frame_set.get_ro()->images.size(), 2U);
+	ASSERT_EQ(cam1.get_ro()->frame.plane, image_plane::gray);
+	ASSERT_EQ(imu.get_ro()->linear_a, Eigen::Vector3f::UnitZ());
+
+	// An IMU-only sample publishes no frames
+	publisher.put(now, Eigen::Vector3f::Zero(), Eigen::Vector3f::UnitX(), std::nullopt, std::nullopt, 8);
+	ASSERT_EQ(frame_set.get_ro()->dataset_time, 7U);
+	ASSERT_EQ(imu.get_ro()->dataset_time, 8U);
+}
+
+TEST_F(SensorPublisherTest, BatchesCarryCompactSamples) {
+	setenv("ILLIXR_IMU_BATCH_SIZE", "3", 1);
+	auto sb = std::make_shared<switchboard>(nullptr);
+	sensor_publisher publisher {sb, "rig"};
+	unsetenv("ILLIXR_IMU_BATCH_SIZE");
+	auto imu_batch = sb->get_reader<imu_batch_type>("imu_batch");
+
+	const time_type now = std::chrono::system_clock::now();
+	publisher.put_imu(now, Eigen::Vector3f{1.f, 2.f, 3.f}, Eigen::Vector3f{4.f, 5.f, 6.f}, 10);
+	publisher.put_imu(now + std::chrono::milliseconds{5}, Eigen::Vector3f{7.f, 8.f, 9.f}, Eigen::Vector3f{0.f, 0.f, 9.81f}, 20);
+	ASSERT_EQ(imu_batch.get_ro_nullable(), nullptr);
+
+	// A partial batch goes out when flushed
+	publisher.flush_imu_batch();
+	auto batch = imu_batch.get_ro();
+	ASSERT_EQ(batch->samples.size(), 2U);
+	const imu_sample last = from_compact(batch->samples.back());
+	ASSERT_EQ(last.dataset_time, 20U);
+	ASSERT_EQ(last.angular_v, (Eigen::Vector3f{7.f, 8.f, 9.f}));
+	ASSERT_FALSE(batch->samples.back().has_frame());
+}
+
+}
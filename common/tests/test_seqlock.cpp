@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "../seqlock.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace ILLIXR {
+
+class SeqlockTest : public ::testing::Test { };
+
+namespace {
+	// Deliberately not a multiple of 8 bytes
+	struct sample {
+		std::uint32_t fields[7];
+	};
+
+	sample make_sample(std::uint32_t value) {
+		sample s;
+		for (std::uint32_t& field : s.fields) {
+			field = value;
+		}
+		return s;
+	}
+
+	bool consistent(const sample& s) {
+		for (std::uint32_t field : s.fields) {
+			if (field != s.fields[0]) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST_F(SeqlockTest, LoadsWhatWasStored) {
+	seqlock<sample> lock {make_sample(3)};
+	ASSERT_EQ(lock.load().fields[6], 3U);
+
+	ASSERT_TRUE(lock.try_store(make_sample(5)));
+	sample out;
+	ASSERT_TRUE(lock.try_load(out));
+	ASSERT_EQ(out.fields[0], 5U);
+	ASSERT_EQ(out.fields[6], 5U);
+
+	lock.store(make_sample(7));
+	ASSERT_EQ(lock.load().fields[3], 7U);
+}
+
+TEST_F(SeqlockTest, ReadersNeverSeeTornValues) {
+	seqlock<sample> lock {make_sample(0)};
+	constexpr std::uint32_t stores = 200000;
+	std::atomic<bool> done {false};
+
+	std::vector<std::thread> readers;
+	std::atomic<std::size_t> torn {0};
+	std::atomic<std::size_t> loads {0};
+	for (int i = 0; i < 3; i++) {
+		readers.emplace_back([&]() {
+			while (!done.load()) {
+				sample s;
+				if (lock.try_load(s)) {
+					loads++;
+					if (!consistent(s)) {
+						torn++;
+					}
+				}
+			}
+		});
+	}
+
+	// Two writers: each store either lands whole or is dropped
+	std::thread other_writer {[&]() {
+		for (std::uint32_t i = 1; i <= stores; i++) {
+			lock.try_store(make_sample(stores + i));
+		}
+	}};
+	for (std::uint32_t i = 1; i <= stores; i++) {
+		lock.try_store(make_sample(i));
+	}
+	other_writer.join();
+	done = true;
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	ASSERT_EQ(torn.load(), 0U);
+	ASSERT_GT(loads.load(), 0U);
+	ASSERT_TRUE(consistent(lock.load()));
+}
+
+}
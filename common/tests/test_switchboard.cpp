@@ -188,4 +188,19 @@ TEST_F(SwitchboardTest, TestSyncAsync) {
 	// ASSERT_EQ(uint64_wrapper::get_destructed_count(), MAX_ITERATIONS - 1);
 }
 
+TEST_F(SwitchboardTest, TestHasConsumers) {
+	switchboard sb {nullptr};
+
+	auto writer = sb.get_writer<uint64_wrapper>("unwatched");
+	ASSERT_FALSE(writer.has_consumers());
+
+	auto reader = sb.get_reader<uint64_wrapper>("unwatched");
+	ASSERT_TRUE(writer.has_consumers());
+
+	auto other_writer = sb.get_writer<uint64_wrapper>("scheduled");
+	ASSERT_FALSE(other_writer.has_consumers());
+	sb.schedule<uint64_wrapper>(0, "scheduled", [](switchboard::ptr<const uint64_wrapper>&&, std::size_t) { });
+	ASSERT_TRUE(other_writer.has_consumers());
+}
+
 }
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "csv_iterator.hpp"
+#include "common/dataset.hpp"
+#include "common/error_util.hpp"
+#include "common/global_module_defs.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Sort entries by time; for duplicate timestamps, the last row in the file wins.
+ */
+template <typename T>
+static
+timed_stream<T>
+make_stream(std::vector<typename timed_stream<T>::entry>&& entries) {
+	using entry = typename timed_stream<T>::entry;
+	std::stable_sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.time < b.time; });
+	auto last = std::unique(entries.rbegin(), entries.rend(), [](const entry& a, const entry& b) { return a.time == b.time; });
+	entries.erase(entries.begin(), last.base());
+	return timed_stream<T>{std::move(entries)};
+}
+
+// timestamp [ns], w_RS_S_x [rad s^-1], w_RS_S_y [rad s^-1], w_RS_S_z [rad s^-1],
+// a_RS_S_x [m s^-2], a_RS_S_y [m s^-2], a_RS_S_z [m s^-2]
+static
+std::optional<timed_stream<dataset::imu_reading>>
+load_imu(const std::string& path) {
+	std::ifstream file {path};
+	if (!file.good()) {
+		return std::nullopt;
+	}
+
+	std::vector<timed_stream<dataset::imu_reading>::entry> entries;
+	for (CSVIterator row{file, 1}; row != CSVIterator{}; ++row) {
+		ullong t = std::stoull(row[0]);
+		Eigen::Vector3d av {std::stod(row[1]), std::stod(row[2]), std::stod(row[3])};
+		Eigen::Vector3d la {std::stod(row[4]), std::stod(row[5]), std::stod(row[6])};
+		entries.push_back({t, {av, la}});
+	}
+	return make_stream<dataset::imu_reading>(std::move(entries));
+}
+
+// timestamp [ns], filename
+static
+std::optional<timed_stream<std::string>>
+load_cam(const std::string& path, const std::string& image_dir) {
+	std::ifstream file {path};
+	if (!file.good()) {
+		return std::nullopt;
+	}
+
+	std::vector<timed_stream<std::string>::entry> entries;
+	for (CSVIterator row{file, 1}; row != CSVIterator{}; ++row) {
+		ullong t = std::stoull(row[0]);
+		entries.push_back({t, image_dir + row[1]});
+	}
+	return make_stream<std::string>(std::move(entries));
+}
+
+// timestamp
+// p_RS_R_x [m], p_RS_R_y [m], p_RS_R_z [m]
+// q_RS_w [], q_RS_x [], q_RS_y [], q_RS_z []
+// v_RS_R_x [m s^-1], v_RS_R_y [m s^-1], v_RS_R_z [m s^-1]
+// b_w_RS_S_x [rad s^-1], b_w_RS_S_y [rad s^-1], b_w_RS_S_z [rad s^-1]
+// b_a_RS_S_x [m s^-2], b_a_RS_S_y [m s^-2], b_a_RS_S_z [m s^-2]
+static
+std::optional<timed_stream<pose_type>>
+load_ground_truth(const std::string& path) {
+	std::ifstream file {path};
+	if (!file.good()) {
+		return std::nullopt;
+	}
+
+	std::vector<timed_stream<pose_type>::entry> entries;
+	for (CSVIterator row{file, 1}; row != CSVIterator{}; ++row) {
+		ullong t = std::stoull(row[0]);
+		Eigen::Vector3f position {std::stof(row[1]), std::stof(row[2]), std::stof(row[3])};
+		Eigen::Quaternionf orientation {std::stof(row[4]), std::stof(row[5]), std::stof(row[6]), std::stof(row[7])};
+		entries.push_back({t, pose_type{{}, position, orientation}});
+	}
+	return make_stream<pose_type>(std::move(entries));
+}
+
+/**
+ * @brief The sequence directories to load.
+ *
+ * `ILLIXR_DATA_SEQUENCES` is a colon-separated list of dataset directories.
+ * If unset, the single sequence in `ILLIXR_DATA` is used.
+ */
+static
+std::vector<std::string>
+sequence_paths() {
+	std::string sequences = ILLIXR::getenv_or("ILLIXR_DATA_SEQUENCES", "");
+	if (sequences.empty()) {
+		const char* illixr_data_c_str = std::getenv("ILLIXR_DATA");
+		if (!illixr_data_c_str) {
+			ILLIXR::abort("Please define ILLIXR_DATA or ILLIXR_DATA_SEQUENCES");
+		}
+		sequences = illixr_data_c_str;
+	}
+
+	std::vector<std::string> paths;
+	std::size_t begin = 0;
+	while (begin <= sequences.size()) {
+		std::size_t end = sequences.find(':', begin);
+		if (end == std::string::npos) {
+			end = sequences.size();
+		}
+		if (end > begin) {
+			paths.push_back(sequences.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+
+	if (paths.empty()) {
+		ILLIXR::abort("ILLIXR_DATA_SEQUENCES does not name any sequence");
+	}
+	return paths;
+}
@@ -0,0 +1,105 @@
+#include <deque>
+#include <future>
+#include <mutex>
+#include "common/phonebook.hpp"
+#include "common/plugin.hpp"
+#include "common/dataset.hpp"
+#include "data_loading.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Loads each sequence once, the first time a plugin asks for one of its streams.
+ *
+ * Sequences no plugin asks for are never read. The first access to a sequence starts parsing all of its
+ * streams in parallel (one thread each); accessors wait only for the stream they asked for.
+ * A stream whose file is missing is only an error if a plugin asks for it.
+ */
+class dataset_impl : public dataset {
+public:
+	dataset_impl() {
+		for (const std::string& path : sequence_paths()) {
+			_m_sequences.emplace_back(path);
+		}
+	}
+
+	virtual std::size_t num_sequences() const override {
+		return _m_sequences.size();
+	}
+
+	virtual const std::string& path(std::size_t seq) const override {
+		return _m_sequences.at(seq).path;
+	}
+
+	virtual const timed_stream<imu_reading>& imu0(std::size_t seq) const override {
+		return get(started(seq).imu0, seq, "/imu0/data.csv");
+	}
+
+	virtual const timed_stream<std::string>& cam0(std::size_t seq) const override {
+		return get(started(seq).cam0, seq, "/cam0/data.csv");
+	}
+
+	virtual const timed_stream<std::string>& cam1(std::size_t seq) const override {
+		return get(started(seq).cam1, seq, "/cam1/data.csv");
+	}
+
+	virtual const timed_stream<pose_type>& ground_truth(std::size_t seq) const override {
+		return get(started(seq).ground_truth, seq, "/state_groundtruth_estimate0/data.csv");
+	}
+
+private:
+	template <typename T>
+	using pending_stream = std::shared_future<std::optional<timed_stream<T>>>;
+
+	struct sequence {
+		explicit sequence(std::string path_)
+			: path{std::move(path_)}
+		{ }
+
+		const std::string path;
+		// Set by the first access (see started)
+		std::once_flag loading;
+		pending_stream<imu_reading> imu0;
+		pending_stream<std::string> cam0;
+		pending_stream<std::string> cam1;
+		pending_stream<pose_type> ground_truth;
+	};
+
+	const sequence& started(std::size_t seq) const {
+		sequence& s = _m_sequences.at(seq);
+		std::call_once(s.loading, [&s] {
+			s.imu0 = std::async(std::launch::async, load_imu, s.path + "/imu0/data.csv").share();
+			s.cam0 = std::async(std::launch::async, load_cam, s.path + "/cam0/data.csv", s.path + "/cam0/data/").share();
+			s.cam1 = std::async(std::launch::async, load_cam, s.path + "/cam1/data.csv", s.path + "/cam1/data/").share();
+			s.ground_truth = std::async(std::launch::async, load_ground_truth, s.path + "/state_groundtruth_estimate0/data.csv").share();
+		});
+		return s;
+	}
+
+	template <typename T>
+	const timed_stream<T>& get(const pending_stream<T>& stream, std::size_t seq, const std::string& subpath) const {
+		const std::optional<timed_stream<T>>& loaded = stream.get();
+		if (!loaded) {
+			ILLIXR::abort(_m_sequences[seq].path + subpath + " is not a good path");
+		}
+		return *loaded;
+	}
+
+	// A deque, since sequences (holding a once_flag) cannot move
+	mutable std::deque<sequence> _m_sequences;
+};
+
+class dataset_plugin : public plugin {
+public:
+	dataset_plugin(const std::string& name, phonebook* pb)
+		: plugin{name, pb}
+	{
+		pb->register_impl<dataset>(
+			std::static_pointer_cast<dataset>(
+				std::make_shared<dataset_impl>()
+			)
+		);
+	}
+};
+
+PLUGIN_MAIN(dataset_plugin);
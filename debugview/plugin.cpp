@@ -74,15 +74,10 @@ public:
 		, pp{pb->lookup_impl<pose_prediction>()}
 		, _m_slow_pose{sb->get_reader<pose_type>("slow_pose")}
 		, _m_fast_pose{sb->get_reader<imu_raw_type>("imu_raw")}
+		, _m_stereo_frame{sb->get_reader<stereo_frame_type>("stereo_frame")}
 		//, glfw_context{pb->lookup_impl<global_config>()->glfw_context}
 	{}
 
-	void imu_cam_handler(switchboard::ptr<const imu_cam_type> datum) {
-		if (datum != nullptr && datum->img0.has_value() && datum->img1.has_value()) {
-			last_datum_with_images = datum;
-        }
-	}
-
 	void draw_GUI() {
         RAC_ERRNO_MSG("debugview at start of draw_GUI");
 
@@ -259,13 +254,15 @@ public:
 	bool load_camera_images() {
         RAC_ERRNO_MSG("debugview at start of load_camera_images");
 
-		if (last_datum_with_images == nullptr) {
+		// stereo_frame only carries frames, so the latest event always has both images.
+		switchboard::ptr<const stereo_frame_type> frame = _m_stereo_frame.get_ro_nullable();
+		if (frame == nullptr) {
 			return false;
 		}
 
-		if (last_datum_with_images->img0.has_value()) {
+		if (!frame->img0.empty()) {
 			glBindTexture(GL_TEXTURE_2D, camera_textures[0]);
-			cv::Mat img0{last_datum_with_images->img0.value().clone()};
+			cv::Mat img0{frame->img0.clone()};
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, img0.cols, img0.rows, 0, GL_RED, GL_UNSIGNED_BYTE, img0.ptr());
 			camera_texture_sizes[0] = Eigen::Vector2i(img0.cols, img0.rows);
 			GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_RED};
@@ -278,9 +275,9 @@ public:
 			camera_texture_sizes[0] = Eigen::Vector2i(TEST_PATTERN_WIDTH, TEST_PATTERN_HEIGHT);
 		}
 		
-		if (last_datum_with_images->img1.has_value()) {
+		if (!frame->img1.empty()) {
 			glBindTexture(GL_TEXTURE_2D, camera_textures[1]);
-			cv::Mat img1{last_datum_with_images->img1.value().clone()};    /// <- Adding this here to simulate the copy
+			cv::Mat img1{frame->img1.clone()};    /// <- Adding this here to simulate the copy
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, img1.cols, img1.rows, 0, GL_RED, GL_UNSIGNED_BYTE, img1.ptr());
 			camera_texture_sizes[1] = Eigen::Vector2i(img1.cols, img1.rows);
 			GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_RED};
@@ -431,6 +428,7 @@ private:
 
 	switchboard::reader<pose_type> _m_slow_pose;
     switchboard::reader<imu_raw_type> _m_fast_pose;
+    switchboard::reader<stereo_frame_type> _m_stereo_frame;
 	GLFWwindow* gui_window;
 
 	uint8_t test_pattern[TEST_PATTERN_WIDTH][TEST_PATTERN_HEIGHT];
@@ -448,7 +446,6 @@ private:
 
 	Eigen::Vector3f tracking_position_offset = Eigen::Vector3f{0.0f, 0.0f, 0.0f};
 
-	switchboard::ptr<const imu_cam_type> last_datum_with_images;
 	// std::vector<std::optional<cv::Mat>> camera_data = {std::nullopt, std::nullopt};
 	GLuint camera_textures[2];
 	Eigen::Vector2i camera_texture_sizes[2] = {Eigen::Vector2i::Zero(), Eigen::Vector2i::Zero()};
@@ -475,14 +472,6 @@ public:
 	virtual void start() override {
         RAC_ERRNO_MSG("debugview at the top of start()");
 
-		// The "imu_cam" topic is not really a topic, in the current implementation.
-		// It serves more as an event stream. Camera frames are only available on this topic
-		// the very split second they are made available. Subsequently published packets to this
-		// topic do not contain the camera frames.
-   		sb->schedule<imu_cam_type>(id, "imu_cam", [&](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
-        	this->imu_cam_handler(datum);
-    	});
-
         if (!glfwInit()) {
             ILLIXR::abort("[debugview] Failed to initalize glfw");
         }
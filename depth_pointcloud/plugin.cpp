@@ -0,0 +1,213 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <opencv2/core.hpp>
+#include "common/plugin.hpp"
+#include "common/switchboard.hpp"
+#include "common/data_format.hpp"
+#include "common/frame_pool.hpp"
+#include "common/global_module_defs.hpp"
+
+using namespace ILLIXR;
+
+const record_header depth_pointcloud_record {
+	"depth_pointcloud",
+	{
+		{"timestamp", typeid(std::size_t)},
+		{"organize", typeid(std::chrono::nanoseconds)},
+		{"voxelize", typeid(std::chrono::nanoseconds)},
+		{"voxels", typeid(std::size_t)},
+	},
+};
+
+/**
+ * @brief Turns raw depth from `rgb_depth` into an organized point cloud and a voxel-downsampled cloud.
+ *
+ * The sensor plugins publish depth in their own units; the conversion to meters happens here, off
+ * their callback threads. Back-projection is a handful of whole-image OpenCV primitives (convertTo,
+ * multiply, merge, inRange, setTo), which all have vectorized (HAL/universal-intrinsic) implementations;
+ * the per-pixel ray directions are precomputed whenever the image size or intrinsics change.
+ *
+ * A cloud is only computed if some plugin consumes its topic.
+ */
+class depth_pointcloud : public plugin {
+public:
+	depth_pointcloud(std::string name_, phonebook* pb_)
+		: plugin{name_, pb_}
+		, sb{pb->lookup_impl<switchboard>()}
+		, _m_frame_pool{pb->lookup_impl<frame_pool>()}
+		, _m_organized_cloud{sb->get_writer<organized_cloud_type>("organized_cloud")}
+		, _m_voxel_cloud{sb->get_writer<voxel_cloud_type>("voxel_cloud")}
+		, _m_voxel_size{std::stof(ILLIXR::getenv_or("ILLIXR_POINTCLOUD_VOXEL_SIZE", "0.05"))}
+		, _m_max_range{std::stof(ILLIXR::getenv_or("ILLIXR_POINTCLOUD_MAX_RANGE", "10.0"))}
+		, _m_log{record_logger_}
+	{ }
+
+	virtual void start() override {
+		plugin::start();
+		sb->schedule<rgb_depth_type>(id, "rgb_depth", [this](switchboard::ptr<const rgb_depth_type> datum, std::size_t) {
+			this->process(datum);
+		});
+	}
+
+private:
+	void process(switchboard::ptr<const rgb_depth_type> datum) {
+		const bool want_organized = _m_organized_cloud.has_consumers();
+		const bool want_voxels = _m_voxel_cloud.has_consumers();
+		if (!datum->depth || datum->depth->empty() || !(want_organized || want_voxels)) {
+			return;
+		}
+		const cv::Mat& depth = *datum->depth;
+		if (depth.type() != CV_16UC1 && depth.type() != CV_32FC1) {
+			if (!_m_warned_type) {
+				std::cerr << "depth_pointcloud: depth must be CV_16UC1 or CV_32FC1; skipping" << std::endl;
+				_m_warned_type = true;
+			}
+			return;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		cv::Mat points = organize(depth, datum->depth_scale, datum->intrinsics);
+		auto organized = std::chrono::high_resolution_clock::now();
+
+		std::vector<Eigen::Vector3f> voxels;
+		if (want_voxels) {
+			voxels = voxelize(points);
+		}
+		auto done = std::chrono::high_resolution_clock::now();
+
+		_m_log.log(record{depth_pointcloud_record, {
+			{std::size_t(datum->timestamp)},
+			{std::chrono::duration_cast<std::chrono::nanoseconds>(organized - start)},
+			{std::chrono::duration_cast<std::chrono::nanoseconds>(done - organized)},
+			{voxels.size()},
+		}});
+
+		if (want_organized) {
+			_m_organized_cloud.put(_m_organized_cloud.allocate<organized_cloud_type>(
+				organized_cloud_type {
+					datum->timestamp,
+					std::move(points),
+				}
+			));
+		}
+		if (want_voxels) {
+			_m_voxel_cloud.put(_m_voxel_cloud.allocate<voxel_cloud_type>(
+				voxel_cloud_type {
+					datum->timestamp,
+					_m_voxel_size,
+					std::move(voxels),
+				}
+			));
+		}
+	}
+
+	/// Back-project every pixel: (x, y, z) = ((u - cx) / fx * z, (v - cy) / fy * z, z), NaN where there is no depth.
+	cv::Mat organize(const cv::Mat& depth, float depth_scale, const depth_intrinsics& intrinsics) {
+		update_rays(depth.size(), intrinsics);
+
+		depth.convertTo(_m_z, CV_32F, depth_scale);
+		cv::multiply(_m_x_over_z, _m_z, _m_x);
+		cv::multiply(_m_y_over_z, _m_z, _m_y);
+
+		// NaN fails both comparisons, so it counts as invalid too
+		cv::inRange(_m_z, std::numeric_limits<float>::min(), _m_max_range, _m_valid);
+		cv::bitwise_not(_m_valid, _m_invalid);
+
+		// The published cloud gets a fresh pooled buffer; consumers may still hold the previous one.
+		cv::Mat points = _m_frame_pool->empty();
+		const cv::Mat channels[] = {_m_x, _m_y, _m_z};
+		cv::merge(channels, 3, points);
+		points.setTo(cv::Scalar::all(std::numeric_limits<float>::quiet_NaN()), _m_invalid);
+		return points;
+	}
+
+	/// The centroid of the points in each occupied voxel.
+	std::vector<Eigen::Vector3f> voxelize(const cv::Mat& points) {
+		const float inverse_size = 1.f / _m_voxel_size;
+		_m_voxels.clear();
+		for (int v = 0; v < points.rows; ++v) {
+			const cv::Vec3f* row = points.ptr<cv::Vec3f>(v);
+			const uchar* valid = _m_valid.ptr<uchar>(v);
+			for (int u = 0; u < points.cols; ++u) {
+				if (!valid[u]) {
+					continue;
+				}
+				const Eigen::Vector3f point {row[u][0], row[u][1], row[u][2]};
+				voxel& cell = _m_voxels[voxel_key(point * inverse_size)];
+				cell.sum += point;
+				++cell.count;
+			}
+		}
+
+		std::vector<Eigen::Vector3f> centroids;
+		centroids.reserve(_m_voxels.size());
+		for (const auto& entry : _m_voxels) {
+			centroids.push_back(entry.second.sum / float(entry.second.count));
+		}
+		return centroids;
+	}
+
+	/// Pack the voxel's integer coordinates into 21 bits each (±1M voxels per axis).
+	static std::uint64_t voxel_key(const Eigen::Vector3f& scaled) {
+		constexpr std::int64_t offset = 1 << 20;
+		constexpr std::uint64_t mask = (1 << 21) - 1;
+		const std::uint64_t x = std::uint64_t(std::int64_t(std::floor(scaled.x())) + offset) & mask;
+		const std::uint64_t y = std::uint64_t(std::int64_t(std::floor(scaled.y())) + offset) & mask;
+		const std::uint64_t z = std::uint64_t(std::int64_t(std::floor(scaled.z())) + offset) & mask;
+		return (x << 42) | (y << 21) | z;
+	}
+
+	void update_rays(cv::Size size, const depth_intrinsics& intrinsics) {
+		if (size == _m_x_over_z.size()
+			&& intrinsics.fx == _m_intrinsics.fx && intrinsics.fy == _m_intrinsics.fy
+			&& intrinsics.cx == _m_intrinsics.cx && intrinsics.cy == _m_intrinsics.cy) {
+			return;
+		}
+		_m_intrinsics = intrinsics;
+		_m_x_over_z.create(size, CV_32FC1);
+		_m_y_over_z.create(size, CV_32FC1);
+		for (int v = 0; v < size.height; ++v) {
+			float* x_row = _m_x_over_z.ptr<float>(v);
+			float* y_row = _m_y_over_z.ptr<float>(v);
+			const float y = (float(v) - intrinsics.cy) / intrinsics.fy;
+			for (int u = 0; u < size.width; ++u) {
+				x_row[u] = (float(u) - intrinsics.cx) / intrinsics.fx;
+				y_row[u] = y;
+			}
+		}
+	}
+
+	struct voxel {
+		Eigen::Vector3f sum {Eigen::Vector3f::Zero()};
+		std::uint32_t count {0};
+	};
+
+	const std::shared_ptr<switchboard> sb;
+	const std::shared_ptr<frame_pool> _m_frame_pool;
+	switchboard::writer<organized_cloud_type> _m_organized_cloud;
+	switchboard::writer<voxel_cloud_type> _m_voxel_cloud;
+	const float _m_voxel_size;
+	const float _m_max_range;
+
+	// Per-pixel ray directions, for the current image size and intrinsics
+	depth_intrinsics _m_intrinsics {0, 0, 0, 0};
+	cv::Mat _m_x_over_z;
+	cv::Mat _m_y_over_z;
+
+	// Scratch images, reused across frames (they are never published)
+	cv::Mat _m_z;
+	cv::Mat _m_x;
+	cv::Mat _m_y;
+	cv::Mat _m_valid;
+	cv::Mat _m_invalid;
+	// Keeps its buckets across frames
+	std::unordered_map<std::uint64_t, voxel> _m_voxels;
+
+	bool _m_warned_type {false};
+	record_coalescer _m_log;
+};
+
+PLUGIN_MAIN(depth_pointcloud);
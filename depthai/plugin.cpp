@@ -11,6 +11,8 @@
 #include "common/threadloop.hpp"
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
+#include "common/sensor_publisher.hpp"
+#include "common/frame_pool.hpp"
 
 using namespace ILLIXR;
 
@@ -19,10 +21,12 @@ public:
     depthai(std::string name_, phonebook* pb_)
         : plugin{name_, pb_}
         , sb{pb->lookup_impl<switchboard>()}
-        , _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
+        , _m_frame_pool{pb->lookup_impl<frame_pool>()}
+        , _m_publisher{sb, "depthai"}
         , _m_rgb_depth{sb->get_writer<rgb_depth_type>("rgb_depth")}
         //Initialize DepthAI pipeline and device 
         , device{createCameraPipeline()}
+        , _m_depth_intrinsics{readDepthIntrinsics()}
         { 
             #ifndef NDEBUG
                 std::cout << "Depthai pipeline started" << std::endl;
@@ -76,23 +80,24 @@ public:
             auto rectifL = rectifLeftQueue->tryGet<dai::ImgFrame>();
             auto rectifR = rectifRightQueue->tryGet<dai::ImgFrame>();
 
-            cv::Mat color = cv::Mat(colorFrame->getHeight(), colorFrame->getWidth(), CV_8UC3, colorFrame->getData().data());
-            cv::Mat rgb_out{color.clone()};
+            // The color frame is published as-is, so it is shared with the device frame (kept alive by the Mat).
+            cv::Mat rgb_out = _m_frame_pool->wrap(colorFrame->getHeight(), colorFrame->getWidth(), CV_8UC3, colorFrame->getData().data(), 0, colorFrame);
+
+            // The flips write straight into pooled buffers; no intermediate clone.
             cv::Mat rectifiedLeftFrame = cv::Mat(rectifL->getHeight(), rectifL->getWidth(), CV_8UC1, rectifL->getData().data());
-            cv::Mat LeftOut{rectifiedLeftFrame.clone()};
-            cv::flip(LeftOut, LeftOut, 1);
+            cv::Mat LeftOut = _m_frame_pool->empty();
+            cv::flip(rectifiedLeftFrame, LeftOut, 1);
             cv::Mat rectifiedRightFrame = cv::Mat(rectifR->getHeight(), rectifR->getWidth(), CV_8UC1, rectifR->getData().data());
-            cv::Mat RightOut{rectifiedRightFrame.clone()};
-            cv::flip(RightOut, RightOut, 1);
+            cv::Mat RightOut = _m_frame_pool->empty();
+            cv::flip(rectifiedRightFrame, RightOut, 1);
 
-            cv::Mat depth = cv::Mat(depthFrame->getHeight(), depthFrame->getWidth(), CV_16UC1, depthFrame->getData().data());
-            cv::Mat converted_depth;
-            depth.convertTo(converted_depth, CV_32FC1, 1000.f);
+            // Depth is published as-is (16-bit millimeters); the depth_pointcloud plugin converts it off this callback thread.
+            cv::Mat raw_depth = _m_frame_pool->wrap(depthFrame->getHeight(), depthFrame->getWidth(), CV_16UC1, depthFrame->getData().data(), 0, depthFrame);
         
             img0 = LeftOut;
             img1 = RightOut;
             rgb = rgb_out;
-            depth = converted_depth;
+            depth = raw_depth;
         }
         
         std::chrono::time_point<std::chrono::steady_clock, std::chrono::steady_clock::duration> gyroTs;
@@ -131,16 +136,15 @@ public:
             #ifndef NDEBUG
                 imu_pub++;
             #endif
-            _m_imu_cam.put(_m_imu_cam.allocate<imu_cam_type>(
-                {
-                    imu_time_point,
-                    av,
-                    la,
-                    img0,
-                    img1,
-                    imu_time
-                }
-            ));
+            // RGB-D images go in the same frame set, as the "rgb" and "depth" cameras
+            std::vector<camera_image> rgbd;
+            if (rgb) {
+                rgbd.push_back(_m_publisher.image("rgb", image_plane::color, imu_time_point, imu_time, *rgb));
+            }
+            if (depth) {
+                rgbd.push_back(_m_publisher.depth_image("depth", imu_time_point, imu_time, *depth, depth_scale));
+            }
+            _m_publisher.put(imu_time_point, av, la, img0, img1, imu_time, std::move(rgbd));
             
             if (rgb && depth)
             {
@@ -151,7 +155,9 @@ public:
                     {
                         rgb,
                         depth,
-                        imu_time
+                        imu_time,
+                        depth_scale,
+                        _m_depth_intrinsics
                     }
                 ));
             }
@@ -171,7 +177,8 @@ public:
 
 private:
     const std::shared_ptr<switchboard> sb;
-    switchboard::writer<imu_cam_type> _m_imu_cam;
+    const std::shared_ptr<frame_pool> _m_frame_pool;
+    sensor_publisher _m_publisher;
 	switchboard::writer<rgb_depth_type> _m_rgb_depth;
     std::mutex mutex;
 
@@ -189,6 +196,11 @@ private:
     std::chrono::time_point<std::chrono::steady_clock, std::chrono::steady_clock::duration> test_time_point;
     bool useRaw = false;
     dai::Device device;
+    // Depth is aligned to the right mono camera, at its resolution
+    static constexpr int depth_width = 640;
+    static constexpr int depth_height = 400;
+    static constexpr float depth_scale = 0.001f; // millimeters
+    const depth_intrinsics _m_depth_intrinsics;
 
     std::shared_ptr<dai::DataOutputQueue> colorQueue;
     std::shared_ptr<dai::DataOutputQueue> depthQueue;
@@ -197,6 +209,11 @@ private:
     std::shared_ptr<dai::DataOutputQueue> imuQueue;
 
 
+    depth_intrinsics readDepthIntrinsics() {
+        std::vector<std::vector<float>> k = device.readCalibration().getCameraIntrinsics(dai::CameraBoardSocket::RIGHT, depth_width, depth_height);
+        return depth_intrinsics{k[0][0], k[1][1], k[0][2], k[1][2]};
+    }
+
     dai::Pipeline createCameraPipeline() {
         #ifndef NDEBUG
             std::cout << "Depthai creating pipeline" << std::endl;
@@ -5,7 +5,7 @@
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
 #include "common/threadloop.hpp"
-#include "data_loading.hpp"
+#include "common/dataset.hpp"
 
 using namespace ILLIXR;
 
@@ -16,18 +16,19 @@ public:
 		, sb{pb->lookup_impl<switchboard>()}
 		, _m_true_pose{sb->get_writer<pose_type>("true_pose")}
 		, _m_ground_truth_offset{sb->get_writer<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
-		, _m_sensor_data{load_data()}
+		, _m_dataset{pb->lookup_impl<dataset>()}
+		, _m_sensor_data{_m_dataset->ground_truth(0)}
 		, _m_first_time{true}
 	{ }
 
 	virtual void start() override {
 		plugin::start();
-		sb->schedule<imu_cam_type>(id, "imu_cam", [this](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
+		sb->schedule<imu_sample>(id, "imu", [this](switchboard::ptr<const imu_sample> datum, std::size_t) {
 			this->feed_ground_truth(datum);
 		});
 	}
 
-	void feed_ground_truth(switchboard::ptr<const imu_cam_type> datum) {
+	void feed_ground_truth(switchboard::ptr<const imu_sample> datum) {
 		ullong rounded_time = datum->dataset_time;
 		auto it = _m_sensor_data.find(rounded_time);
 
@@ -41,8 +42,8 @@ public:
         switchboard::ptr<pose_type> true_pose = _m_true_pose.allocate<pose_type>(
             pose_type {
                 time_type{datum->time},
-                it->second.position,
-                it->second.orientation
+                it->value.position,
+                it->value.orientation
             }
         );
 
@@ -77,7 +78,8 @@ private:
 	const std::shared_ptr<switchboard> sb;
 	switchboard::writer<pose_type> _m_true_pose;
     switchboard::writer<switchboard::event_wrapper<Eigen::Vector3f>> _m_ground_truth_offset;
-	const std::map<ullong, sensor_types> _m_sensor_data;
+	const std::shared_ptr<const dataset> _m_dataset;
+	const timed_stream<pose_type>& _m_sensor_data;
     bool _m_first_time;
 };
 
@@ -0,0 +1,209 @@
+/*
+ * Per-sample latency of gtsam_integrator's propagation, on a synthetic IMU stream.
+ *
+ * Each IMU sample is propagated the way plugin.cpp does it, with a new slow pose (imu_integrator_input)
+ * every few samples. Compared:
+ * - reintegrate: the previous implementation, which integrates the whole window again for every sample
+ * - incremental: the checkpointed preintegration
+ * - incremental fast: the same, without covariance (ILLIXR_GTSAM_FAST_PREINTEGRATION)
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/imu_buffer.hpp"
+#include "pim_object.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	constexpr double imu_rate = 200.;
+	constexpr double cam_rate = 15.;
+	// How far the slow pose lags the newest IMU sample
+	constexpr double vio_latency = 0.1;
+	constexpr double duration = 60.;
+	constexpr double imu_ttl = 5.;
+
+	imu_params make_params() {
+		// EuRoC-like noise values
+		return imu_params{
+			0.00016968,                                      // gyro_noise
+			0.002,                                           // acc_noise
+			1.9393e-05,                                      // gyro_walk
+			0.003,                                           // acc_walk
+			Eigen::Matrix<double,3,1>(0.0, 0.0, -9.81),      // n_gravity
+			1.0,                                             // imu_integration_sigma
+			imu_rate,                                        // nominal_rate
+		};
+	}
+
+	std::vector<imu_reading> make_stream() {
+		std::mt19937 rng {0};
+		std::normal_distribution<double> noise {0., 0.01};
+		std::vector<imu_reading> stream;
+		for (double t = 0; t < duration; t += 1. / imu_rate) {
+			const Eigen::Vector3d wm {0.3 * std::sin(t), 0.2 * std::cos(0.7 * t), 0.1 * std::sin(1.3 * t)};
+			const Eigen::Vector3d am {0.5 * std::cos(t), 0.4 * std::sin(0.5 * t), 9.81 + 0.2 * std::sin(2. * t)};
+			stream.push_back(imu_reading{t, wm + Eigen::Vector3d::Constant(noise(rng)), am + Eigen::Vector3d::Constant(noise(rng))});
+		}
+		return stream;
+	}
+
+	std::shared_ptr<const imu_integrator_input> make_input(double last_cam_integration_time) {
+		return std::make_shared<const imu_integrator_input>(
+			last_cam_integration_time,
+			0.,
+			make_params(),
+			Eigen::Vector3d{0.01, -0.02, 0.03},
+			Eigen::Vector3d{0.001, 0.002, -0.001},
+			Eigen::Vector3d::Zero(),
+			Eigen::Vector3d::Zero(),
+			Eigen::Quaterniond::Identity()
+		);
+	}
+
+	struct result {
+		std::vector<double> latencies_us;
+		std::vector<gtsam::Pose3> poses;
+	};
+
+	// The previous implementation: reset, and integrate the selected window from the start
+	struct reintegrate {
+		explicit reintegrate(const imu_integrator_input& input)
+			: pim{input}
+		{ }
+
+		void set_input(const imu_integrator_input& input) {
+			pim.resetIntegrationAndSetBias(input);
+		}
+
+		bool propagate(imu_buffer& buffer, double time_begin, double time_end) {
+			pim.resetIntegration();
+			const std::vector<imu_reading>& prop_data = buffer.select(time_begin, time_end);
+			if (prop_data.size() < 2) {
+				return false;
+			}
+			for (std::size_t i = 0; i + 1 < prop_data.size(); i++) {
+				pim.integrateMeasurement(prop_data[i], prop_data[i + 1]);
+			}
+			// Predicts from the tail, so the checkpoint is copied over (which the old code did not do)
+			pim.beginTail();
+			return true;
+		}
+
+		PimObject pim;
+	};
+
+	// The checkpointed preintegration, as in plugin.cpp
+	struct incremental {
+		incremental(const imu_integrator_input& input, bool fast)
+			: pim{input, fast}
+		{ }
+
+		void set_input(const imu_integrator_input& input) {
+			pim.resetIntegrationAndSetBias(input);
+			started = false;
+		}
+
+		bool propagate(imu_buffer& buffer, double time_begin, double time_end) {
+			if (!started) {
+				window.reset(time_begin);
+				started = true;
+			}
+			window.advance(buffer, time_end,
+				[this]() { pim.resetIntegration(); },
+				[this](const imu_reading& from, const imu_reading& to) { pim.integrateMeasurement(from, to); }
+			);
+			pim.beginTail();
+			const std::size_t tail = window.finish([this](const imu_reading& from, const imu_reading& to) {
+				pim.integrateTailMeasurement(from, to);
+			});
+			return window.committed() + tail > 0;
+		}
+
+		PimObject pim;
+		imu_window_tracker window;
+		bool started {false};
+	};
+
+	template <typename Propagator, typename... Args>
+	result run(const std::vector<imu_reading>& stream, Args&&... args) {
+		result out;
+		out.latencies_us.reserve(stream.size());
+		out.poses.reserve(stream.size());
+
+		imu_buffer buffer;
+		std::shared_ptr<const imu_integrator_input> input = make_input(0.);
+		Propagator propagator {*input, std::forward<Args>(args)...};
+		double next_cam = 1. / cam_rate;
+
+		for (const imu_reading& reading : stream) {
+			if (reading.timestamp >= next_cam) {
+				input = make_input(std::max(0., reading.timestamp - vio_latency));
+				propagator.set_input(*input);
+				next_cam += 1. / cam_rate;
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			buffer.push(reading);
+			buffer.expire_before(reading.timestamp - imu_ttl);
+			const bool propagated = propagator.propagate(buffer, input->last_cam_integration_time + input->t_offset, input->t_offset + reading.timestamp);
+			const gtsam::Pose3 pose = propagated ? propagator.pim.predict().pose() : gtsam::Pose3{};
+			const auto stop = std::chrono::steady_clock::now();
+
+			out.latencies_us.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+			out.poses.push_back(pose);
+		}
+		return out;
+	}
+
+	double percentile(std::vector<double> values, double p) {
+		const std::size_t index = std::min(values.size() - 1, std::size_t(p * double(values.size())));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	void report(const char* name, const result& r, const result& reference) {
+		double mean = 0;
+		for (double latency : r.latencies_us) {
+			mean += latency;
+		}
+		mean /= double(r.latencies_us.size());
+
+		double max_error = 0;
+		for (std::size_t i = 0; i < r.poses.size(); i++) {
+			max_error = std::max(max_error, (r.poses[i].translation() - reference.poses[i].translation()).norm());
+		}
+
+		std::printf("%-18s %10.2f %10.2f %10.2f %10.2f %14.3g\n", name,
+			mean,
+			percentile(r.latencies_us, 0.5),
+			percentile(r.latencies_us, 0.99),
+			*std::max_element(r.latencies_us.begin(), r.latencies_us.end()),
+			max_error);
+	}
+
+}
+
+int main() {
+	const std::vector<imu_reading> stream = make_stream();
+	std::printf("%zu samples at %.0f Hz, slow pose at %.0f Hz lagging %.0f ms\n\n",
+		stream.size(), imu_rate, cam_rate, vio_latency * 1000.);
+
+	const result old = run<reintegrate>(stream);
+	const result checkpointed = run<incremental>(stream, false);
+	const result fast = run<incremental>(stream, true);
+
+	std::printf("%-18s %10s %10s %10s %10s %14s\n", "", "mean (us)", "p50 (us)", "p99 (us)", "max (us)", "max dpos (m)");
+	report("reintegrate", old, old);
+	report("incremental", checkpointed, old);
+	report("incremental fast", fast, old);
+	return 0;
+}
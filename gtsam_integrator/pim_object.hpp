@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <eigen3/Eigen/Dense>
+
+#include "common/data_format.hpp"
+#include "common/imu_buffer.hpp"
+
+#include <gtsam/base/Matrix.h>
+#include <gtsam/base/Vector.h>
+#include <gtsam/navigation/CombinedImuFactor.h>
+#include <gtsam/navigation/ImuBias.h>
+#include <gtsam/navigation/ImuFactor.h>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/smart_ptr/make_shared.hpp>
+
+namespace ILLIXR {
+
+    using ImuBias = gtsam::imuBias::ConstantBias;
+
+    /**
+     * @brief Wrapper object protecting the lifetime of IMU integration inputs and biases
+     *
+     * The preintegrated measurements persist between IMU samples as a checkpoint,
+     * which is extended by the window's committed steps (see `imu_window_tracker`) and only reset for a new input.
+     * The steps to the end of the window are integrated into a copy of the checkpoint (the "tail"),
+     * which is what `predict` uses.
+     *
+     * With `fast`, gtsam's covariance-free preintegration is used: `imu_raw` never reads the covariance,
+     * and propagating the combined 15x15 covariance is most of the cost of each step.
+     */
+    class PimObject
+    {
+    public:
+        using imu_int_t  = ILLIXR::imu_integrator_input;
+        using imu_t      = imu_reading;
+        using bias_t     = ImuBias;
+        using nav_t      = gtsam::NavState;
+        using pim_t      = gtsam::PreintegratedCombinedMeasurements;
+        // Preintegration without covariance: PreintegrationBase::integrateMeasurement only updates the deltas
+        using fast_pim_t = gtsam::PreintegrationType;
+        using pim_ptr_t  = gtsam::PreintegrationType*;
+
+        PimObject(const imu_int_t& imu_int_input, bool fast = false)
+            : _imu_bias{imu_int_input.biasAcc, imu_int_input.biasGyro}
+            , _fast{fast}
+            , _pim{nullptr}
+            , _pim_tail{nullptr}
+        {
+            pim_t::Params _params{imu_int_input.params.n_gravity};
+            _params.setGyroscopeCovariance(std::pow(imu_int_input.params.gyro_noise, 2.0) * Eigen::Matrix3d::Identity());
+            _params.setAccelerometerCovariance(std::pow(imu_int_input.params.acc_noise, 2.0) * Eigen::Matrix3d::Identity());
+            _params.setIntegrationCovariance(std::pow(imu_int_input.params.imu_integration_sigma, 2.0) * Eigen::Matrix3d::Identity());
+            _params.setBiasAccCovariance(std::pow(imu_int_input.params.acc_walk, 2.0) * Eigen::Matrix3d::Identity());
+            _params.setBiasOmegaCovariance(std::pow(imu_int_input.params.gyro_walk, 2.0) * Eigen::Matrix3d::Identity());
+
+            const auto params = boost::make_shared<pim_t::Params>(std::move(_params));
+            if (_fast) {
+                _pim = new fast_pim_t{params, _imu_bias};
+                _pim_tail = new fast_pim_t{params, _imu_bias};
+            } else {
+                _pim = new pim_t{params, _imu_bias};
+                _pim_tail = new pim_t{params, _imu_bias};
+            }
+            resetIntegrationAndSetBias(imu_int_input);
+        }
+
+        ~PimObject()
+        {
+            assert(_pim != nullptr && "_pim should not be null");
+            assert(_pim_tail != nullptr && "_pim_tail should not be null");
+
+            /// Note: Deliberately leak _pim and _pim_tail => Removes SEGV read during destruction
+            /// delete _pim;
+            /// The plugin makes one PimObject and keeps it until shutdown (later inputs reset it in place),
+            /// so this is two allocations per run, not per input. Deleting them at shutdown is what segfaulted,
+            /// so both must outlive this object.
+        };
+
+        void resetIntegrationAndSetBias(const imu_int_t& imu_int_input) noexcept
+        {
+            assert(_pim != nullptr && "_pim should not be null");
+
+            _imu_bias = bias_t{imu_int_input.biasAcc, imu_int_input.biasGyro};
+            _pim->resetIntegrationAndSetBias(_imu_bias);
+
+            _navstate_lkf = nav_t {
+                gtsam::Pose3{gtsam::Rot3{imu_int_input.quat}, imu_int_input.position},
+                imu_int_input.velocity
+            };
+        }
+
+        /// Go back to the start of the window, keeping the input's state and bias
+        void resetIntegration() noexcept
+        {
+            assert(_pim != nullptr && "_pim should not be null");
+            _pim->resetIntegrationAndSetBias(_imu_bias);
+        }
+
+        /// Extend the checkpoint by one committed step
+        void integrateMeasurement(const imu_t& imu_input, const imu_t& imu_input_next) noexcept
+        {
+            assert(_pim != nullptr && "_pim shuold not be null");
+            integrate(_pim, imu_input, imu_input_next);
+        }
+
+        /// Start the tail over from the checkpoint
+        void beginTail() noexcept
+        {
+            assert(_pim != nullptr && _pim_tail != nullptr && "_pim and _pim_tail should not be null");
+            if (_fast) {
+                *static_cast<fast_pim_t*>(_pim_tail) = *static_cast<const fast_pim_t*>(_pim);
+            } else {
+                *static_cast<pim_t*>(_pim_tail) = *static_cast<const pim_t*>(_pim);
+            }
+        }
+
+        void integrateTailMeasurement(const imu_t& imu_input, const imu_t& imu_input_next) noexcept
+        {
+            assert(_pim_tail != nullptr && "_pim_tail should not be null");
+            integrate(_pim_tail, imu_input, imu_input_next);
+        }
+
+        bias_t biasHat() const noexcept
+        {
+            assert(_pim_tail != nullptr && "_pim_tail shuold not be null");
+            return _pim_tail->biasHat();
+        }
+
+        /// The state at the end of the tail
+        nav_t predict() const noexcept
+        {
+            assert(_pim_tail != nullptr && "_pim_tail should not be null");
+            return _pim_tail->predict(_navstate_lkf, _imu_bias);
+        }
+
+    private:
+        static void integrate(pim_ptr_t pim, const imu_t& imu_input, const imu_t& imu_input_next) noexcept
+        {
+            const gtsam::Vector3 measured_acc{imu_input.am};
+            const gtsam::Vector3 measured_omega{imu_input.wm};
+
+            /// Delta T should be in seconds
+            const double delta_t = imu_input_next.timestamp - imu_input.timestamp;
+
+            /// Virtual: the combined PIM also propagates its covariance, the fast one does not
+            pim->integrateMeasurement(measured_acc, measured_omega, delta_t);
+        }
+
+        bias_t _imu_bias;
+        nav_t _navstate_lkf;
+        const bool _fast;
+        pim_ptr_t _pim;
+        pim_ptr_t _pim_tail;
+    };
+
+}
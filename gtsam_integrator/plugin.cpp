@@ -1,179 +1,156 @@
 #include <chrono>
 #include <iomanip>
+#include <mutex>
 #include <thread>
 #include <eigen3/Eigen/Dense>
 
 #include "common/plugin.hpp"
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
+#include "common/compact_format.hpp"
 #include "common/plugin.hpp"
+#include "common/global_module_defs.hpp"
+#include "common/imu_buffer.hpp"
+#include "common/lazy_imu_integrator.hpp"
+#include "pim_object.hpp"
 
-#include <gtsam/base/Matrix.h>
-#include <gtsam/base/Vector.h>
 #include <gtsam/navigation/AHRSFactor.h>
-#include <gtsam/navigation/CombinedImuFactor.h>  // Used if IMU combined is off.
-#include <gtsam/navigation/ImuBias.h>
-#include <gtsam/navigation/ImuFactor.h>
-#include <boost/smart_ptr/shared_ptr.hpp>
-#include <boost/smart_ptr/make_shared.hpp>
 
 // IMU sample time to live in seconds
 #define IMU_TTL 5
 
-using ImuBias = gtsam::imuBias::ConstantBias;
 using namespace ILLIXR;
 
-typedef struct {
-    double timestamp;
-    Eigen::Matrix<double, 3, 1> wm;
-    Eigen::Matrix<double, 3, 1> am;
-} imu_type;
-
 
 class imu_integrator : public plugin {
 public:
     imu_integrator(std::string name_, phonebook* pb_)
         : plugin{name_, pb_}
         , sb{pb->lookup_impl<switchboard>()}
-        , _m_imu_cam{sb->get_reader<imu_cam_type>("imu_cam")}
         , _m_imu_integrator_input{sb->get_reader<imu_integrator_input>("imu_integrator_input")}
         , _m_imu_raw{sb->get_writer<imu_raw_type>("imu_raw")}
+        , _m_imu_raw_published{sb->get_reader<imu_raw_type>("imu_raw")}
+        , _m_imu_cam_ack{sb->get_writer<imu_cam_ack>("imu_cam_ack")}
+        , _m_lockstep{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_LOCKSTEP_ENABLE", "False"))}
+        , _m_imu_batch_size{std::max<std::size_t>(1, std::stoul(ILLIXR::getenv_or("ILLIXR_IMU_BATCH_SIZE", "1")))}
+        , _m_fast{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_GTSAM_FAST_PREINTEGRATION", "False"))}
     {
-        sb->schedule<imu_cam_type>(id, "imu_cam", [&](switchboard::ptr<const imu_cam_type> datum, size_t) {
-            callback(datum);
-        });
+        if (lazy_imu_integration_enabled()) {
+            _m_lazy = std::make_shared<lazy_imu_propagation>([this](double timestamp, time_type real_time) {
+                propagate_imu_values(timestamp, real_time);
+                return _m_imu_raw_published.get_ro_nullable();
+            });
+            pb_->register_impl<lazy_imu_integrator>(_m_lazy);
+        }
+
+        if (_m_imu_batch_size > 1) {
+            sb->schedule<imu_batch_type>(id, "imu_batch", [&](switchboard::ptr<const imu_batch_type> datum, size_t) {
+                callback(datum);
+            });
+        } else {
+            sb->schedule<imu_sample>(id, "imu", [&](switchboard::ptr<const imu_sample> datum, size_t) {
+                callback(datum);
+            });
+        }
     }
 
-    void callback(switchboard::ptr<const imu_cam_type> datum) {
-        double timestamp_in_seconds = (double(datum->dataset_time) / NANO_SEC);
+    virtual void start() override {
+        plugin::start();
+        if (_m_lockstep) {
+            // Announce this consumer to offline_imu_cam before the first sample
+            _m_imu_cam_ack.put(_m_imu_cam_ack.allocate<imu_cam_ack>(imu_cam_ack{id, 0}));
+        }
+    }
 
-        imu_type data;
-        data.timestamp = timestamp_in_seconds;
-        data.wm = (datum->angular_v).cast<double>();
-        data.am = (datum->linear_a).cast<double>();
-        _imu_vec.emplace_back(data);
+    void callback(switchboard::ptr<const imu_sample> datum) {
+        std::unique_lock<std::mutex> lock = lock_buffer();
+        push_imu(*datum);
+        integrate(*datum);
+    }
 
-        clean_imu_vec(timestamp_in_seconds);
-        propagate_imu_values(timestamp_in_seconds, datum->time);
+    // Buffer the whole batch, then propagate once to its last sample
+    void callback(switchboard::ptr<const imu_batch_type> datum) {
+        if (datum->samples.empty()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock = lock_buffer();
+        for (const imu_cam_compact& sample : datum->samples) {
+            push_imu(sample);
+        }
+        integrate(from_compact(datum->samples.back()));
+    }
+
+    void push_imu(const imu_sample& sample) {
+        imu_reading data;
+        data.timestamp = double(sample.dataset_time) / NANO_SEC;
+        data.wm = (sample.angular_v).cast<double>();
+        data.am = (sample.linear_a).cast<double>();
+        _m_imu_buffer.push(data);
+    }
+
+    void push_imu(const imu_cam_compact& sample) {
+        imu_reading data;
+        data.timestamp = mono_to_seconds(sample.dataset_time);
+        data.wm = sample.angular_v_vec().cast<double>();
+        data.am = sample.linear_a_vec().cast<double>();
+        _m_imu_buffer.push(data);
+    }
+
+    void integrate(const imu_sample& latest) {
+        double timestamp_in_seconds = (double(latest.dataset_time) / NANO_SEC);
+
+        // Remove IMU values older than 'IMU_TTL' from the imu buffer
+        _m_imu_buffer.expire_before(timestamp_in_seconds - IMU_TTL);
+        if (_m_lazy) {
+            // Propagated when pose_prediction asks for it
+            _m_lazy->sample_arrived(timestamp_in_seconds, latest.time);
+        } else {
+            propagate_imu_values(timestamp_in_seconds, latest.time);
+        }
+
+        if (_m_lockstep) {
+            _m_imu_cam_ack.put(_m_imu_cam_ack.allocate<imu_cam_ack>(imu_cam_ack{id, latest.dataset_time}));
+        }
 
         RAC_ERRNO_MSG("gtsam_integrator");
     }
 
+    // In lazy mode, propagate() reads the buffer from pose_prediction's thread
+    std::unique_lock<std::mutex> lock_buffer() {
+        return _m_lazy ? _m_lazy->lock() : std::unique_lock<std::mutex>{};
+    }
+
 private:
     const std::shared_ptr<switchboard> sb;
 
     // IMU Data, Sequence Flag, and State Vars Needed
-    switchboard::reader<imu_cam_type> _m_imu_cam;
     switchboard::reader<imu_integrator_input> _m_imu_integrator_input;
 
     // Write IMU Biases for PP
     switchboard::writer<imu_raw_type> _m_imu_raw;
+    // What propagate_imu_values last published, for lazy mode
+    switchboard::reader<imu_raw_type> _m_imu_raw_published;
+
+    // Acknowledgements for offline_imu_cam's lockstep replay
+    switchboard::writer<imu_cam_ack> _m_imu_cam_ack;
+    const bool _m_lockstep;
+    // Propagate once per imu_batch instead of once per sample
+    const std::size_t _m_imu_batch_size;
+    // Preintegrate without covariance (see PimObject)
+    const bool _m_fast;
 
-    std::vector<imu_type> _imu_vec;
+    imu_buffer _m_imu_buffer;
+    imu_window_tracker _m_window;
+    switchboard::ptr<const imu_integrator_input> _m_last_input;
 
     [[maybe_unused]] double last_cam_time = 0;
     double last_imu_offset = 0;
 
-    /**
-     * @brief Wrapper object protecting the lifetime of IMU integration inputs and biases
-     */
-    class PimObject
-    {
-    public:
-        using imu_int_t = ILLIXR::imu_integrator_input;
-        using imu_t     = imu_type;
-        using bias_t    = ImuBias;
-        using nav_t     = gtsam::NavState;
-        using pim_t     = gtsam::PreintegratedCombinedMeasurements;
-        using pim_ptr_t = gtsam::PreintegrationType*;
-
-        PimObject(const imu_int_t& imu_int_input)
-            : _imu_bias{imu_int_input.biasAcc, imu_int_input.biasGyro}
-            , _pim{nullptr}
-        {
-            pim_t::Params _params{imu_int_input.params.n_gravity};
-            _params.setGyroscopeCovariance(std::pow(imu_int_input.params.gyro_noise, 2.0) * Eigen::Matrix3d::Identity());
-            _params.setAccelerometerCovariance(std::pow(imu_int_input.params.acc_noise, 2.0) * Eigen::Matrix3d::Identity());
-            _params.setIntegrationCovariance(std::pow(imu_int_input.params.imu_integration_sigma, 2.0) * Eigen::Matrix3d::Identity());
-            _params.setBiasAccCovariance(std::pow(imu_int_input.params.acc_walk, 2.0) * Eigen::Matrix3d::Identity());
-            _params.setBiasOmegaCovariance(std::pow(imu_int_input.params.gyro_walk, 2.0) * Eigen::Matrix3d::Identity());
-
-            _pim = new pim_t {
-                boost::make_shared<pim_t::Params>(std::move(_params)),
-                _imu_bias
-            };
-            resetIntegrationAndSetBias(imu_int_input);
-        }
-
-        ~PimObject()
-        {
-            assert(_pim != nullptr && "_pim should not be null");
-
-            /// Note: Deliberately leak _pim => Removes SEGV read during destruction
-            /// delete _pim;
-        };
-
-        void resetIntegrationAndSetBias(const imu_int_t& imu_int_input) noexcept
-        {
-            assert(_pim != nullptr && "_pim should not be null");
-
-            _imu_bias = bias_t{imu_int_input.biasAcc, imu_int_input.biasGyro};
-            _pim->resetIntegrationAndSetBias(_imu_bias);
-
-            _navstate_lkf = nav_t {
-                gtsam::Pose3{gtsam::Rot3{imu_int_input.quat}, imu_int_input.position},
-                imu_int_input.velocity
-            };
-        }
-
-        void integrateMeasurement(const imu_t& imu_input, const imu_t& imu_input_next) noexcept
-        {
-            assert(_pim != nullptr && "_pim shuold not be null");
-
-            const gtsam::Vector3 measured_acc{imu_input.am};
-            const gtsam::Vector3 measured_omega{imu_input.wm};
-
-            /// Delta T should be in seconds
-            const double delta_t = imu_input_next.timestamp - imu_input.timestamp;
-
-            _pim->integrateMeasurement(measured_acc, measured_omega, delta_t);
-        }
-
-        bias_t biasHat() const noexcept
-        {
-            assert(_pim != nullptr && "_pim shuold not be null");
-            return _pim->biasHat();
-        }
-
-        nav_t predict() const noexcept
-        {
-            assert(_pim != nullptr && "_pim should not be null");
-            return _pim->predict(_navstate_lkf, _imu_bias);
-        }
-
-    private:
-        bias_t _imu_bias;
-        nav_t _navstate_lkf;
-        pim_ptr_t _pim;
-    };
-
     std::unique_ptr<PimObject> _pim_obj;
 
+    // Set with ILLIXR_LAZY_IMU_INTEGRATION: samples are only buffered, and pose_prediction drives propagation
+    std::shared_ptr<lazy_imu_propagation> _m_lazy;
 
-    // Remove IMU values older than 'IMU_TTL' from the imu buffer
-    void clean_imu_vec(const double& timestamp) {
-        auto imu_iterator = _imu_vec.begin();
-
-        // Since the vector is ordered oldest to latest, keep deleting until you
-        // hit a value less than 'IMU_TTL' seconds old
-        while (imu_iterator != _imu_vec.end()) {
-            if (timestamp - imu_iterator->timestamp < IMU_TTL) {
-                break;
-            }
-
-            imu_iterator = _imu_vec.erase(imu_iterator);
-        }
-    }
 
     // Timestamp we are propagating the biases to (new IMU reading time)
     void propagate_imu_values(const double& timestamp, const time_type& real_time) {
@@ -189,9 +166,11 @@ private:
         }
 #endif
 
-        if (_pim_obj == nullptr) {
+        if (input_values == _m_last_input) {
+            /// Same input as last time -> keep the preintegrated measurements, and only extend them below
+        } else if (_pim_obj == nullptr) {
             /// We don't have a PimObject -> make and set given the current input
-            _pim_obj = std::make_unique<PimObject>(*input_values);
+            _pim_obj = std::make_unique<PimObject>(*input_values, _m_fast);
 
             /// Setting 'last_imu_offset' here to stay consistent with previous integrator version.
             /// TODO: Should be set and tested at the end of this function to avoid staleness from VIO.
@@ -206,31 +185,37 @@ private:
         const double time_begin = input_values->last_cam_integration_time + last_imu_offset;
         const double time_end = input_values->t_offset + timestamp;
 
-        const std::vector<imu_type> prop_data = select_imu_readings(_imu_vec, time_begin, time_end);
+        if (input_values != _m_last_input) {
+            _m_last_input = input_values;
+            _m_window.reset(time_begin);
+        }
+
+        /// Extend the checkpoint by the samples which arrived since the last call,
+        /// then integrate the rest of the window (up to time_end) on a copy.
+        _m_window.advance(_m_imu_buffer, time_end,
+            [this]() {
+                _pim_obj->resetIntegration();
+            },
+            [this](const imu_reading& prop_datum_i, const imu_reading& prop_datum_i_next) {
+                _pim_obj->integrateMeasurement(prop_datum_i, prop_datum_i_next);
+            }
+        );
+        _pim_obj->beginTail();
+        const std::size_t tail_steps = _m_window.finish([this](const imu_reading& prop_datum_i, const imu_reading& prop_datum_i_next) {
+            _pim_obj->integrateTailMeasurement(prop_datum_i, prop_datum_i_next);
+        });
 
-        /// Need to integrate over a sliding window of 2 imu_type values.
-        /// If the container of data is smaller than 2 elements, return early.
-        if (prop_data.size() < 2) {
+        /// Need to integrate over a sliding window of 2 imu_reading values.
+        /// If the window is smaller than 2 elements, return early.
+        const std::size_t steps = _m_window.committed() + tail_steps;
+        if (steps == 0) {
             return;
         }
 
+        /// The bias estimate does not change during preintegration
         ImuBias prev_bias = _pim_obj->biasHat();
         ImuBias bias = _pim_obj->biasHat();
 
-#ifndef NDEBUG
-        std::cout << "Integrating over " << prop_data.size() << " IMU samples\n";
-#endif
-
-        for (std::size_t i = 0; i < prop_data.size() - 1; i++) {
-            const imu_type& prop_datum_i      = prop_data[i];
-            const imu_type& prop_datum_i_next = prop_data[i + 1];
-
-            _pim_obj->integrateMeasurement(prop_datum_i, prop_datum_i_next);
-
-            prev_bias = bias;
-            bias = _pim_obj->biasHat();
-        }
-
         gtsam::NavState navstate_k = _pim_obj->predict();
         gtsam::Pose3 out_pose = navstate_k.pose();
 
@@ -259,64 +244,6 @@ private:
             }
         ));
     }
-
-    // Select IMU readings based on timestamp similar to how OpenVINS selects IMU values to propagate
-    std::vector<imu_type> select_imu_readings(
-        const std::vector<imu_type>& imu_data,
-        const double& time_begin,
-        const double& time_end)
-    {
-        std::vector<imu_type> prop_data;
-        if (imu_data.size() < 2) {
-            return prop_data;
-        }
-
-        for (std::size_t i = 0; i < imu_data.size() - 1; i++) {
-
-            // If time_begin comes inbetween two IMUs (A and B), interpolate A forward to time_begin
-            if (imu_data[i + 1].timestamp > time_begin && imu_data[i].timestamp < time_begin) {
-                imu_type data = interpolate_imu(imu_data[i], imu_data[i + 1], time_begin);
-                prop_data.push_back(data);
-                continue;
-            }
-
-            // IMU is within time_begin and time_end
-            if (imu_data[i].timestamp >= time_begin && imu_data[i + 1].timestamp <= time_end) {
-                prop_data.push_back(imu_data.at(i));
-                continue;
-            }
-
-            // IMU is past time_end
-            if (imu_data[i + 1].timestamp > time_end) {
-                imu_type data = interpolate_imu(imu_data[i], imu_data[i + 1], time_end);
-                prop_data.push_back(data);
-                break;
-            }
-        }
-
-        // Loop through and ensure we do not have an zero dt values
-        // This would cause the noise covariance to be Infinity
-        for (std::size_t i = 0; i < prop_data.size() - 1; i++) {
-            if (std::abs(prop_data[i + 1].timestamp - prop_data[i].timestamp) < 1e-12) {
-                prop_data.erase(prop_data.begin() + i);
-                i--;
-            }
-        }
-
-        return prop_data;
-    }
-
-    // For when an integration time ever falls inbetween two imu measurements (modeled after OpenVINS)
-    static imu_type interpolate_imu(const imu_type& imu_1, const imu_type& imu_2, const double& timestamp) {
-        imu_type data;
-        data.timestamp = timestamp;
-
-        const double lambda = (timestamp - imu_1.timestamp) / (imu_2.timestamp - imu_1.timestamp);
-        data.am = (1 - lambda) * imu_1.am + lambda * imu_2.am;
-        data.wm = (1 - lambda) * imu_1.wm + lambda * imu_2.wm;
-
-        return data;
-    }
 };
 
 PLUGIN_MAIN(imu_integrator)
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/calib3d.hpp>
+
+// EuRoC MAV stereo calibration (cam0/sensor.yaml and cam1/sensor.yaml).
+// Radial-tangential distortion; T_BS is the sensor-to-body transform.
+namespace euroc {
+	constexpr int width = 752;
+	constexpr int height = 480;
+
+	const double cam0_intrinsics[4] = {458.654, 457.296, 367.215, 248.375};
+	const double cam0_distortion[4] = {-0.28340811, 0.07395907, 0.00019359, 1.76187114e-05};
+	const double cam0_T_BS[16] = {
+		0.0148655429818, -0.999880929698, 0.00414029679422, -0.0216401454975,
+		0.999557249008, 0.0149672133247, 0.025715529948, -0.064676986768,
+		-0.0257744366974, 0.00375618835797, 0.999660727178, 0.00981073058949,
+		0.0, 0.0, 0.0, 1.0,
+	};
+
+	const double cam1_intrinsics[4] = {457.587, 456.134, 379.999, 255.238};
+	const double cam1_distortion[4] = {-0.28368365, 0.07451284, -0.00010473, -3.55590700e-05};
+	const double cam1_T_BS[16] = {
+		0.0125552670891, -0.999755099723, 0.0182237714554, -0.0198435579556,
+		0.999598781151, 0.0130119051815, 0.0251588363115, 0.0453689425024,
+		-0.0253898008918, 0.0179005838253, 0.999517347078, 0.00786212447038,
+		0.0, 0.0, 0.0, 1.0,
+	};
+}
+
+/**
+ * @brief Precomputed remap tables which undistort and rectify a stereo pair.
+ *
+ * The tables are fixed-point (CV_16SC2 + CV_16UC1), which is what OpenCV's vectorized remap path
+ * is fastest with.
+ */
+struct stereo_rectification {
+	cv::Size size;
+	cv::Mat map0_xy, map0_interp;
+	cv::Mat map1_xy, map1_interp;
+
+	static stereo_rectification euroc() {
+		auto intrinsics = [](const double* k) {
+			cv::Mat K = cv::Mat::zeros(3, 3, CV_64F);
+			K.at<double>(0, 0) = k[0];
+			K.at<double>(1, 1) = k[1];
+			K.at<double>(0, 2) = k[2];
+			K.at<double>(1, 2) = k[3];
+			K.at<double>(2, 2) = 1.0;
+			return K;
+		};
+		auto transform = [](const double* t) {
+			return cv::Mat(4, 4, CV_64F, const_cast<double*>(t)).clone();
+		};
+
+		const cv::Mat K0 = intrinsics(euroc::cam0_intrinsics);
+		const cv::Mat K1 = intrinsics(euroc::cam1_intrinsics);
+		const cv::Mat D0 = cv::Mat(1, 4, CV_64F, const_cast<double*>(euroc::cam0_distortion)).clone();
+		const cv::Mat D1 = cv::Mat(1, 4, CV_64F, const_cast<double*>(euroc::cam1_distortion)).clone();
+
+		// Pose of cam0 in cam1's frame: T_C1_C0 = T_BS1^-1 * T_BS0
+		const cv::Mat T_C1_C0 = transform(euroc::cam1_T_BS).inv() * transform(euroc::cam0_T_BS);
+		const cv::Mat R = T_C1_C0(cv::Rect(0, 0, 3, 3)).clone();
+		const cv::Mat T = T_C1_C0(cv::Rect(3, 0, 1, 3)).clone();
+
+		stereo_rectification rect;
+		rect.size = cv::Size{euroc::width, euroc::height};
+
+		cv::Mat R0, R1, P0, P1, Q;
+		cv::stereoRectify(K0, D0, K1, D1, rect.size, R, T, R0, R1, P0, P1, Q, cv::CALIB_ZERO_DISPARITY, 0);
+		cv::initUndistortRectifyMap(K0, D0, R0, P0, rect.size, CV_16SC2, rect.map0_xy, rect.map0_interp);
+		cv::initUndistortRectifyMap(K1, D1, R1, P1, rect.size, CV_16SC2, rect.map1_xy, rect.map1_interp);
+		return rect;
+	}
+};
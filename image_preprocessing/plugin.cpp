@@ -0,0 +1,127 @@
+#include <chrono>
+#include <opencv2/imgproc.hpp>
+#include "common/plugin.hpp"
+#include "common/switchboard.hpp"
+#include "common/data_format.hpp"
+#include "common/global_module_defs.hpp"
+#include "calibration.hpp"
+
+using namespace ILLIXR;
+
+const record_header image_preprocessing_record {
+	"image_preprocessing",
+	{
+		{"dataset_time", typeid(std::size_t)},
+		{"rectify", typeid(std::chrono::nanoseconds)},
+		{"equalize", typeid(std::chrono::nanoseconds)},
+		{"pyramid", typeid(std::chrono::nanoseconds)},
+	},
+};
+
+/**
+ * @brief Rectifies, equalizes, and builds pyramids for each stereo pair once, for every downstream consumer.
+ *
+ * All three stages are OpenCV primitives with vectorized (HAL/universal-intrinsic) implementations;
+ * rectification uses fixed-point remap tables precomputed at startup.
+ */
+class image_preprocessing : public plugin {
+public:
+	image_preprocessing(std::string name_, phonebook* pb_)
+		: plugin{name_, pb_}
+		, sb{pb->lookup_impl<switchboard>()}
+		, _m_preprocessed_stereo{sb->get_writer<preprocessed_stereo_type>("preprocessed_stereo")}
+		, _m_rectify{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_PREPROCESS_RECTIFY", "True"))}
+		, _m_equalize{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_PREPROCESS_EQUALIZE", "False"))}
+		, _m_pyramid_levels{std::max(1, std::stoi(ILLIXR::getenv_or("ILLIXR_PREPROCESS_PYRAMID_LEVELS", "3")))}
+		, _m_log{record_logger_}
+	{
+		if (_m_rectify) {
+			_m_rectification = stereo_rectification::euroc();
+		}
+	}
+
+	virtual void start() override {
+		plugin::start();
+		sb->schedule<stereo_frame_type>(id, "stereo_frame", [this](switchboard::ptr<const stereo_frame_type> datum, std::size_t) {
+			this->process(datum);
+		});
+	}
+
+private:
+	void process(switchboard::ptr<const stereo_frame_type> datum) {
+		const bool rectify = _m_rectify && datum->img0.size() == _m_rectification.size && datum->img1.size() == _m_rectification.size;
+		if (_m_rectify && !rectify && !_m_warned_size) {
+			std::cerr << "image_preprocessing: frames do not match the calibrated size; passing them through unrectified" << std::endl;
+			_m_warned_size = true;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		cv::Mat img0;
+		cv::Mat img1;
+		if (rectify) {
+			cv::remap(datum->img0, img0, _m_rectification.map0_xy, _m_rectification.map0_interp, cv::INTER_LINEAR);
+			cv::remap(datum->img1, img1, _m_rectification.map1_xy, _m_rectification.map1_interp, cv::INTER_LINEAR);
+		} else {
+			// Events are immutable, so sharing the producer's buffers is safe.
+			img0 = datum->img0;
+			img1 = datum->img1;
+		}
+		auto rectified = std::chrono::high_resolution_clock::now();
+
+		if (_m_equalize) {
+			// Not in place: without rectification, img0/img1 are still the producer's buffers.
+			cv::Mat equalized0;
+			cv::Mat equalized1;
+			cv::equalizeHist(img0, equalized0);
+			cv::equalizeHist(img1, equalized1);
+			img0 = equalized0;
+			img1 = equalized1;
+		}
+		auto equalized = std::chrono::high_resolution_clock::now();
+
+		std::vector<cv::Mat> pyramid0 = build_pyramid(img0);
+		std::vector<cv::Mat> pyramid1 = build_pyramid(img1);
+		auto done = std::chrono::high_resolution_clock::now();
+
+		_m_log.log(record{image_preprocessing_record, {
+			{std::size_t(datum->dataset_time)},
+			{std::chrono::duration_cast<std::chrono::nanoseconds>(rectified - start)},
+			{std::chrono::duration_cast<std::chrono::nanoseconds>(equalized - rectified)},
+			{std::chrono::duration_cast<std::chrono::nanoseconds>(done - equalized)},
+		}});
+
+		_m_preprocessed_stereo.put(_m_preprocessed_stereo.allocate<preprocessed_stereo_type>(
+			preprocessed_stereo_type {
+				datum->time,
+				datum->dataset_time,
+				std::move(pyramid0),
+				std::move(pyramid1),
+				rectify,
+				_m_equalize,
+			}
+		));
+	}
+
+	std::vector<cv::Mat> build_pyramid(const cv::Mat& base) const {
+		std::vector<cv::Mat> pyramid;
+		pyramid.reserve(_m_pyramid_levels);
+		pyramid.push_back(base);
+		for (int level = 1; level < _m_pyramid_levels; ++level) {
+			cv::Mat next;
+			cv::pyrDown(pyramid.back(), next);
+			pyramid.push_back(std::move(next));
+		}
+		return pyramid;
+	}
+
+	const std::shared_ptr<switchboard> sb;
+	switchboard::writer<preprocessed_stereo_type> _m_preprocessed_stereo;
+	const bool _m_rectify;
+	const bool _m_equalize;
+	const int _m_pyramid_levels;
+	stereo_rectification _m_rectification;
+	bool _m_warned_size {false};
+	record_coalescer _m_log;
+};
+
+PLUGIN_MAIN(image_preprocessing);
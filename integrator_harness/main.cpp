@@ -0,0 +1,539 @@
+/*
+ * Runs the IMU integrators in isolation, to compare their cost and drift without the rest of the stack.
+ *
+ * An IMU stream is fed sample by sample to each integrator, the way its plugin is fed, together with
+ * `imu_integrator_input` snapshots taken from ground truth: one per slow pose (--slow-rate), each delivered
+ * --latency seconds after the time it describes, as a VIO would. Every sample is propagated from the newest
+ * delivered snapshot, so the error against ground truth at the sample's time is the integrator's drift over
+ * a window of --latency to --latency + 1/--slow-rate seconds.
+ *
+ * Reported per integrator:
+ * - ns per sample (buffering and propagation, as in the plugin's IMU callback)
+ * - heap allocations per sample
+ * - position and orientation error against ground truth, at the end of each window
+ *
+ * The stream is a EuRoC sequence directory (imu0/ and state_groundtruth_estimate0/),
+ * or a synthetic trajectory with known ground truth if none is given.
+ *
+ * Usage: integrator_harness [--integrator NAME] [--slow-rate HZ] [--latency SECONDS] [EUROC_SEQUENCE_DIR]
+ * where NAME is one of rk4, rk4-float, gtsam, gtsam-fast (if built with GTSAM), or all (the default).
+ *
+ * Build and run with `make run ARGS="..."`.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/data_format.hpp"
+#include "common/imu_buffer.hpp"
+#include "../rk4_integrator/propagator.hpp"
+#ifdef HARNESS_WITH_GTSAM
+#include "../gtsam_integrator/pim_object.hpp"
+#endif
+
+using namespace ILLIXR;
+
+// Count heap allocations by wrapping glibc's malloc: operator new, Eigen and GTSAM all end up there.
+#ifdef __GLIBC__
+namespace {
+	bool counting_allocations = false;
+	std::size_t allocations = 0;
+}
+
+extern "C" {
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t count, std::size_t size);
+	void* __libc_realloc(void* ptr, std::size_t size);
+
+	void* malloc(std::size_t size) {
+		allocations += counting_allocations;
+		return __libc_malloc(size);
+	}
+
+	void* calloc(std::size_t count, std::size_t size) {
+		allocations += counting_allocations;
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* ptr, std::size_t size) {
+		allocations += counting_allocations;
+		return __libc_realloc(ptr, size);
+	}
+}
+#define HARNESS_COUNTS_ALLOCATIONS
+#endif
+
+namespace {
+
+	// IMU sample time to live in seconds, as in the plugins
+	constexpr double imu_ttl = 5.;
+
+	struct ground_truth_state {
+		double timestamp;
+		Eigen::Vector3d position;
+		// Body to world
+		Eigen::Quaterniond quat;
+		Eigen::Vector3d velocity;
+		Eigen::Vector3d bias_gyro;
+		Eigen::Vector3d bias_acc;
+	};
+
+	struct sequence {
+		std::string name;
+		std::vector<imu_reading> imu;
+		// Sorted by time, and covering the IMU stream
+		std::vector<ground_truth_state> ground_truth;
+	};
+
+	// Ground truth at @p timestamp, interpolated between its neighbours
+	ground_truth_state ground_truth_at(const std::vector<ground_truth_state>& ground_truth, double timestamp) {
+		auto after = std::upper_bound(ground_truth.begin(), ground_truth.end(), timestamp,
+			[](double t, const ground_truth_state& state) { return t < state.timestamp; });
+		if (after == ground_truth.begin()) {
+			return ground_truth.front();
+		}
+		if (after == ground_truth.end()) {
+			return ground_truth.back();
+		}
+		const ground_truth_state& a = *(after - 1);
+		const ground_truth_state& b = *after;
+		const double lambda = (timestamp - a.timestamp) / (b.timestamp - a.timestamp);
+		return ground_truth_state{
+			timestamp,
+			(1 - lambda) * a.position + lambda * b.position,
+			a.quat.slerp(lambda, b.quat),
+			(1 - lambda) * a.velocity + lambda * b.velocity,
+			a.bias_gyro,
+			a.bias_acc,
+		};
+	}
+
+	std::vector<std::vector<double>> read_csv(const std::string& path) {
+		std::ifstream file {path};
+		if (!file.good()) {
+			std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+			std::exit(1);
+		}
+		std::vector<std::vector<double>> rows;
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			std::vector<double> row;
+			std::stringstream cells {line};
+			std::string cell;
+			while (std::getline(cells, cell, ',')) {
+				row.push_back(std::stod(cell));
+			}
+			rows.push_back(std::move(row));
+		}
+		return rows;
+	}
+
+	/*
+	 * EuRoC: imu0/data.csv is (timestamp [ns], w [rad/s], a [m/s^2]),
+	 * state_groundtruth_estimate0/data.csv is (timestamp [ns], p, q (w, x, y, z), v, b_w, b_a).
+	 * Timestamps are made relative to the first ground truth, and the IMU stream is cut to the ground truth's span.
+	 */
+	sequence load_euroc(const std::string& path) {
+		sequence seq;
+		seq.name = path;
+
+		const auto ground_truth_rows = read_csv(path + "/state_groundtruth_estimate0/data.csv");
+		const auto imu_rows = read_csv(path + "/imu0/data.csv");
+		if (ground_truth_rows.size() < 2 || imu_rows.size() < 2) {
+			std::fprintf(stderr, "%s has too little data\n", path.c_str());
+			std::exit(1);
+		}
+
+		// Timestamps in ns don't fit in a double exactly
+		const long long t0 = std::llround(ground_truth_rows.front()[0]);
+		auto seconds = [t0](double ns) {
+			return double(std::llround(ns) - t0) / 1e9;
+		};
+
+		for (const auto& row : ground_truth_rows) {
+			seq.ground_truth.push_back(ground_truth_state{
+				seconds(row[0]),
+				Eigen::Vector3d{row[1], row[2], row[3]},
+				Eigen::Quaterniond{row[4], row[5], row[6], row[7]}.normalized(),
+				Eigen::Vector3d{row[8], row[9], row[10]},
+				Eigen::Vector3d{row[11], row[12], row[13]},
+				Eigen::Vector3d{row[14], row[15], row[16]},
+			});
+		}
+		for (const auto& row : imu_rows) {
+			const double timestamp = seconds(row[0]);
+			if (timestamp >= 0 && timestamp <= seq.ground_truth.back().timestamp) {
+				seq.imu.push_back(imu_reading{timestamp, Eigen::Vector3d{row[1], row[2], row[3]}, Eigen::Vector3d{row[4], row[5], row[6]}});
+			}
+		}
+		return seq;
+	}
+
+	/*
+	 * A smooth trajectory, with the IMU readings it implies: EuRoC-like noise on top of constant biases.
+	 */
+	sequence make_synthetic() {
+		constexpr double imu_rate = 200.;
+		constexpr double duration = 60.;
+		const Eigen::Vector3d gravity {0., 0., 9.81};
+		const Eigen::Vector3d bias_gyro {0.002, -0.001, 0.003};
+		const Eigen::Vector3d bias_acc {0.02, -0.01, 0.03};
+		// Discrete-time standard deviations at imu_rate
+		const double gyro_sigma = 0.00016968 * std::sqrt(imu_rate);
+		const double acc_sigma = 0.002 * std::sqrt(imu_rate);
+
+		auto position = [](double t) {
+			return Eigen::Vector3d{1.5 * std::sin(0.5 * t), std::sin(0.7 * t + 1.), 0.3 * std::sin(0.9 * t)};
+		};
+		auto velocity = [](double t) {
+			return Eigen::Vector3d{0.75 * std::cos(0.5 * t), 0.7 * std::cos(0.7 * t + 1.), 0.27 * std::cos(0.9 * t)};
+		};
+		auto acceleration = [](double t) {
+			return Eigen::Vector3d{-0.375 * std::sin(0.5 * t), -0.49 * std::sin(0.7 * t + 1.), -0.243 * std::sin(0.9 * t)};
+		};
+		auto rotation = [](double t) {
+			return Eigen::Matrix3d{
+				Eigen::AngleAxisd{0.8 * std::sin(0.4 * t), Eigen::Vector3d::UnitZ()} *
+				Eigen::AngleAxisd{0.3 * std::sin(0.6 * t), Eigen::Vector3d::UnitY()} *
+				Eigen::AngleAxisd{0.2 * std::sin(0.8 * t), Eigen::Vector3d::UnitX()}
+			};
+		};
+
+		std::mt19937 rng {0};
+		std::normal_distribution<double> noise {0., 1.};
+		auto noise3 = [&](double sigma) {
+			return Eigen::Vector3d{sigma * noise(rng), sigma * noise(rng), sigma * noise(rng)};
+		};
+
+		sequence seq;
+		seq.name = "synthetic";
+		for (std::size_t i = 0; double(i) / imu_rate <= duration; i++) {
+			const double t = double(i) / imu_rate;
+			const Eigen::Matrix3d R = rotation(t);
+
+			// Body angular velocity, from R^T dR/dt (central difference)
+			constexpr double h = 1e-5;
+			const Eigen::Matrix3d w_x = R.transpose() * (rotation(t + h) - rotation(t - h)) / (2 * h);
+			const Eigen::Vector3d w {w_x(2, 1), w_x(0, 2), w_x(1, 0)};
+			// Specific force in the body frame
+			const Eigen::Vector3d a = R.transpose() * (acceleration(t) + gravity);
+
+			seq.imu.push_back(imu_reading{t, w + bias_gyro + noise3(gyro_sigma), a + bias_acc + noise3(acc_sigma)});
+			seq.ground_truth.push_back(ground_truth_state{t, position(t), Eigen::Quaterniond{R}, velocity(t), bias_gyro, bias_acc});
+		}
+		return seq;
+	}
+
+	imu_params make_params() {
+		// EuRoC values, as the VIO plugins use them
+		return imu_params{
+			0.00016968,                                      // gyro_noise
+			0.002,                                           // acc_noise
+			1.9393e-05,                                      // gyro_walk
+			0.003,                                           // acc_walk
+			Eigen::Matrix<double,3,1>(0.0, 0.0, -9.81),      // n_gravity
+			1.0,                                             // imu_integration_sigma
+			200.0,                                           // nominal_rate
+		};
+	}
+
+	imu_integrator_input make_input(const ground_truth_state& state) {
+		return imu_integrator_input{
+			state.timestamp,
+			0.,
+			make_params(),
+			state.bias_acc,
+			state.bias_gyro,
+			state.position,
+			state.velocity,
+			state.quat,
+		};
+	}
+
+	/*
+	 * One integrator, propagating the way its plugin.cpp does.
+	 */
+	class integrator {
+	public:
+		virtual ~integrator() { }
+		/// A new imu_integrator_input arrived
+		virtual void set_input(const imu_integrator_input& input) = 0;
+		/// Propagate the current input to @p time_end. False if there was nothing to propagate.
+		virtual bool propagate(const imu_buffer& buffer, double time_end, Eigen::Vector3d& position, Eigen::Quaterniond& quat) = 0;
+	};
+
+	class rk4_integrator : public integrator {
+	public:
+		explicit rk4_integrator(rk4_precision precision)
+			: _m_propagator{precision}
+		{ }
+
+		virtual void set_input(const imu_integrator_input& input) override {
+			_m_propagator.reset(
+				rk4_state {
+					Eigen::Vector4d{input.quat.x(), input.quat.y(), input.quat.z(), input.quat.w()},
+					input.position,
+					input.velocity,
+				},
+				input.last_cam_integration_time + input.t_offset,
+				input.biasGyro,
+				input.biasAcc
+			);
+		}
+
+		virtual bool propagate(const imu_buffer& buffer, double time_end, Eigen::Vector3d& position, Eigen::Quaterniond& quat) override {
+			const rk4_result result = _m_propagator.propagate(buffer, time_end);
+			const Eigen::Vector4d& q = result.state.quat;
+			position = result.state.pos;
+			quat = Eigen::Quaterniond{q(3), q(0), q(1), q(2)};
+			return true;
+		}
+
+	private:
+		rk4_propagator _m_propagator;
+	};
+
+#ifdef HARNESS_WITH_GTSAM
+	class gtsam_integrator : public integrator {
+	public:
+		explicit gtsam_integrator(bool fast)
+			: _m_fast{fast}
+		{ }
+
+		virtual void set_input(const imu_integrator_input& input) override {
+			if (_m_pim == nullptr) {
+				_m_pim = std::make_unique<PimObject>(input, _m_fast);
+			} else {
+				_m_pim->resetIntegrationAndSetBias(input);
+			}
+			_m_window.reset(input.last_cam_integration_time + input.t_offset);
+		}
+
+		virtual bool propagate(const imu_buffer& buffer, double time_end, Eigen::Vector3d& position, Eigen::Quaterniond& quat) override {
+			_m_window.advance(buffer, time_end,
+				[this]() { _m_pim->resetIntegration(); },
+				[this](const imu_reading& from, const imu_reading& to) { _m_pim->integrateMeasurement(from, to); }
+			);
+			_m_pim->beginTail();
+			const std::size_t tail_steps = _m_window.finish([this](const imu_reading& from, const imu_reading& to) {
+				_m_pim->integrateTailMeasurement(from, to);
+			});
+			if (_m_window.committed() + tail_steps == 0) {
+				return false;
+			}
+			const gtsam::Pose3 pose = _m_pim->predict().pose();
+			position = pose.translation();
+			quat = pose.rotation().toQuaternion();
+			return true;
+		}
+
+	private:
+		const bool _m_fast;
+		std::unique_ptr<PimObject> _m_pim;
+		imu_window_tracker _m_window;
+	};
+#endif
+
+	std::unique_ptr<integrator> make_integrator(const std::string& name) {
+		if (name == "rk4") {
+			return std::make_unique<rk4_integrator>(rk4_precision::float64);
+		}
+		if (name == "rk4-float") {
+			return std::make_unique<rk4_integrator>(rk4_precision::float32);
+		}
+#ifdef HARNESS_WITH_GTSAM
+		if (name == "gtsam") {
+			return std::make_unique<gtsam_integrator>(false);
+		}
+		if (name == "gtsam-fast") {
+			return std::make_unique<gtsam_integrator>(true);
+		}
+#endif
+		return nullptr;
+	}
+
+	struct options {
+		std::string integrator = "all";
+		double slow_rate = 15.;
+		double latency = 0.1;
+		std::string euroc;
+	};
+
+	struct report {
+		std::size_t samples = 0;
+		std::vector<double> ns;
+		std::size_t allocations = 0;
+		double horizon = 0;
+		std::vector<double> position_errors;
+		std::vector<double> orientation_errors;
+	};
+
+	report run(const sequence& seq, const options& opts, integrator& integrator) {
+		report out;
+		out.ns.reserve(seq.imu.size());
+		out.position_errors.reserve(seq.imu.size());
+		out.orientation_errors.reserve(seq.imu.size());
+
+		imu_buffer buffer;
+		const double slow_period = 1. / opts.slow_rate;
+		// Times of the slow poses (on IMU samples, like camera frames), and the next one to deliver
+		std::vector<double> slow_times;
+		for (const imu_reading& reading : seq.imu) {
+			if (slow_times.empty() || reading.timestamp >= slow_times.back() + slow_period) {
+				slow_times.push_back(reading.timestamp);
+			}
+		}
+		std::size_t next_slow = 0;
+		bool has_input = false;
+		double input_time = 0;
+
+		for (const imu_reading& reading : seq.imu) {
+			// Deliver the slow poses which the VIO would have finished by now
+			while (next_slow < slow_times.size() && slow_times[next_slow] + opts.latency <= reading.timestamp) {
+				input_time = slow_times[next_slow];
+				integrator.set_input(make_input(ground_truth_at(seq.ground_truth, input_time)));
+				has_input = true;
+				next_slow++;
+			}
+
+			Eigen::Vector3d position;
+			Eigen::Quaterniond quat;
+			bool propagated = false;
+
+#ifdef HARNESS_COUNTS_ALLOCATIONS
+			const std::size_t allocations_before = allocations;
+			counting_allocations = true;
+#endif
+			const auto start = std::chrono::steady_clock::now();
+			buffer.push(reading);
+			buffer.expire_before(reading.timestamp - imu_ttl);
+			if (has_input) {
+				propagated = integrator.propagate(buffer, reading.timestamp, position, quat);
+			}
+			const auto stop = std::chrono::steady_clock::now();
+#ifdef HARNESS_COUNTS_ALLOCATIONS
+			counting_allocations = false;
+			out.allocations += allocations - allocations_before;
+#endif
+
+			out.samples++;
+			out.ns.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+			if (propagated) {
+				const ground_truth_state expected = ground_truth_at(seq.ground_truth, reading.timestamp);
+				out.horizon += reading.timestamp - input_time;
+				out.position_errors.push_back((position - expected.position).norm());
+				out.orientation_errors.push_back(quat.angularDistance(expected.quat) * 180. / M_PI);
+			}
+		}
+		return out;
+	}
+
+	double mean(const std::vector<double>& values) {
+		double sum = 0;
+		for (double value : values) {
+			sum += value;
+		}
+		return values.empty() ? 0. : sum / double(values.size());
+	}
+
+	double percentile(std::vector<double> values, double p) {
+		if (values.empty()) {
+			return 0.;
+		}
+		const std::size_t index = std::min(values.size() - 1, std::size_t(p * double(values.size())));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	void print(const std::string& name, const report& r) {
+#ifdef HARNESS_COUNTS_ALLOCATIONS
+		char allocations[32];
+		std::snprintf(allocations, sizeof(allocations), "%.2f", double(r.allocations) / double(r.samples));
+#else
+		const char* allocations = "-";
+#endif
+		std::printf("%-12s %10.0f %10.0f %10s %12.1f %12.4f %12.4f %12.3f %12.3f\n", name.c_str(),
+			mean(r.ns),
+			percentile(r.ns, 0.99),
+			allocations,
+			r.position_errors.empty() ? 0. : 1000. * r.horizon / double(r.position_errors.size()),
+			mean(r.position_errors),
+			percentile(r.position_errors, 0.99),
+			mean(r.orientation_errors),
+			percentile(r.orientation_errors, 0.99));
+	}
+
+	[[noreturn]] void usage(const char* argv0) {
+		std::fprintf(stderr, "Usage: %s [--integrator NAME] [--slow-rate HZ] [--latency SECONDS] [EUROC_SEQUENCE_DIR]\n", argv0);
+		std::fprintf(stderr, "NAME: rk4, rk4-float");
+#ifdef HARNESS_WITH_GTSAM
+		std::fprintf(stderr, ", gtsam, gtsam-fast");
+#endif
+		std::fprintf(stderr, " or all\n");
+		std::exit(1);
+	}
+
+	options parse(int argc, char** argv) {
+		options opts;
+		for (int i = 1; i < argc; i++) {
+			const std::string arg = argv[i];
+			const bool has_value = i + 1 < argc;
+			if (arg == "--integrator" && has_value) {
+				opts.integrator = argv[++i];
+			} else if (arg == "--slow-rate" && has_value) {
+				opts.slow_rate = std::stod(argv[++i]);
+			} else if (arg == "--latency" && has_value) {
+				opts.latency = std::stod(argv[++i]);
+			} else if (!arg.empty() && arg[0] != '-' && opts.euroc.empty()) {
+				opts.euroc = arg;
+			} else {
+				usage(argv[0]);
+			}
+		}
+		if (opts.slow_rate <= 0 || opts.latency < 0) {
+			usage(argv[0]);
+		}
+		return opts;
+	}
+
+}
+
+int main(int argc, char** argv) {
+	const options opts = parse(argc, argv);
+
+	std::vector<std::string> names;
+	if (opts.integrator == "all") {
+		names = {"rk4", "rk4-float"};
+#ifdef HARNESS_WITH_GTSAM
+		names.insert(names.end(), {"gtsam", "gtsam-fast"});
+#endif
+	} else if (make_integrator(opts.integrator)) {
+		names = {opts.integrator};
+	} else {
+		usage(argv[0]);
+	}
+
+	const sequence seq = opts.euroc.empty() ? make_synthetic() : load_euroc(opts.euroc);
+	std::printf("%s: %zu IMU samples over %.1f s; slow pose at %.0f Hz, delivered %.0f ms late\n\n",
+		seq.name.c_str(), seq.imu.size(), seq.imu.back().timestamp - seq.imu.front().timestamp,
+		opts.slow_rate, opts.latency * 1000.);
+
+	std::printf("%-12s %10s %10s %10s %12s %12s %12s %12s %12s\n", "",
+		"ns/sample", "p99 ns", "allocs", "window (ms)", "dp (m)", "p99 dp (m)", "dq (deg)", "p99 dq (deg)");
+	for (const std::string& name : names) {
+		const std::unique_ptr<integrator> integrator = make_integrator(name);
+		print(name, run(seq, opts, *integrator));
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "common/error_util.hpp"
+#include "common/frame_pool.hpp"
+
+/**
+ * @brief A size-bounded LRU cache of decoded frames, keyed by image path.
+ *
+ * When replaying the same sequence several times, this avoids decoding every image again.
+ * Note that LRU only helps if the cache can hold a whole loop; a cache smaller than the
+ * loop is evicted in the same order it is read, and every lookup misses.
+ *
+ * A capacity of 0 disables caching; frames are then decoded on every load.
+ *
+ * Cached frames are shared (not copied) with the events that carry them, so consumers must
+ * treat published images as read-only.
+ *
+ * Images are decoded straight into buffers from the frame pool, which get recycled once
+ * neither the cache nor any event holds them.
+ */
+class frame_cache {
+public:
+	frame_cache(std::size_t capacity_bytes, std::shared_ptr<ILLIXR::frame_pool> pool)
+		: _m_capacity_bytes{capacity_bytes}
+		, _m_pool{std::move(pool)}
+	{ }
+
+	cv::Mat load(const std::string& path) {
+		if (_m_capacity_bytes == 0) {
+			++_m_misses;
+			return decode(path);
+		}
+
+		auto found = _m_index.find(path);
+		if (found != _m_index.end()) {
+			++_m_hits;
+			// Move to the front (most-recently used)
+			_m_lru.splice(_m_lru.begin(), _m_lru, found->second);
+			return found->second->second;
+		}
+
+		++_m_misses;
+		cv::Mat img = decode(path);
+		const std::size_t img_bytes = img.total() * img.elemSize();
+		if (img_bytes > _m_capacity_bytes) {
+			return img;
+		}
+
+		while (_m_size_bytes + img_bytes > _m_capacity_bytes) {
+			const cv::Mat& victim = _m_lru.back().second;
+			_m_size_bytes -= victim.total() * victim.elemSize();
+			_m_index.erase(_m_lru.back().first);
+			_m_lru.pop_back();
+		}
+
+		_m_lru.emplace_front(path, img);
+		_m_index.emplace(path, _m_lru.begin());
+		_m_size_bytes += img_bytes;
+		return img;
+	}
+
+	std::size_t hits() const { return _m_hits; }
+	std::size_t misses() const { return _m_misses; }
+
+private:
+	cv::Mat decode(const std::string& path) {
+		std::ifstream file {path, std::ios::binary};
+		if (!file.good()) {
+			ILLIXR::abort(path + " is not a good path");
+		}
+		_m_file_bytes.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+		if (file.bad() || _m_file_bytes.empty()) {
+			ILLIXR::abort("Could not read " + path);
+		}
+
+		// imdecode allocates its output through the Mat's allocator, i.e. from the pool.
+		cv::Mat img = _m_pool->empty();
+		cv::imdecode(cv::Mat(1, int(_m_file_bytes.size()), CV_8UC1, _m_file_bytes.data()), cv::IMREAD_GRAYSCALE, &img);
+		if (img.empty()) {
+			ILLIXR::abort("Could not decode " + path);
+		}
+		return img;
+	}
+
+	using entry = std::pair<std::string, cv::Mat>;
+
+	const std::size_t _m_capacity_bytes;
+	const std::shared_ptr<ILLIXR::frame_pool> _m_pool;
+	// Reused between decodes; holds the compressed file
+	std::vector<char> _m_file_bytes;
+	std::size_t _m_size_bytes {0};
+	std::list<entry> _m_lru;
+	std::unordered_map<std::string, std::list<entry>::iterator> _m_index;
+	std::size_t _m_hits {0};
+	std::size_t _m_misses {0};
+};
@@ -1,10 +1,17 @@
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
-#include "data_loading.hpp"
-#include "common/data_format.hpp"
+#include "common/dataset.hpp"
+#include "common/error_util.hpp"
+#include "frame_cache.hpp"
 #include "common/threadloop.hpp"
 #include "common/global_module_defs.hpp"
+#include "common/sensor_publisher.hpp"
 #include <cassert>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
 
 using namespace ILLIXR;
 
@@ -16,91 +23,181 @@ const record_header imu_cam_record {
 	},
 };
 
+// One record per pass over a sequence, so drift over a long soak run shows up loop by loop.
+const record_header offline_imu_cam_loop_record {
+	"offline_imu_cam_loop",
+	{
+		{"loop_no", typeid(std::size_t)},
+		{"sequence", typeid(std::string)},
+		{"samples", typeid(std::size_t)},
+		{"images", typeid(std::size_t)},
+		{"cache_hits", typeid(std::size_t)},
+		{"cache_misses", typeid(std::size_t)},
+		{"wall_time_start", typeid(std::chrono::high_resolution_clock::time_point)},
+		{"wall_time_stop", typeid(std::chrono::high_resolution_clock::time_point)},
+		{"max_lateness", typeid(std::chrono::nanoseconds)},
+	},
+};
+
+struct sequence {
+	std::string path;
+	const timed_stream<dataset::imu_reading>* imu0;
+	const timed_stream<std::string>* cam0;
+	const timed_stream<std::string>* cam1;
+	// Nominal IMU period, used as the gap when splicing this sequence after another
+	ullong imu_period;
+};
+
+static
+std::vector<sequence>
+load_sequences(const dataset& ds) {
+	std::vector<sequence> sequences;
+	for (std::size_t i = 0; i < ds.num_sequences(); ++i) {
+		const timed_stream<dataset::imu_reading>& imu0 = ds.imu0(i);
+		if (imu0.empty()) {
+			ILLIXR::abort(ds.path(i) + " has no IMU samples");
+		}
+
+		const ullong imu_period = imu0.size() > 1 ? (imu0.back().time - imu0.front().time) / (imu0.size() - 1) : 1;
+		sequences.push_back(sequence{ds.path(i), &imu0, &ds.cam0(i), &ds.cam1(i), imu_period});
+	}
+	return sequences;
+}
+
+/**
+ * @brief The image at exactly `time`, advancing `it` past it; null if the camera has no frame at `time`.
+ *
+ * Like the IMU-driven replay always did, frames which do not share a timestamp with an IMU sample are dropped.
+ */
+static
+const std::string*
+camera_at(timed_stream<std::string>::const_iterator& it, const timed_stream<std::string>& stream, ullong time) {
+	while (it != stream.end() && it->time < time) {
+		++it;
+	}
+	if (it != stream.end() && it->time == time) {
+		return &(it++)->value;
+	}
+	return nullptr;
+}
+
 class offline_imu_cam : public ILLIXR::threadloop {
 public:
 	offline_imu_cam(std::string name_, phonebook* pb_)
 		: threadloop{name_, pb_}
-		, _m_sensor_data{load_data()}
-		, _m_sensor_data_it{_m_sensor_data.cbegin()}
+		, _m_dataset{pb->lookup_impl<dataset>()}
+		, _m_sequences{load_sequences(*_m_dataset)}
+		, _m_imu_it{_m_sequences[0].imu0->begin()}
+		, _m_cam0_it{_m_sequences[0].cam0->begin()}
+		, _m_cam1_it{_m_sequences[0].cam1->begin()}
 		, _m_sb{pb->lookup_impl<switchboard>()}
-		, _m_imu_cam{_m_sb->get_writer<imu_cam_type>("imu_cam")}
-		, dataset_first_time{_m_sensor_data_it->first}
+		, _m_publisher{_m_sb, "euroc"}
+		, dataset_first_time{_m_imu_it->time}
 		, imu_cam_log{record_logger_}
 		, camera_cvtfmt_log{record_logger_}
-	{ }
+		, _m_loop_count{std::stoul(ILLIXR::getenv_or("ILLIXR_LOOP_COUNT", "1"))}
+		, _m_frame_cache{std::stoul(ILLIXR::getenv_or("ILLIXR_FRAME_CACHE_MB", "0")) << 20, pb->lookup_impl<frame_pool>()}
+		, _m_lockstep{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_LOCKSTEP_ENABLE", "False"))}
+		, _m_lockstep_consumers{std::stoul(ILLIXR::getenv_or("ILLIXR_LOCKSTEP_CONSUMERS", "1"))}
+		// A batch is only acknowledged once it is complete, so at least a whole batch must be allowed in flight.
+		, _m_lockstep_window{std::max(_m_publisher.batch_size(), std::stoul(ILLIXR::getenv_or("ILLIXR_LOCKSTEP_WINDOW", "1")))}
+		, _m_lockstep_timeout{std::chrono::milliseconds{std::stol(ILLIXR::getenv_or("ILLIXR_LOCKSTEP_TIMEOUT_MS", "1000"))}}
+	{
+		if (_m_lockstep) {
+			_m_sb->schedule<imu_cam_ack>(id, "imu_cam_ack", [this](switchboard::ptr<const imu_cam_ack> ack, std::size_t) {
+				this->on_ack(ack);
+			});
+		}
+	}
 
 protected:
 
 	virtual skip_option _p_should_skip() override {
-		if (_m_sensor_data_it != _m_sensor_data.end()) {
-			dataset_now = _m_sensor_data_it->first;
-			// Sleep for the difference between the current IMU vs 1st IMU and current UNIX time vs UNIX time the component was init
-			std::this_thread::sleep_for(
-				std::chrono::nanoseconds{dataset_now - dataset_first_time}
-				+ real_first_time
-				- std::chrono::high_resolution_clock::now()
-			);
-
-			if (_m_sensor_data_it->second.imu0) {
-				return skip_option::run;
-			} else {
-				++_m_sensor_data_it;
+		if (_m_imu_it == _m_sequences[_m_sequence_idx].imu0->end() && !advance_sequence()) {
+			return skip_option::stop;
+		}
+
+		dataset_now = rebase(_m_imu_it->time);
+
+		if (_m_lockstep && !_m_lockstep_checked && !lockstep_consumers_checked()) {
+			return skip_option::skip_and_yield;
+		}
+
+		if (_m_lockstep) {
+			// Publish as fast as the designated consumers keep up, instead of on the wall clock.
+			if (!lockstep_ready()) {
 				return skip_option::skip_and_yield;
 			}
-
 		} else {
-			return skip_option::stop;
+			// Sleep for the difference between the current IMU vs 1st IMU and current UNIX time vs UNIX time the component was init
+			const auto target_time = real_first_time + std::chrono::nanoseconds{dataset_now - dataset_first_time};
+			std::this_thread::sleep_for(target_time - std::chrono::high_resolution_clock::now());
+			_m_max_lateness = std::max(_m_max_lateness, std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::high_resolution_clock::now() - target_time
+			));
 		}
+
+		return skip_option::run;
 	}
 
 	virtual void _p_one_iteration() override {
 	    RAC_ERRNO_MSG("offline_imu_cam at start of _p_one_iteration");
-		assert(_m_sensor_data_it != _m_sensor_data.end());
+		const sequence& seq = _m_sequences[_m_sequence_idx];
+		assert(_m_imu_it != seq.imu0->end());
 #ifndef NDEBUG
         std::chrono::time_point<std::chrono::nanoseconds> tp_dataset_now{std::chrono::nanoseconds{dataset_now}};
 		std::cerr << " IMU time: " << tp_dataset_now.time_since_epoch().count() << std::endl;
 #endif /// NDEBUG
 		time_type real_now = real_first_time + std::chrono::nanoseconds{dataset_now - dataset_first_time};
-		const sensor_types& sensor_datum = _m_sensor_data_it->second;
-		++_m_sensor_data_it;
+		const timed_stream<dataset::imu_reading>::entry& imu_datum = *_m_imu_it;
+		++_m_imu_it;
+		const std::string* cam0_path = camera_at(_m_cam0_it, *seq.cam0, imu_datum.time);
+		const std::string* cam1_path = camera_at(_m_cam1_it, *seq.cam1, imu_datum.time);
 
 		imu_cam_log.log(record{imu_cam_record, {
 			{iteration_no},
-			{bool(sensor_datum.cam0)},
+			{bool(cam0_path)},
 		}});
 
-		std::optional<cv::Mat> cam0 = sensor_datum.cam0
-			? std::make_optional<cv::Mat>(*(sensor_datum.cam0.value().load().release()))
+		// Cameras which no plugin consumes are not decoded at all.
+		std::optional<cv::Mat> cam0 = cam0_path && _m_publisher.wants("cam0")
+			? std::make_optional<cv::Mat>(_m_frame_cache.load(*cam0_path))
 			: std::nullopt
 			;
 		RAC_ERRNO_MSG("offline_imu_cam after cam0");
 
-		std::optional<cv::Mat> cam1 = sensor_datum.cam1
-			? std::make_optional<cv::Mat>(*(sensor_datum.cam1.value().load().release()))
+		std::optional<cv::Mat> cam1 = cam1_path && _m_publisher.wants("cam1")
+			? std::make_optional<cv::Mat>(_m_frame_cache.load(*cam1_path))
 			: std::nullopt
 			;
 		RAC_ERRNO_MSG("offline_imu_cam after cam1");
 
+		++_m_loop_samples;
+		_m_loop_images += std::size_t{cam0.has_value()} + std::size_t{cam1.has_value()};
+
 #ifndef NDEBUG
         /// If debugging, assert the image is grayscale
 		if (cam0.has_value() && cam1.has_value()) {
 		    const int num_ch0 = cam0.value().channels();
 		    const int num_ch1 = cam1.value().channels();
-		    assert(num_ch0 == 1 && "Data from lazy_load_image should be grayscale");
-		    assert(num_ch1 == 1 && "Data from lazy_load_image should be grayscale");
+		    assert(num_ch0 == 1 && "Data from frame_cache should be grayscale");
+		    assert(num_ch1 == 1 && "Data from frame_cache should be grayscale");
 		}
 #endif /// NDEBUG
 
-        _m_imu_cam.put(_m_imu_cam.allocate<imu_cam_type>(
-            imu_cam_type {
-                real_now,
-                (sensor_datum.imu0.value().angular_v).cast<float>(),
-                (sensor_datum.imu0.value().linear_a).cast<float>(),
-                cam0,
-                cam1,
-                dataset_now
-            }
-        ));
+        if (_m_lockstep) {
+            const std::lock_guard<std::mutex> lock{_m_ack_mutex};
+            _m_in_flight.push_back(dataset_now);
+        }
+
+        _m_publisher.put(
+            real_now,
+            (imu_datum.value.angular_v).cast<float>(),
+            (imu_datum.value.linear_a).cast<float>(),
+            cam0,
+            cam1,
+            dataset_now
+        );
 
 		RAC_ERRNO_MSG("offline_imu_cam at bottom of iteration");
 	}
@@ -111,23 +208,183 @@ public:
 		// be done at thread-launch time, not load-time.
 		auto now = std::chrono::system_clock::now();
 		real_first_time = std::chrono::time_point_cast<std::chrono::seconds>(now);
+		_m_loop_start = std::chrono::high_resolution_clock::now();
+		_m_lockstep_start = std::chrono::steady_clock::now();
 	}
 
 private:
-	const std::map<ullong, sensor_types> _m_sensor_data;
-	std::map<ullong, sensor_types>::const_iterator _m_sensor_data_it;
+	ullong rebase(ullong sequence_time) const {
+		return static_cast<ullong>(static_cast<std::int64_t>(sequence_time) + _m_time_offset);
+	}
+
+	/**
+	 * @brief Log the summary of the finished pass and move on to the next sequence.
+	 *
+	 * The next sequence is spliced one IMU period after the last published sample, so published
+	 * timestamps (`time` and `dataset_time`) stay monotonic across sequences and loops.
+	 *
+	 * @return false if every loop is done.
+	 */
+	bool advance_sequence() {
+		// A partial IMU batch would otherwise wait for samples from the next pass, or be lost after the last one
+		_m_publisher.flush_imu_batch();
+
+		const sequence& finished = _m_sequences[_m_sequence_idx];
+		const auto loop_stop = std::chrono::high_resolution_clock::now();
+		loop_log.log(record{offline_imu_cam_loop_record, {
+			{_m_loop_no},
+			{finished.path},
+			{_m_loop_samples},
+			{_m_loop_images},
+			{_m_frame_cache.hits() - _m_loop_cache_hits},
+			{_m_frame_cache.misses() - _m_loop_cache_misses},
+			{_m_loop_start},
+			{loop_stop},
+			{_m_max_lateness},
+		}});
+
+		_m_loop_samples = 0;
+		_m_loop_images = 0;
+		_m_loop_cache_hits = _m_frame_cache.hits();
+		_m_loop_cache_misses = _m_frame_cache.misses();
+		_m_loop_start = loop_stop;
+		_m_max_lateness = std::chrono::nanoseconds{0};
+
+		const ullong last_time = rebase(finished.imu0->back().time);
+		++_m_sequence_idx;
+		if (_m_sequence_idx == _m_sequences.size()) {
+			_m_sequence_idx = 0;
+			++_m_loop_no;
+			if (_m_loop_count != 0 && _m_loop_no >= _m_loop_count) {
+				return false;
+			}
+		}
+
+		const sequence& next = _m_sequences[_m_sequence_idx];
+		_m_time_offset = static_cast<std::int64_t>(last_time + finished.imu_period)
+			- static_cast<std::int64_t>(next.imu0->front().time);
+		_m_imu_it = next.imu0->begin();
+		_m_cam0_it = next.cam0->begin();
+		_m_cam1_it = next.cam1->begin();
+		return true;
+	}
+
+	void on_ack(switchboard::ptr<const imu_cam_ack> ack) {
+		const std::lock_guard<std::mutex> lock{_m_ack_mutex};
+		ullong& acked = _m_acked[ack->plugin_id];
+		acked = std::max(acked, ack->dataset_time);
+	}
+
+	/**
+	 * @brief Whether the consumers have announced themselves (see `imu_cam_ack`), before the first sample.
+	 *
+	 * Waits until `_m_lockstep_consumers` have, or for `_m_lockstep_timeout`. Then, if fewer have,
+	 * it warns and waits on those only; if none have, it warns and replays on the wall clock instead.
+	 */
+	bool lockstep_consumers_checked() {
+		const std::lock_guard<std::mutex> lock{_m_ack_mutex};
+		if (_m_acked.size() < _m_lockstep_consumers) {
+			if (std::chrono::steady_clock::now() - _m_lockstep_start < _m_lockstep_timeout) {
+				return false;
+			}
+			std::cerr << "offline_imu_cam: ILLIXR_LOCKSTEP_CONSUMERS is " << _m_lockstep_consumers
+			          << ", but only " << _m_acked.size() << " plugin(s) acknowledge imu_cam";
+			if (_m_acked.empty()) {
+				std::cerr << "; replaying on the wall clock instead" << std::endl;
+				_m_lockstep = false;
+				// From here, not from thread setup, so the time spent waiting is not caught up in a burst
+				real_first_time = std::chrono::system_clock::now() - std::chrono::nanoseconds{dataset_now - dataset_first_time};
+			} else {
+				std::cerr << "; waiting on those only" << std::endl;
+				_m_lockstep_consumers = _m_acked.size();
+			}
+		}
+		_m_lockstep_checked = true;
+		_m_last_retired = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	/**
+	 * @brief Whether another sample may be published in lockstep mode.
+	 *
+	 * A sample stays in flight until every designated consumer has acknowledged it (or a later sample).
+	 * Until `_m_lockstep_consumers` distinct consumers have acknowledged something, nothing is retired.
+	 * If nothing is retired for `_m_lockstep_timeout` (a consumer stopped or fell behind), the oldest sample
+	 * is retired anyway, with a warning, so the replay never stalls for good.
+	 */
+	bool lockstep_ready() {
+		const std::lock_guard<std::mutex> lock{_m_ack_mutex};
+		const auto now = std::chrono::steady_clock::now();
+		if (_m_acked.size() >= _m_lockstep_consumers) {
+			ullong min_acked = std::numeric_limits<ullong>::max();
+			for (const auto& pair : _m_acked) {
+				min_acked = std::min(min_acked, pair.second);
+			}
+			while (!_m_in_flight.empty() && _m_in_flight.front() <= min_acked) {
+				_m_in_flight.pop_front();
+				_m_last_retired = now;
+			}
+		}
+		if (_m_in_flight.size() >= _m_lockstep_window && now - _m_last_retired >= _m_lockstep_timeout) {
+			std::cerr << "offline_imu_cam: sample " << _m_in_flight.front() << " not acknowledged after "
+			          << std::chrono::duration_cast<std::chrono::milliseconds>(_m_lockstep_timeout).count()
+			          << " ms; publishing the next one anyway" << std::endl;
+			_m_in_flight.pop_front();
+			_m_last_retired = now;
+		}
+		return _m_in_flight.size() < _m_lockstep_window;
+	}
+
+	// Keeps the streams referenced by _m_sequences alive
+	const std::shared_ptr<const dataset> _m_dataset;
+	const std::vector<sequence> _m_sequences;
+	timed_stream<dataset::imu_reading>::const_iterator _m_imu_it;
+	timed_stream<std::string>::const_iterator _m_cam0_it;
+	timed_stream<std::string>::const_iterator _m_cam1_it;
 	const std::shared_ptr<switchboard> _m_sb;
-	switchboard::writer<imu_cam_type> _m_imu_cam;
+	sensor_publisher _m_publisher;
 
 	// Timestamp of the first IMU value from the dataset
 	ullong dataset_first_time;
 	// UNIX timestamp when this component is initialized
 	time_type real_first_time;
-	// Current IMU timestamp
+	// Current IMU timestamp, rebased onto the timeline of the first sequence
 	ullong dataset_now;
 
 	record_coalescer imu_cam_log;
 	record_coalescer camera_cvtfmt_log;
+	record_coalescer loop_log {record_logger_};
+
+	// Looping replay. A loop is one pass over every sequence; 0 loops forever.
+	const std::size_t _m_loop_count;
+	std::size_t _m_loop_no {0};
+	std::size_t _m_sequence_idx {0};
+	// Added to dataset timestamps of the current sequence to keep published times monotonic
+	std::int64_t _m_time_offset {0};
+
+	frame_cache _m_frame_cache;
+
+	// Per-pass statistics, reset by advance_sequence
+	std::size_t _m_loop_samples {0};
+	std::size_t _m_loop_images {0};
+	std::size_t _m_loop_cache_hits {0};
+	std::size_t _m_loop_cache_misses {0};
+	std::chrono::high_resolution_clock::time_point _m_loop_start;
+	std::chrono::nanoseconds _m_max_lateness {0};
+
+	// Lockstep (backpressured) replay: publish only when consumers on `imu_cam_ack` keep up.
+	// Turned off, and the consumer count lowered, by lockstep_consumers_checked
+	bool _m_lockstep;
+	std::size_t _m_lockstep_consumers;
+	const std::size_t _m_lockstep_window;
+	// How long to wait for consumers to announce themselves, and for an in-flight sample to be acknowledged
+	const std::chrono::nanoseconds _m_lockstep_timeout;
+	std::chrono::steady_clock::time_point _m_lockstep_start;
+	bool _m_lockstep_checked {false};
+	std::chrono::steady_clock::time_point _m_last_retired;
+	std::mutex _m_ack_mutex;
+	std::unordered_map<plugin_id_t, ullong> _m_acked;
+	std::deque<ullong> _m_in_flight;
 };
 
 PLUGIN_MAIN(offline_imu_cam)
@@ -0,0 +1,125 @@
+/*
+ * Cost of one pose_lookup query, on two minutes of 200 Hz ground truth (EuRoC's rate) with some jitter.
+ *
+ * - upper_bound: what pose_lookup had, a binary search for the previous sample,
+ *   then correct_pose's alignment and axis swap in float (with JPL quaternion products)
+ * - table: ground_truth_table, aligned at load, indexed from the time and interpolated
+ *
+ * Each is queried at 120 Hz in order (as the render threads do) and at random times.
+ * The error is the largest position difference from the exact (interpolated) pose at the query time.
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "common/jpl_quaternion.hpp"
+#include "../ground_truth_table.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	constexpr ullong period_ns = 5000000;
+	constexpr std::size_t samples = 24000;
+	constexpr int queries = 2000000;
+
+	// Walking a 1 m circle once every 10 s, turning with it
+	pose_type truth(double t) {
+		const double angle = 2. * M_PI * t / 10.;
+		return pose_type{
+			time_type{},
+			Eigen::Vector3f{float(std::cos(angle)), float(std::sin(angle)), 1.6f},
+			Eigen::Quaternionf{Eigen::AngleAxisf{float(angle), Eigen::Vector3f::UnitZ()}},
+		};
+	}
+
+	// The alignment correct_pose applied per query
+	struct alignment {
+		Eigen::Vector3f init_pos_offset {0.5f, -1.f, 0.2f};
+		Eigen::Matrix3f align_rot {Eigen::AngleAxisf{0.1f, Eigen::Vector3f::UnitZ()}.toRotationMatrix()};
+		Eigen::Vector3f align_trans {0.01f, 0.02f, 0.f};
+		Eigen::Vector4f align_quat {Eigen::Vector4f{0.f, 0.f, 0.05f, 1.f}.normalized()};
+		float align_scale = 1.f;
+
+		pose_type correct_pose(const pose_type& pose) const {
+			pose_type swapped_pose;
+			const Eigen::Vector3f position = align_scale * align_rot * (pose.position - init_pos_offset) + align_trans;
+			const Eigen::Vector4f quat_in = {pose.orientation.x(), pose.orientation.y(), pose.orientation.z(), pose.orientation.w()};
+			const Eigen::Vector4f quat_out = quat_multiply(quat_in, quat_inverse(align_quat));
+			swapped_pose.position.x() = -position.y();
+			swapped_pose.position.y() = position.z();
+			swapped_pose.position.z() = -position.x();
+			swapped_pose.orientation = Eigen::Quaternionf{quat_out(3), -quat_out(1), quat_out(2), -quat_out(0)};
+			return swapped_pose;
+		}
+	};
+
+	// Keep a result from being optimized out
+	template <typename T>
+	inline void escape(const T& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	void compare(const char* name, const timed_stream<pose_type>& data, const ground_truth_table& table, const alignment& align,
+	             const std::vector<ullong>& times) {
+		auto begin = std::chrono::steady_clock::now();
+		for (const ullong time : times) {
+			auto row = data.upper_bound(time);
+			if (row != data.begin()) {
+				row--;
+			}
+			escape(align.correct_pose(row->value));
+		}
+		const double upper_bound_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / double(times.size());
+
+		begin = std::chrono::steady_clock::now();
+		for (const ullong time : times) {
+			escape(table.at(time));
+		}
+		const double table_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / double(times.size());
+
+		double upper_bound_error = 0;
+		double table_error = 0;
+		for (std::size_t i = 0; i < times.size(); i += 97) {
+			const Eigen::Vector3f exact = align.correct_pose(truth(double(times[i]) / 1e9)).position;
+			auto row = data.upper_bound(times[i]);
+			row--;
+			upper_bound_error = std::max(upper_bound_error, double((align.correct_pose(row->value).position - exact).norm()));
+			table_error = std::max(table_error, double((table.at(times[i]).position - exact).norm()));
+		}
+		std::printf("%-12s %14.1f %10.1f %10.2fx %16.2g %12.2g\n", name, upper_bound_ns, table_ns, upper_bound_ns / table_ns, upper_bound_error, table_error);
+	}
+
+}
+
+int main() {
+	std::mt19937_64 rng {1};
+	std::uniform_int_distribution<long> jitter {-20000, 20000};
+
+	std::vector<timed_stream<pose_type>::entry> entries;
+	for (std::size_t i = 0; i < samples; i++) {
+		const ullong time = i * period_ns + ullong(jitter(rng) + 20000);
+		entries.push_back({time, truth(double(time) / 1e9)});
+	}
+	const timed_stream<pose_type> data {std::move(entries)};
+	const alignment align;
+	const ground_truth_table table {data, [&align](const pose_type& pose) { return align.correct_pose(pose); }};
+
+	const ullong span = data.back().time - data.front().time;
+	std::vector<ullong> in_order;
+	std::vector<ullong> random;
+	std::uniform_int_distribution<ullong> anywhere {data.front().time, data.back().time};
+	for (int q = 0; q < queries; q++) {
+		in_order.push_back(data.front().time + (ullong(q) * 8333333) % span);
+		random.push_back(anywhere(rng));
+	}
+
+	std::printf("ns per lookup, %zu samples at 200 Hz\n\n", samples);
+	std::printf("%-12s %14s %10s %11s %16s %12s\n", "queries", "upper_bound", "table", "speedup", "upper_bound err", "table err");
+	compare("120 Hz", data, table, align, in_order);
+	compare("random", data, table, align, random);
+	return 0;
+}
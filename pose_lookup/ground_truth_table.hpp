@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "common/data_format.hpp"
+#include "common/dataset.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Ground-truth poses, interpolated at any time in constant time.
+	 *
+	 * Each pose is transformed once, at load (by @p transform, e.g. pose_lookup's alignment and axis swap),
+	 * and stored as one array per component. Datasets record ground truth at a nearly uniform rate,
+	 * so a lookup starts from the index its time would have at the average rate, or from the
+	 * previous lookup's (queries mostly move forward by a frame), and only steps over the odd gap.
+	 * Positions are interpolated linearly and orientations with slerp.
+	 *
+	 * Times are the dataset's (ns). Lookups are thread-safe; the shared hint is only a starting point.
+	 */
+	class ground_truth_table {
+	public:
+		/// @param stream must not be empty
+		template <typename Transform>
+		ground_truth_table(const timed_stream<pose_type>& stream, Transform&& transform) {
+			_m_time.reserve(stream.size());
+			for (std::vector<float>* component : {&_m_px, &_m_py, &_m_pz, &_m_qw, &_m_qx, &_m_qy, &_m_qz}) {
+				component->reserve(stream.size());
+			}
+			for (const auto& entry : stream) {
+				const pose_type pose = transform(entry.value);
+				_m_time.push_back(entry.time);
+				_m_px.push_back(pose.position.x());
+				_m_py.push_back(pose.position.y());
+				_m_pz.push_back(pose.position.z());
+				_m_qw.push_back(pose.orientation.w());
+				_m_qx.push_back(pose.orientation.x());
+				_m_qy.push_back(pose.orientation.y());
+				_m_qz.push_back(pose.orientation.z());
+			}
+			if (_m_time.size() > 1) {
+				_m_samples_per_ns = double(_m_time.size() - 1) / double(_m_time.back() - _m_time.front());
+			}
+		}
+
+		ullong front_time() const { return _m_time.front(); }
+		ullong back_time() const { return _m_time.back(); }
+
+		/// The pose at @p time, or at the first or last sample outside of them. `sensor_time` is unset.
+		pose_type at(ullong time) const {
+			if (time <= _m_time.front()) {
+				return sample(0);
+			}
+			if (time >= _m_time.back()) {
+				return sample(_m_time.size() - 1);
+			}
+
+			const std::size_t i = index(time);
+			const float s = float(time - _m_time[i]) / float(_m_time[i + 1] - _m_time[i]);
+			return pose_type{
+				time_type{},
+				(1.f - s) * position(i) + s * position(i + 1),
+				orientation(i).slerp(s, orientation(i + 1)),
+			};
+		}
+
+	private:
+		// The last sample at or before @p time, which is strictly between the first and last samples' times
+		std::size_t index(ullong time) const {
+			std::size_t i = _m_hint.load(std::memory_order_relaxed);
+			if (!brackets(i, time)) {
+				if (brackets(i + 1, time)) {
+					i++;
+				} else {
+					i = std::min(std::size_t(double(time - _m_time.front()) * _m_samples_per_ns), _m_time.size() - 2);
+					while (_m_time[i] > time) {
+						i--;
+					}
+					while (_m_time[i + 1] <= time) {
+						i++;
+					}
+				}
+				_m_hint.store(i, std::memory_order_relaxed);
+			}
+			return i;
+		}
+
+		bool brackets(std::size_t i, ullong time) const {
+			return i + 1 < _m_time.size() && _m_time[i] <= time && time < _m_time[i + 1];
+		}
+
+		Eigen::Vector3f position(std::size_t i) const {
+			return Eigen::Vector3f{_m_px[i], _m_py[i], _m_pz[i]};
+		}
+
+		Eigen::Quaternionf orientation(std::size_t i) const {
+			return Eigen::Quaternionf{_m_qw[i], _m_qx[i], _m_qy[i], _m_qz[i]};
+		}
+
+		pose_type sample(std::size_t i) const {
+			return pose_type{time_type{}, position(i), orientation(i)};
+		}
+
+		std::vector<ullong> _m_time;
+		std::vector<float> _m_px, _m_py, _m_pz;
+		std::vector<float> _m_qw, _m_qx, _m_qy, _m_qz;
+		double _m_samples_per_ns = 0;
+
+		mutable std::atomic<std::size_t> _m_hint {0};
+	};
+
+}
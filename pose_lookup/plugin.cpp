@@ -1,14 +1,17 @@
+#include <algorithm>
 #include <cmath>
-#include <shared_mutex>
+#include <optional>
 #include "common/phonebook.hpp"
 #include "common/pose_prediction.hpp"
 #include "common/data_format.hpp"
 #include "common/plugin.hpp"
 #include "common/global_module_defs.hpp"
+#include "common/dataset.hpp"
+#include "common/orientation_offset.hpp"
 
 
+#include "ground_truth_table.hpp"
 #include "utils.hpp"
-#include "data_loading.hpp"
 
 using namespace ILLIXR;
 
@@ -17,9 +20,9 @@ class pose_lookup_impl : public pose_prediction {
 public:
     pose_lookup_impl(const phonebook* const pb)
 		: sb{pb->lookup_impl<switchboard>()}
-        , _m_sensor_data{load_data()}
-        , _m_sensor_data_it{_m_sensor_data.cbegin()}
-        , dataset_first_time{_m_sensor_data_it->first}
+        , _m_dataset{pb->lookup_impl<dataset>()}
+        , _m_sensor_data{_m_dataset->ground_truth(0)}
+        , dataset_first_time{_m_sensor_data.front().time}
         , _m_start_of_time{std::chrono::high_resolution_clock::now()}
         , _m_vsync_estimate{sb->get_reader<switchboard::event_wrapper<time_type>>("vsync_estimate")}
         /// TODO: Set with #198
@@ -34,9 +37,11 @@ public:
         if (enable_alignment)
             load_align_parameters(path_to_alignment, align_rot, align_trans, align_quat, align_scale);
         // Read position data of the first frame
-        init_pos_offset = _m_sensor_data.cbegin()->second.position;
+        init_pos_offset = _m_sensor_data.front().value.position;
+        combine_transforms();
+        _m_table.emplace(_m_sensor_data, [this](const pose_type& pose) { return aligned_pose(pose); });
 
-        auto newoffset = correct_pose(_m_sensor_data.begin()->second).orientation;
+        auto newoffset = correct_pose(_m_sensor_data.front().value).orientation;
         set_offset(newoffset);
     }
 
@@ -63,110 +68,58 @@ public:
     }
 
     virtual Eigen::Quaternionf get_offset() override {
-        return offset;
+        return _m_offset.get();
     }
 
     virtual pose_type correct_pose(const pose_type pose) const override {
-        pose_type swapped_pose;
+        pose_type swapped_pose = aligned_pose(pose);
+        swapped_pose.orientation = apply_offset(swapped_pose.orientation);
+        return swapped_pose;
+    }
 
-        // Step 1: Compensate starting point to (0, 0, 0), pos only
-        auto input_pose = pose_type {
+    // correct_pose without the offset, which is the only part that can change after load
+    pose_type aligned_pose(const pose_type& pose) const {
+        const Eigen::Quaterniond orientation = _m_orientation_left * pose.orientation.cast<double>() * _m_orientation_right;
+        return pose_type{
             pose.sensor_time,
-            Eigen::Vector3f{
-                pose.position(0) - init_pos_offset(0),
-                pose.position(1) - init_pos_offset(1),
-                pose.position(2) - init_pos_offset(2),
-            },
-            pose.orientation
+            (_m_position_transform * pose.position.cast<double>()).cast<float>(),
+            orientation.cast<float>(),
         };
-
-        if (enable_alignment)
-        {
-            // Step 2: Apply estimated alignment parameters
-            // Step 2.1: Position alignment
-            input_pose.position = align_scale * align_rot * input_pose.position + align_trans;
-
-            // Step 2.2: Orientation alignment
-            Eigen::Vector4f quat_in = {pose.orientation.x(), pose.orientation.y(), pose.orientation.z(), pose.orientation.w()};
-            Eigen::Vector4f quat_out = ori_multiply(quat_in, ori_inv(align_quat));
-            input_pose.orientation.x() = quat_out(0);
-            input_pose.orientation.y() = quat_out(1);
-            input_pose.orientation.z() = quat_out(2);
-            input_pose.orientation.w() = quat_out(3);
-        }
-
-        // Step 3: Swap axis for both position and orientation
-        // Step 3.1: Swap for position
-        // This uses the OpenVINS standard output coordinate system.
-        // This is a mapping between the OV coordinate system and the OpenGL system.
-        swapped_pose.position.x() = -input_pose.position.y();
-        swapped_pose.position.y() = input_pose.position.z();
-        swapped_pose.position.z() = -input_pose.position.x();
-
-        // Step 3.2: Swap for orientation
-        // There is a slight issue with the orientations: basically,
-        // the output orientation acts as though the "top of the head" is the
-        // forward direction, and the "eye direction" is the up direction.
-        Eigen::Quaternionf raw_o (input_pose.orientation.w(), -input_pose.orientation.y(), input_pose.orientation.z(), -input_pose.orientation.x());
-
-        swapped_pose.orientation = apply_offset(raw_o);
-
-        return swapped_pose;
     }
 
     virtual void set_offset(const Eigen::Quaternionf& raw_o_times_offset) override{
-        std::unique_lock lock {offset_mutex};
-        Eigen::Quaternionf raw_o = raw_o_times_offset * offset.inverse();
-        //std::cout << "pose_prediction: set_offset" << std::endl;
-        offset = raw_o.inverse();
+        _m_offset.set(raw_o_times_offset);
     }
 
     Eigen::Quaternionf apply_offset(const Eigen::Quaternionf& orientation) const {
-        std::shared_lock lock {offset_mutex};
-        return orientation * offset;
+        return _m_offset.apply(orientation);
     }
 
     virtual fast_pose_type get_fast_pose(time_type time) const override {
         ullong lookup_time = std::chrono::nanoseconds(time - _m_start_of_time).count() + dataset_first_time;
 
-        auto nearest_row = _m_sensor_data.upper_bound(lookup_time);
-
-        if (nearest_row == _m_sensor_data.cend()) {
 #ifndef NDEBUG
+        if (lookup_time > _m_table->back_time() || lookup_time < _m_table->front_time()) {
 			std::cerr << "Time "
 			          << lookup_time
                       << " ("
 			          << std::chrono::nanoseconds(time - _m_start_of_time).count()
 			          << " + "
 			          << dataset_first_time
-			          << ") after last datum "
-			          << _m_sensor_data.rbegin()->first
+			          << ") "
+			          << (lookup_time > _m_table->back_time() ? "after last datum " : "before first datum ")
+			          << (lookup_time > _m_table->back_time() ? _m_table->back_time() : _m_table->front_time())
 			          << std::endl;
-#endif
-            nearest_row--;
-        } else if (nearest_row == _m_sensor_data.cbegin()) {
-#ifndef NDEBUG
-			std::cerr << "Time "
-			          << lookup_time
-			          << " ("
-			          << std::chrono::nanoseconds(time - _m_start_of_time).count()
-			          << " + "
-			          << dataset_first_time
-			          << ") before first datum "
-			          << _m_sensor_data.cbegin()->first
-			          << std::endl;
-#endif
-        } else {
-            // "std::map::upper_bound" returns an iterator to the first pair whose key is GREATER than the argument.
-            // I already know we aren't at the begin()
-            // So I will decrement nearest_row here.
-            nearest_row--;
         }
+#endif
 
-        auto looked_up_pose = nearest_row->second;
-        looked_up_pose.sensor_time = _m_start_of_time + std::chrono::nanoseconds{nearest_row->first - dataset_first_time};
+        // Interpolated (and clamped to the ground truth's span), already aligned; only the offset is left
+        pose_type looked_up_pose = _m_table->at(lookup_time);
+        const ullong sensor_time = std::clamp(lookup_time, _m_table->front_time(), _m_table->back_time());
+        looked_up_pose.sensor_time = _m_start_of_time + std::chrono::nanoseconds{sensor_time - dataset_first_time};
+        looked_up_pose.orientation = apply_offset(looked_up_pose.orientation);
         return fast_pose_type{
-            .pose = correct_pose(looked_up_pose),
+            .pose = looked_up_pose,
             .predict_computed_time = std::chrono::system_clock::now(),
             .predict_target_time = time
         };
@@ -175,11 +128,11 @@ public:
 
 private:
     const std::shared_ptr<switchboard> sb;
-    mutable Eigen::Quaternionf offset {Eigen::Quaternionf::Identity()};
-    mutable std::shared_mutex offset_mutex;
+    // Read on every query without locking
+    mutable orientation_offset _m_offset;
 
-	const std::map<ullong, sensor_types> _m_sensor_data;
-    std::map<ullong, sensor_types>::const_iterator _m_sensor_data_it;
+    const std::shared_ptr<const dataset> _m_dataset;
+	const timed_stream<pose_type>& _m_sensor_data;
 	ullong dataset_first_time;
 	time_type _m_start_of_time;
 	switchboard::reader<switchboard::event_wrapper<time_type>> _m_vsync_estimate;
@@ -191,6 +144,41 @@ private:
     Eigen::Vector4f align_quat;
     double align_scale;
     std::string path_to_alignment;
+
+    // Steps 1-3 of correct_pose combined, in double:
+    // position -> transform * position, orientation -> left * orientation * right
+    Eigen::Affine3d _m_position_transform;
+    Eigen::Quaterniond _m_orientation_left;
+    Eigen::Quaterniond _m_orientation_right;
+
+    // The ground truth, through the transforms above
+    std::optional<ground_truth_table> _m_table;
+
+    void combine_transforms() {
+        // Step 3's axis swap, (x, y, z) -> (-y, z, -x), maps the OpenVINS coordinate system to OpenGL's.
+        // It is a rotation; the orientation's swap, (w, x, y, z) -> (w, -y, z, -x), is conjugation by it.
+        Eigen::Matrix3d swap;
+        swap << 0, -1, 0,
+                0,  0, 1,
+               -1,  0, 0;
+        const Eigen::Quaterniond swap_quat {swap};
+
+        // Step 1
+        _m_position_transform = Eigen::Translation3d{-init_pos_offset.cast<double>()};
+        Eigen::Quaterniond align_inverse = Eigen::Quaterniond::Identity();
+        if (enable_alignment) {
+            // Step 2.1
+            _m_position_transform = Eigen::Translation3d{align_trans.cast<double>()}
+                * Eigen::Affine3d{align_scale * align_rot.cast<double>()}
+                * _m_position_transform;
+            // Step 2.2: right-multiplying by the inverse in JPL is left-multiplying by it in Hamilton
+            align_inverse = Eigen::Quaterniond{align_quat(3), align_quat(0), align_quat(1), align_quat(2)}.inverse();
+        }
+        // Step 3
+        _m_position_transform = Eigen::Affine3d{swap} * _m_position_transform;
+        _m_orientation_left = swap_quat * align_inverse;
+        _m_orientation_right = swap_quat.inverse();
+    }
 };
 
 
@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+#include "../ground_truth_table.hpp"
+
+namespace ILLIXR {
+
+class GroundTruthTableTest : public ::testing::Test {
+protected:
+	// Moving at 1 m/s along x and turning at 1 rad/s about z
+	static pose_type truth(ullong time_ns) {
+		const float s = float(time_ns) / 1e9f;
+		return pose_type{time_type{}, Eigen::Vector3f{s, 0.f, 0.f}, Eigen::Quaternionf{Eigen::AngleAxisf{s, Eigen::Vector3f::UnitZ()}}};
+	}
+
+	// Every 5 ms, except for a gap between 100 and 200 ms
+	static timed_stream<pose_type> stream() {
+		std::vector<timed_stream<pose_type>::entry> entries;
+		for (ullong ms = 0; ms <= 500; ms += 5) {
+			if (ms <= 100 || ms >= 200) {
+				entries.push_back({ms * 1000000, truth(ms * 1000000)});
+			}
+		}
+		return timed_stream<pose_type>{std::move(entries)};
+	}
+
+	static pose_type unchanged(const pose_type& pose) {
+		return pose;
+	}
+
+	static void expect_truth(const pose_type& pose, ullong time_ns) {
+		EXPECT_TRUE(pose.position.isApprox(truth(time_ns).position, 1e-5f)) << time_ns;
+		EXPECT_LT(pose.orientation.angularDistance(truth(time_ns).orientation), 1e-5f) << time_ns;
+	}
+};
+
+TEST_F(GroundTruthTableTest, InterpolatesBetweenSamples) {
+	const timed_stream<pose_type> data = stream();
+	const ground_truth_table table {data, unchanged};
+	ASSERT_EQ(table.front_time(), 0U);
+	ASSERT_EQ(table.back_time(), 500000000U);
+
+	// Forwards at 120 Hz, across the gap too, then jumping back
+	for (ullong time_ns = 0; time_ns <= 500000000; time_ns += 8333333) {
+		expect_truth(table.at(time_ns), time_ns);
+	}
+	expect_truth(table.at(150000000), 150000000);
+	expect_truth(table.at(2500000), 2500000);
+	expect_truth(table.at(400000000), 400000000);
+}
+
+TEST_F(GroundTruthTableTest, ClampsOutsideOfTheData) {
+	const timed_stream<pose_type> data = stream();
+	const ground_truth_table table {data, unchanged};
+	expect_truth(table.at(600000000), 500000000);
+
+	std::vector<timed_stream<pose_type>::entry> late;
+	late.push_back({1000, truth(1000)});
+	late.push_back({2000, truth(2000)});
+	const ground_truth_table late_table {timed_stream<pose_type>{std::move(late)}, unchanged};
+	expect_truth(late_table.at(0), 1000);
+}
+
+TEST_F(GroundTruthTableTest, TransformsAtLoad) {
+	const timed_stream<pose_type> data = stream();
+	int calls = 0;
+	const ground_truth_table table {data, [&calls](const pose_type& pose) {
+		calls++;
+		return pose_type{pose.sensor_time, pose.position + Eigen::Vector3f{0.f, 1.f, 0.f}, pose.orientation};
+	}};
+	ASSERT_EQ(calls, int(data.size()));
+
+	ASSERT_TRUE(table.at(42000000).position.isApprox(Eigen::Vector3f{0.042f, 1.f, 0.f}, 1e-5f));
+	ASSERT_EQ(calls, int(data.size()));
+}
+
+}
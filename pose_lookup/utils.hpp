@@ -5,42 +5,6 @@
 #include "common/error_util.hpp"
 
 
-Eigen::Matrix<float, 3, 3> skew_x(const Eigen::Matrix<float, 3, 1> &w)
-{
-	Eigen::Matrix<float, 3, 3> w_x;
-	w_x << 0, -w(2), w(1),
-		w(2), 0, -w(0),
-		-w(1), w(0), 0;
-	return w_x;
-}
-
-Eigen::Matrix<float, 4, 1> ori_inv(Eigen::Matrix<float, 4, 1> q)
-{
-	Eigen::Matrix<float, 4, 1> qinv;
-	qinv.block(0, 0, 3, 1) = -q.block(0, 0, 3, 1);
-	qinv(3, 0) = q(3, 0);
-	return qinv;
-}
-
-Eigen::Matrix<float, 4, 1> ori_multiply(const Eigen::Matrix<float, 4, 1> &q, const Eigen::Matrix<float, 4, 1> &p)
-{
-	Eigen::Matrix<float, 4, 1> q_t;
-	Eigen::Matrix<float, 4, 4> Qm;
-	// Create big L matrix
-	Qm.block(0, 0, 3, 3) = q(3, 0) * Eigen::MatrixXf::Identity(3, 3) - skew_x(q.block(0, 0, 3, 1));
-	Qm.block(0, 3, 3, 1) = q.block(0, 0, 3, 1);
-	Qm.block(3, 0, 1, 3) = -q.block(0, 0, 3, 1).transpose();
-	Qm(3, 3) = q(3, 0);
-	q_t = Qm * p;
-	// Ensure unique by forcing q_4 to be >0
-	if (q_t(3, 0) < 0)
-	{
-		q_t *= -1;
-	}
-	// Normalize and return
-	return q_t / q_t.norm();
-}
-
 void read_line(std::string stream, std::deque<float> &parameters)
 {
 	const char* split = " ";
@@ -0,0 +1,173 @@
+/*
+ * Cost of predicting several poses from one query (get_fast_poses) against as many get_fast_pose calls,
+ * e.g. timewarp's start and end of scanout (2) or those for both eyes (4).
+ *
+ * - separate calls: each reads imu_raw and the slow pose from their topics, and runs the whole RK4 step
+ *   (as pose_prediction did before rk4_predictor)
+ * - get_fast_poses: one read of each topic and one rk4_predictor, then a predict per time
+ *
+ * Topic reads are modelled as switchboard's get_ro_nullable is: a shared_ptr copy and a dynamic_pointer_cast.
+ * The difference between the two is the largest position and orientation error between them.
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "../rk4_predictor.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	constexpr int queries = 200000;
+
+	// pose_prediction's predict_mean_rk4 before rk4_predictor, everything computed per call
+	Eigen::Matrix<double,13,1> predict_mean_rk4(double dt, const imu_raw_type& imu_raw) {
+		Eigen::Vector3d w_hat =imu_raw.w_hat;
+		Eigen::Vector3d a_hat = imu_raw.a_hat;
+		Eigen::Vector3d w_alpha = (imu_raw.w_hat2-imu_raw.w_hat)/dt;
+		Eigen::Vector3d a_jerk = (imu_raw.a_hat2-imu_raw.a_hat)/dt;
+
+		Eigen::Quaterniond temp_quat = imu_raw.quat;
+		Eigen::Vector4d q_0 = {temp_quat.x(), temp_quat.y(), temp_quat.z(), temp_quat.w()};
+		Eigen::Vector3d p_0 = imu_raw.pos;
+		Eigen::Vector3d v_0 = imu_raw.vel;
+
+		Eigen::Vector4d dq_0 = {0,0,0,1};
+		Eigen::Vector4d q0_dot = 0.5*Omega(w_hat)*dq_0;
+		Eigen::Vector3d p0_dot = v_0;
+		Eigen::Matrix3d R_Gto0 = quat_2_Rot(quat_multiply(dq_0,q_0));
+		Eigen::Vector3d v0_dot = R_Gto0.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+		Eigen::Vector4d k1_q = q0_dot*dt;
+		Eigen::Vector3d k1_p = p0_dot*dt;
+		Eigen::Vector3d k1_v = v0_dot*dt;
+
+		w_hat += 0.5*w_alpha*dt;
+		a_hat += 0.5*a_jerk*dt;
+
+		Eigen::Vector4d dq_1 = quatnorm(dq_0+0.5*k1_q);
+		Eigen::Vector3d v_1 = v_0+0.5*k1_v;
+
+		Eigen::Vector4d q1_dot = 0.5*Omega(w_hat)*dq_1;
+		Eigen::Vector3d p1_dot = v_1;
+		Eigen::Matrix3d R_Gto1 = quat_2_Rot(quat_multiply(dq_1,q_0));
+		Eigen::Vector3d v1_dot = R_Gto1.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+		Eigen::Vector4d k2_q = q1_dot*dt;
+		Eigen::Vector3d k2_p = p1_dot*dt;
+		Eigen::Vector3d k2_v = v1_dot*dt;
+
+		Eigen::Vector4d dq_2 = quatnorm(dq_0+0.5*k2_q);
+		Eigen::Vector3d v_2 = v_0+0.5*k2_v;
+
+		Eigen::Vector4d q2_dot = 0.5*Omega(w_hat)*dq_2;
+		Eigen::Vector3d p2_dot = v_2;
+		Eigen::Matrix3d R_Gto2 = quat_2_Rot(quat_multiply(dq_2,q_0));
+		Eigen::Vector3d v2_dot = R_Gto2.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+		Eigen::Vector4d k3_q = q2_dot*dt;
+		Eigen::Vector3d k3_p = p2_dot*dt;
+		Eigen::Vector3d k3_v = v2_dot*dt;
+
+		w_hat += 0.5*w_alpha*dt;
+		a_hat += 0.5*a_jerk*dt;
+
+		Eigen::Vector4d dq_3 = quatnorm(dq_0+k3_q);
+		Eigen::Vector3d v_3 = v_0+k3_v;
+
+		Eigen::Vector4d q3_dot = 0.5*Omega(w_hat)*dq_3;
+		Eigen::Vector3d p3_dot = v_3;
+		Eigen::Matrix3d R_Gto3 = quat_2_Rot(quat_multiply(dq_3,q_0));
+		Eigen::Vector3d v3_dot = R_Gto3.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+		Eigen::Vector4d k4_q = q3_dot*dt;
+		Eigen::Vector3d k4_p = p3_dot*dt;
+		Eigen::Vector3d k4_v = v3_dot*dt;
+
+		Eigen::Matrix<double,13,1> state_plus = Eigen::Matrix<double,13,1>::Zero();
+		Eigen::Vector4d dq = quatnorm(dq_0+(1.0/6.0)*k1_q+(1.0/3.0)*k2_q+(1.0/3.0)*k3_q+(1.0/6.0)*k4_q);
+		state_plus.block(0,0,4,1) = quat_multiply(dq, q_0);
+		state_plus.block(4,0,3,1) = p_0+(1.0/6.0)*k1_p+(1.0/3.0)*k2_p+(1.0/3.0)*k3_p+(1.0/6.0)*k4_p;
+		state_plus.block(7,0,3,1) = v_0+(1.0/6.0)*k1_v+(1.0/3.0)*k2_v+(1.0/3.0)*k3_v+(1.0/6.0)*k4_v;
+		return state_plus;
+	}
+
+	// A topic's latest event, and reading it as get_ro_nullable does
+	using topic = std::shared_ptr<const switchboard::event>;
+
+	template <typename T>
+	std::shared_ptr<const T> read(const topic& latest) {
+		const topic copy = latest;
+		return std::dynamic_pointer_cast<const T>(copy);
+	}
+
+	// Keep a result from being optimized out
+	template <typename T>
+	inline void escape(const T& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	double ns_per_query(const std::chrono::steady_clock::time_point begin) {
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / double(queries);
+	}
+
+	void compare(const topic& imu_raw_topic, const topic& slow_pose_topic, const std::vector<double>& dts) {
+		std::vector<Eigen::Matrix<double,13,1>> separate (dts.size());
+		std::vector<Eigen::Matrix<double,13,1>> batched (dts.size());
+
+		auto begin = std::chrono::steady_clock::now();
+		for (int q = 0; q < queries; q++) {
+			for (std::size_t i = 0; i < dts.size(); i++) {
+				escape(read<pose_type>(slow_pose_topic));
+				separate[i] = predict_mean_rk4(dts[i], *read<imu_raw_type>(imu_raw_topic));
+				escape(separate[i]);
+			}
+		}
+		const double separate_ns = ns_per_query(begin);
+
+		begin = std::chrono::steady_clock::now();
+		for (int q = 0; q < queries; q++) {
+			escape(read<pose_type>(slow_pose_topic));
+			const rk4_predictor predictor {*read<imu_raw_type>(imu_raw_topic)};
+			for (std::size_t i = 0; i < dts.size(); i++) {
+				batched[i] = predictor.predict(dts[i]);
+				escape(batched[i]);
+			}
+		}
+		const double batched_ns = ns_per_query(begin);
+
+		double dp = 0;
+		double dq = 0;
+		for (std::size_t i = 0; i < dts.size(); i++) {
+			dp = std::max(dp, (separate[i].segment<3>(4) - batched[i].segment<3>(4)).norm());
+			dq = std::max(dq, (separate[i].head<4>() - batched[i].head<4>()).norm());
+		}
+		std::printf("%8zu %16.1f %16.1f %10.2fx %12.2g %12.2g\n", dts.size(), separate_ns, batched_ns, separate_ns / batched_ns, dp, dq);
+	}
+
+}
+
+int main() {
+	const topic imu_raw_topic = std::make_shared<const imu_raw_type>(
+		Eigen::Vector3d{0.3, -0.2, 0.1},
+		Eigen::Vector3d{0.5, 0.4, 9.9},
+		Eigen::Vector3d{0.32, -0.21, 0.12},
+		Eigen::Vector3d{0.45, 0.42, 9.85},
+		Eigen::Vector3d{1., 2., 1.5},
+		Eigen::Vector3d{0.2, -0.1, 0.05},
+		Eigen::Quaterniond{Eigen::AngleAxisd{0.4, Eigen::Vector3d{1., 2., 3.}.normalized()}},
+		time_type{}
+	);
+	const topic slow_pose_topic = std::make_shared<const pose_type>();
+
+	std::printf("ns per query of N poses, predicting 8-20 ms ahead\n\n");
+	std::printf("%8s %16s %16s %11s %12s %12s\n", "N", "separate calls", "get_fast_poses", "speedup", "max dp (m)", "max dq");
+	compare(imu_raw_topic, slow_pose_topic, {0.008});
+	compare(imu_raw_topic, slow_pose_topic, {0.008, 0.0125});
+	compare(imu_raw_topic, slow_pose_topic, {0.008, 0.0125, 0.0155, 0.020});
+	return 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common/data_format.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Filtered display timing, from the `mtp` samples timewarp publishes after each swap.
+	 *
+	 * - `vsync_correction`: how much later than the `vsync_estimate` a frame actually reaches the display.
+	 *   pose_prediction adds it to the estimate, so poses are predicted for when they are shown.
+	 * - `predict_to_display`: how long after a prediction its frame is displayed, to target without an estimate.
+	 *
+	 * Both are exponential moving averages with weight @p alpha on the newest sample, starting at zero
+	 * (so the first frames, which are often late, only move them a little).
+	 * `update` is called from one thread (switchboard's, for the `mtp` topic); the getters from any.
+	 */
+	class display_latency {
+	public:
+		explicit display_latency(double alpha)
+			: _m_alpha{alpha}
+		{ }
+
+		struct errors {
+			// Display time minus the vsync estimate, which the target would have been without a correction
+			std::chrono::nanoseconds uncorrected;
+			// Display time minus the pose's actual target
+			std::chrono::nanoseconds residual;
+		};
+
+		errors update(const mtp_sample& sample) {
+			const std::chrono::nanoseconds uncorrected = sample.display_time - sample.vsync_estimate;
+			const std::chrono::nanoseconds residual = sample.display_time - sample.pose.predict_target_time;
+			const std::chrono::nanoseconds predict_to_display = sample.display_time - sample.pose.predict_computed_time;
+
+			_m_vsync_correction_ns += _m_alpha * (double(uncorrected.count()) - _m_vsync_correction_ns);
+			_m_predict_to_display_ns += _m_alpha * (double(predict_to_display.count()) - _m_predict_to_display_ns);
+			_m_vsync_correction.store(std::int64_t(_m_vsync_correction_ns), std::memory_order_relaxed);
+			_m_predict_to_display.store(std::int64_t(_m_predict_to_display_ns), std::memory_order_relaxed);
+
+			return errors{uncorrected, residual};
+		}
+
+		std::chrono::nanoseconds vsync_correction() const {
+			return std::chrono::nanoseconds{_m_vsync_correction.load(std::memory_order_relaxed)};
+		}
+
+		std::chrono::nanoseconds predict_to_display() const {
+			return std::chrono::nanoseconds{_m_predict_to_display.load(std::memory_order_relaxed)};
+		}
+
+	private:
+		const double _m_alpha;
+
+		// Only touched by update
+		double _m_vsync_correction_ns = 0;
+		double _m_predict_to_display_ns = 0;
+
+		std::atomic<std::int64_t> _m_vsync_correction {0};
+		std::atomic<std::int64_t> _m_predict_to_display {0};
+	};
+
+}
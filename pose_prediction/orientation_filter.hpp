@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <optional>
+
+#include "common/data_format.hpp"
+#include "common/seqlock.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief An IMU-only orientation estimate, which pose_prediction serves until VIO is up (or while it stalls).
+	 *
+	 * A complementary filter (Mahony's, without the integral term): the gyro is integrated, and while the
+	 * accelerometer measures about 1 g, the error between the up direction it measures and the estimated one
+	 * is fed back as extra angular velocity, with gain `gain` (1/s). Yaw is unobservable, and drifts with the gyro.
+	 *
+	 * Orientations are body-to-world (Hamilton), with world z up, like OpenVINS' poses once converted.
+	 * `update` is O(1) per sample and is called from one thread; readers copy the estimate out of a `seqlock`.
+	 */
+	class orientation_filter {
+	public:
+		struct estimate {
+			// Of the last IMU sample
+			time_type time;
+			Eigen::Quaternionf orientation;
+			// Body frame, rad/s
+			Eigen::Vector3f angular_velocity;
+		};
+
+		explicit orientation_filter(float gain)
+			: _m_gain{gain}
+		{ }
+
+		void update(time_type time, const Eigen::Vector3f& gyro, const Eigen::Vector3f& accel) {
+			const float accel_norm = accel.norm();
+			if (!_m_initialized) {
+				if (accel_norm < 1e-3f) {
+					return;
+				}
+				// Level from the first sample, with the smallest rotation (so an arbitrary yaw)
+				_m_orientation = Eigen::Quaternionf::FromTwoVectors(accel, Eigen::Vector3f::UnitZ());
+				_m_initialized = true;
+			} else {
+				const float dt = std::chrono::duration<float>(time - _m_time).count();
+				if (dt <= 0.f) {
+					return;
+				}
+
+				Eigen::Vector3f omega = gyro;
+				if (std::abs(accel_norm - gravity) < 0.2f * gravity) {
+					// Rotates the estimated up (in the body frame) towards the measured one
+					const Eigen::Vector3f measured_up = accel / accel_norm;
+					const Eigen::Vector3f estimated_up = _m_orientation.inverse() * Eigen::Vector3f::UnitZ();
+					omega += _m_gain * measured_up.cross(estimated_up);
+				}
+				_m_orientation = (_m_orientation * exp(omega * dt)).normalized();
+			}
+			_m_time = time;
+			_m_estimate.store(sample::from(time, _m_orientation, gyro));
+		}
+
+		/// The latest estimate, once there has been an IMU sample
+		std::optional<estimate> latest() const {
+			const sample s = _m_estimate.load();
+			if (!s.valid) {
+				return std::nullopt;
+			}
+			return s.to_estimate();
+		}
+
+		/// The orientation at @p target, turning at the last angular velocity
+		static Eigen::Quaternionf predict(const estimate& e, time_type target) {
+			const float dt = std::chrono::duration<float>(target - e.time).count();
+			return (e.orientation * exp(e.angular_velocity * dt)).normalized();
+		}
+
+	private:
+		static constexpr float gravity = 9.81f;
+
+		// The rotation by rotation vector @p v
+		static Eigen::Quaternionf exp(const Eigen::Vector3f& v) {
+			const float angle = v.norm();
+			if (angle < 1e-9f) {
+				return Eigen::Quaternionf::Identity();
+			}
+			return Eigen::Quaternionf{Eigen::AngleAxisf{angle, v / angle}};
+		}
+
+		// Trivially copyable, for the seqlock
+		struct sample {
+			bool valid;
+			time_type::rep time;
+			// w, x, y, z
+			float orientation[4];
+			float angular_velocity[3];
+
+			static sample from(time_type time, const Eigen::Quaternionf& q, const Eigen::Vector3f& w) {
+				return sample{true, time.time_since_epoch().count(), {q.w(), q.x(), q.y(), q.z()}, {w.x(), w.y(), w.z()}};
+			}
+
+			estimate to_estimate() const {
+				return estimate{
+					time_type{time_type::duration{time}},
+					Eigen::Quaternionf{orientation[0], orientation[1], orientation[2], orientation[3]},
+					Eigen::Vector3f{angular_velocity[0], angular_velocity[1], angular_velocity[2]},
+				};
+			}
+		};
+
+		const float _m_gain;
+
+		// Only touched by update
+		bool _m_initialized = false;
+		time_type _m_time;
+		Eigen::Quaternionf _m_orientation {Eigen::Quaternionf::Identity()};
+
+		seqlock<sample> _m_estimate {sample{}};
+	};
+
+}
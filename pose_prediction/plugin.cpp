@@ -1,33 +1,107 @@
-#include <shared_mutex>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
 #include <eigen3/Eigen/Dense>
 #include "common/phonebook.hpp"
 #include "common/pose_prediction.hpp"
 #include "common/data_format.hpp"
-#include "common/plugin.hpp"
+#include "common/threadloop.hpp"
+#include "common/lazy_imu_integrator.hpp"
+#include "common/orientation_offset.hpp"
+#include "display_latency.hpp"
+#include "orientation_filter.hpp"
+#include "pose_cache.hpp"
+#include "pose_handover.hpp"
+#include "pose_stream.hpp"
+#include "rk4_predictor.hpp"
 
 using namespace ILLIXR;
 
+const record_header pose_prediction_cache_record {
+    "pose_prediction_cache",
+    {
+        {"hits", typeid(std::size_t)},
+        {"misses", typeid(std::size_t)},
+    },
+};
+
+// One record per displayed frame: how far the display time was from the vsync estimate,
+// and from the target the pose was actually predicted for (after the horizon correction)
+const record_header pose_prediction_horizon_record {
+    "pose_prediction_horizon",
+    {
+        {"display_time", typeid(std::chrono::high_resolution_clock::time_point)},
+        {"uncorrected_error", typeid(std::chrono::nanoseconds)},
+        {"residual_error", typeid(std::chrono::nanoseconds)},
+        {"correction", typeid(std::chrono::nanoseconds)},
+    },
+};
+
 class pose_prediction_impl : public pose_prediction {
 public:
     pose_prediction_impl(const phonebook* const pb)
-        : sb{pb->lookup_impl<switchboard>()}
+        : pb{pb}
+        , sb{pb->lookup_impl<switchboard>()}
         , _m_slow_pose{sb->get_reader<pose_type>("slow_pose")}
         , _m_imu_raw{sb->get_reader<imu_raw_type>("imu_raw")}
         , _m_true_pose{sb->get_reader<pose_type>("true_pose")}
         , _m_ground_truth_offset{sb->get_reader<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
 		, _m_vsync_estimate{sb->get_reader<switchboard::event_wrapper<time_type>>("vsync_estimate")}
+        , _m_cache{std::chrono::microseconds{std::stol(ILLIXR::getenv_or("ILLIXR_POSE_CACHE_BUCKET_US", "1000"))}}
+        , _m_record_logger{pb->lookup_impl<record_logger>()}
+        , _m_next_cache_log{std::chrono::steady_clock::now() + std::chrono::seconds{1}}
+        , _m_stream_period{stream_period_from_hz(std::stod(ILLIXR::getenv_or("ILLIXR_POSE_STREAM_HZ", "0")))}
+        , _m_pose_stream_topic{sb->get_writer<pose_stream_type>("pose_stream")}
+        , _m_lazy_imu{lazy_imu_integration_enabled()}
+        , _m_adaptive_horizon{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_POSE_ADAPTIVE_HORIZON", "False"))}
+        , _m_display_latency{std::stod(ILLIXR::getenv_or("ILLIXR_POSE_LATENCY_ALPHA", "0.1"))}
+        , _m_horizon_log{_m_record_logger}
+        , _m_orientation_filter{orientation_filter_from_env()}
+        , _m_vio_timeout{std::chrono::milliseconds{std::stol(ILLIXR::getenv_or("ILLIXR_POSE_VIO_TIMEOUT_MS", "500"))}}
     { }
 
-    // No parameter get_fast_pose() should just predict to the next vsync
-    // However, we don't have vsync estimation yet.
-    // So we will predict to `now()`, as a temporary approximation
+    // No parameter get_fast_pose() predicts to when the next frame will be displayed
     virtual fast_pose_type get_fast_pose() const override {
+        return get_fast_pose(next_display_time());
+    }
+
+    // The vsync estimate, corrected by how late frames have been displayed after it (ILLIXR_POSE_ADAPTIVE_HORIZON).
+    // Without an estimate yet, now, or (once frames have been displayed) now plus the measured prediction-to-display latency.
+    time_type next_display_time() const {
         switchboard::ptr<const switchboard::event_wrapper<time_type>> vsync_estimate = _m_vsync_estimate.get_ro_nullable();
+        const time_type now = std::chrono::system_clock::now();
+        if (!_m_adaptive_horizon) {
+            return vsync_estimate == nullptr ? now : time_type{**vsync_estimate};
+        }
+        return vsync_estimate == nullptr
+            ? now + _m_display_latency.predict_to_display()
+            : **vsync_estimate + _m_display_latency.vsync_correction();
+    }
+
+    // Called for each frame timewarp displays, on switchboard's thread for the mtp topic
+    void observe_display(const mtp_sample& sample) {
+        const std::chrono::nanoseconds correction = _m_adaptive_horizon ? _m_display_latency.vsync_correction() : std::chrono::nanoseconds{0};
+        const display_latency::errors errors = _m_display_latency.update(sample);
+        _m_horizon_log.log(record{pose_prediction_horizon_record, {
+            {static_cast<std::chrono::high_resolution_clock::time_point>(sample.display_time)},
+            {errors.uncorrected},
+            {errors.residual},
+            {correction},
+        }});
+    }
 
-        if (vsync_estimate == nullptr) {
-            return get_fast_pose(std::chrono::high_resolution_clock::now());
-        } else {
-            return get_fast_pose(*vsync_estimate);
+    /// Whether ILLIXR_ORIENTATION_FILTER turned on the IMU-only poses
+    bool imu_only_enabled() const {
+        return _m_orientation_filter != nullptr;
+    }
+
+    // Called for each IMU sample, on switchboard's thread for the imu topic
+    void observe_imu(const imu_sample& sample) {
+        if (_m_orientation_filter) {
+            _m_orientation_filter->update(sample.time, sample.angular_v, sample.linear_a);
         }
     }
 
@@ -57,8 +131,164 @@ public:
 
     // future_time: An absolute timepoint in the future
     virtual fast_pose_type get_fast_pose(time_type future_timestamp) const override {
-        switchboard::ptr<const pose_type> slow_pose = _m_slow_pose.get_ro_nullable();
-        if (slow_pose == nullptr) {
+        if (streaming()) {
+            if (const std::optional<pose_stream_type> latest = _m_stream.latest(_m_offset.version())) {
+                return pose_stream::extrapolate(*latest, future_timestamp);
+            }
+            // No sample yet, or the offset changed since the last one: predict here
+        }
+
+        // Read before the pose is computed: if the offset changes meanwhile, the cache entry is already stale
+        const std::uint64_t offset_version = _m_offset.version();
+        prediction_snapshot snapshot {get_imu_raw()};
+        const fast_pose_type fast_pose = cached_fast_pose(future_timestamp, snapshot, offset_version);
+        maybe_log_cache();
+        return fast_pose;
+    }
+
+    // All the poses come from one imu_raw and slow pose, and the RK4 setup is only done once
+    virtual std::vector<fast_pose_type> get_fast_poses(const std::vector<time_type>& future_timestamps) const override {
+        std::vector<fast_pose_type> fast_poses;
+        fast_poses.reserve(future_timestamps.size());
+
+        if (streaming()) {
+            if (const std::optional<pose_stream_type> latest = _m_stream.latest(_m_offset.version())) {
+                for (const time_type future_timestamp : future_timestamps) {
+                    fast_poses.push_back(pose_stream::extrapolate(*latest, future_timestamp));
+                }
+                return fast_poses;
+            }
+        }
+
+        std::uint64_t offset_version = _m_offset.version();
+        prediction_snapshot snapshot {get_imu_raw()};
+        for (const time_type future_timestamp : future_timestamps) {
+            fast_poses.push_back(cached_fast_pose(future_timestamp, snapshot, offset_version));
+        }
+        if (_m_offset.version() != offset_version) {
+            // The first pose set the offset, or set_offset ran meanwhile: redo them all under one offset
+            offset_version = _m_offset.version();
+            fast_poses.clear();
+            for (const time_type future_timestamp : future_timestamps) {
+                fast_poses.push_back(cached_fast_pose(future_timestamp, snapshot, offset_version));
+            }
+        }
+        maybe_log_cache();
+        return fast_poses;
+    }
+
+    /// Whether ILLIXR_POSE_STREAM_HZ turned on the stream
+    bool streaming() const {
+        return _m_stream_period.count() > 0;
+    }
+
+    std::chrono::nanoseconds stream_period() const {
+        return _m_stream_period;
+    }
+
+    // One sample of the stream, for the next display time.
+    // It is predicted on the stream thread, one period further too for the derivatives.
+    void stream_once() {
+        const std::uint64_t offset_version = _m_offset.version();
+        prediction_snapshot snapshot {get_imu_raw()};
+        take_snapshot(snapshot);
+        if (!snapshot.predictor) {
+            // Queries fall back to predicting (the slow pose, or a zero pose) themselves
+            return;
+        }
+
+        const time_type target = next_display_time();
+
+        const fast_pose_type at_target = predict_fast_pose(target, snapshot);
+        const fast_pose_type one_period_later = predict_fast_pose(target + _m_stream_period, snapshot);
+        if (_m_offset.version() != offset_version) {
+            // The offset changed in between (it may have been the first pose); the next period will be consistent
+            return;
+        }
+        _m_pose_stream_topic.put(_m_pose_stream_topic.allocate<pose_stream_type>(
+            _m_stream.publish(at_target, one_period_later, offset_version)
+        ));
+    }
+
+    // What the predictions of one query share, so that they all come from the same state
+    struct prediction_snapshot {
+        explicit prediction_snapshot(switchboard::ptr<const imu_raw_type> imu_raw_)
+            : imu_raw{std::move(imu_raw_)}
+        { }
+
+        // The integrator's latest propagation (null if there is none yet)
+        switchboard::ptr<const imu_raw_type> imu_raw;
+
+        // Taken by the first prediction or cache lookup (see take_snapshot)
+        bool taken = false;
+        switchboard::ptr<const pose_type> slow_pose;
+        time_type now;
+        // Only if there are both a slow pose and imu_raw
+        std::optional<rk4_predictor> predictor;
+        // Whether the slow pose is recent enough to predict from (ILLIXR_POSE_VIO_TIMEOUT_MS)
+        bool vio_live = false;
+        // The IMU-only filter's estimate, if it is enabled and has seen a sample
+        std::optional<orientation_filter::estimate> imu_only;
+        pose_handover::state handover;
+    };
+
+    void take_snapshot(prediction_snapshot& snapshot) const {
+        if (snapshot.taken) {
+            return;
+        }
+        snapshot.taken = true;
+        snapshot.slow_pose = _m_slow_pose.get_ro_nullable();
+        snapshot.now = std::chrono::system_clock::now();
+        if (snapshot.slow_pose != nullptr && snapshot.imu_raw != nullptr) {
+            snapshot.predictor.emplace(*snapshot.imu_raw);
+        }
+        snapshot.vio_live = snapshot.slow_pose != nullptr && snapshot.now - snapshot.slow_pose->sensor_time <= _m_vio_timeout;
+        if (_m_orientation_filter) {
+            snapshot.imu_only = _m_orientation_filter->latest();
+        }
+        snapshot.handover = _m_handover.load();
+    }
+
+    // From the cache, keyed on the snapshot's imu_raw, if it is enabled.
+    // Only RK4 predictions from a live VIO pose are cached; the fallbacks are cheap, and VIO may come back at any time.
+    fast_pose_type cached_fast_pose(time_type future_timestamp, prediction_snapshot& snapshot, std::uint64_t offset_version) const {
+        if (!_m_cache.enabled()) {
+            return predict_fast_pose(future_timestamp, snapshot);
+        }
+        take_snapshot(snapshot);
+        if (!snapshot.vio_live || !snapshot.predictor) {
+            return predict_fast_pose(future_timestamp, snapshot);
+        }
+
+        const pose_cache::key key = _m_cache.make_key(*snapshot.imu_raw, offset_version, future_timestamp);
+        pose_type pose;
+        if (_m_cache.lookup(key, pose)) {
+            // The target within the bucket is this caller's, and so is the compute time (for the latency records)
+            return fast_pose_type{pose, std::chrono::high_resolution_clock::now(), future_timestamp};
+        }
+        const fast_pose_type fast_pose = predict_fast_pose(future_timestamp, snapshot);
+        _m_cache.insert(key, fast_pose.pose);
+        return fast_pose;
+    }
+
+    // The prediction itself
+    fast_pose_type predict_fast_pose(time_type future_timestamp, prediction_snapshot& snapshot) const {
+        take_snapshot(snapshot);
+        if (!snapshot.vio_live && snapshot.imu_only) {
+            // VIO is not up yet, or has stalled: rotation only, from the IMU
+            const Eigen::Quaternionf orientation = orientation_filter::predict(*snapshot.imu_only, future_timestamp);
+            if (snapshot.handover.source != pose_source::imu_only) {
+                std::optional<pose_type> vio;
+                if (snapshot.predictor) {
+                    vio = predictor_pose(*snapshot.predictor, future_timestamp, snapshot.now);
+                }
+                _m_handover.switch_to_imu_only(orientation, vio);
+                snapshot.handover = _m_handover.load();
+            }
+            return first_valid_fast_pose(snapshot.handover.serve_imu_only(snapshot.imu_only->time, orientation), future_timestamp);
+        }
+
+        if (snapshot.slow_pose == nullptr) {
             // No slow pose, return 0
             return fast_pose_type{
                 correct_pose(pose_type{}),
@@ -67,31 +297,31 @@ public:
             };
         }
 
-        switchboard::ptr<const imu_raw_type> imu_raw = _m_imu_raw.get_ro_nullable();
-        if (imu_raw == nullptr) {
+        if (snapshot.imu_raw == nullptr) {
 #ifndef NDEBUG
             printf("FAST POSE IS SLOW POSE!");
 #endif
             // No imu_raw, return slow_pose
             return fast_pose_type{
-                correct_pose(*slow_pose),
+                correct_pose(vio_pose(*snapshot.slow_pose, future_timestamp, snapshot)),
                 std::chrono::system_clock::now(),
                 future_timestamp,
             };
         }
 
         // slow_pose and imu_raw, do pose prediction
+        const pose_type predicted_pose = predictor_pose(*snapshot.predictor, future_timestamp, snapshot.now);
+        return first_valid_fast_pose(vio_pose(predicted_pose, future_timestamp, snapshot), future_timestamp);
+    }
 
-        double dt = std::chrono::duration_cast<std::chrono::nanoseconds>(future_timestamp - std::chrono::system_clock::now()).count();
-        std::pair<Eigen::Matrix<double,13,1>, time_type> predictor_result = predict_mean_rk4(dt/NANO_SEC);
-
-        auto state_plus = predictor_result.first;
+    // The raw (OpenVINS frame) pose RK4 predicts for future_timestamp
+    static pose_type predictor_pose(const rk4_predictor& predictor, time_type future_timestamp, time_type now) {
+        const double dt = std::chrono::duration<double>(future_timestamp - now).count();
+        const Eigen::Matrix<double,13,1> state_plus = predictor.predict(dt);
 
-        // predictor_imu_time is the most recent IMU sample that was used to compute the prediction.
-        auto predictor_imu_time = predictor_result.second;
-        
-        pose_type predicted_pose = correct_pose({
-            predictor_imu_time,
+        return pose_type{
+            // The most recent IMU sample that was used to compute the prediction.
+            predictor.imu_time(),
             Eigen::Vector3f{
                 static_cast<float>(state_plus(4)),
                 static_cast<float>(state_plus(5)),
@@ -103,16 +333,30 @@ public:
                 static_cast<float>(state_plus(1)),
                 static_cast<float>(state_plus(2))
             }
-        });
+        };
+    }
 
-        // Make the first valid fast pose be straight ahead.
-        if (first_time) {
-            std::unique_lock lock {offset_mutex};
-            // check again, now that we have mutual exclusion
-            if (first_time) {
-                first_time = false;
-                offset = predicted_pose.orientation.inverse();
+    // A VIO pose, aligned with the IMU-only poses served before it (if there were any)
+    pose_type vio_pose(const pose_type& raw, time_type future_timestamp, prediction_snapshot& snapshot) const {
+        if (snapshot.handover.source != pose_source::vio) {
+            std::optional<Eigen::Quaternionf> imu_only;
+            if (snapshot.imu_only) {
+                imu_only = orientation_filter::predict(*snapshot.imu_only, future_timestamp);
             }
+            _m_handover.switch_to_vio(raw, imu_only);
+            snapshot.handover = _m_handover.load();
+        }
+        return snapshot.handover.serve_vio(raw);
+    }
+
+    // Corrects a raw predicted pose (from VIO or the IMU alone)
+    fast_pose_type first_valid_fast_pose(const pose_type& raw, time_type future_timestamp) const {
+        const pose_type predicted_pose = correct_pose(raw);
+
+        // Make the first valid fast pose be straight ahead.
+        // Only a read until then; exactly one query wins the exchange.
+        if (first_time.load(std::memory_order_relaxed) && first_time.exchange(false)) {
+            _m_offset.assign(predicted_pose.orientation.inverse());
         }
 
         // Several timestamps are logged:
@@ -126,27 +370,16 @@ public:
     }
 
     virtual void set_offset(const Eigen::Quaternionf& raw_o_times_offset) override {
-        std::unique_lock lock {offset_mutex};
-        Eigen::Quaternionf raw_o = raw_o_times_offset * offset.inverse();
-        offset = raw_o.inverse();
-        /*
-          Now, `raw_o` is maps to the identity quaternion.
-          Proof:
-          apply_offset(raw_o)
-              = raw_o * offset
-              = raw_o * raw_o.inverse()
-              = Identity.
-         */
+        _m_offset.set(raw_o_times_offset);
     }
 
     Eigen::Quaternionf apply_offset(const Eigen::Quaternionf& orientation) const {
-        std::shared_lock lock {offset_mutex};
-        return orientation * offset;
+        return _m_offset.apply(orientation);
     }
 
 
     virtual bool fast_pose_reliable() const override {
-        return _m_slow_pose.get_ro_nullable() && _m_imu_raw.get_ro_nullable();
+        return _m_slow_pose.get_ro_nullable() && get_imu_raw();
         /*
           SLAM takes some time to initialize, so initially fast_pose
           is unreliable.
@@ -172,7 +405,7 @@ public:
     }
 
     virtual Eigen::Quaternionf get_offset() override {
-        return offset;
+        return _m_offset.get();
     }
 
     // Correct the orientation of the pose due to the lopsided IMU in the 
@@ -200,221 +433,143 @@ public:
 
 private:
     mutable std::atomic<bool> first_time{true};
+    const phonebook* const pb;
     const std::shared_ptr<switchboard> sb;
     switchboard::reader<pose_type> _m_slow_pose;
     switchboard::reader<imu_raw_type> _m_imu_raw;
 	switchboard::reader<pose_type> _m_true_pose;
     switchboard::reader<switchboard::event_wrapper<Eigen::Vector3f>> _m_ground_truth_offset;
     switchboard::reader<switchboard::event_wrapper<time_type>> _m_vsync_estimate;
-	mutable Eigen::Quaternionf offset {Eigen::Quaternionf::Identity()};
-	mutable std::shared_mutex offset_mutex;
-    
-
-    // Slightly modified copy of OpenVINS method found in propagator.cpp
-    // Returns a pair of the predictor state_plus and the time associated with the
-    // most recent imu reading used to perform this prediction.
-    std::pair<Eigen::Matrix<double,13,1>,time_type> predict_mean_rk4(double dt) const {
-
-        // Pre-compute things
-        switchboard::ptr<const imu_raw_type> imu_raw = _m_imu_raw.get_ro();
-
-        Eigen::Vector3d w_hat =imu_raw->w_hat;
-        Eigen::Vector3d a_hat = imu_raw->a_hat;
-        Eigen::Vector3d w_alpha = (imu_raw->w_hat2-imu_raw->w_hat)/dt;
-        Eigen::Vector3d a_jerk = (imu_raw->a_hat2-imu_raw->a_hat)/dt;
-
-        // y0 ================
-        Eigen::Quaterniond temp_quat = imu_raw->quat;
-        Eigen::Vector4d q_0 = {temp_quat.x(), temp_quat.y(), temp_quat.z(), temp_quat.w()};
-        Eigen::Vector3d p_0 = imu_raw->pos;
-        Eigen::Vector3d v_0 = imu_raw->vel;
-
-        // k1 ================
-        Eigen::Vector4d dq_0 = {0,0,0,1};
-        Eigen::Vector4d q0_dot = 0.5*Omega(w_hat)*dq_0;
-        Eigen::Vector3d p0_dot = v_0;
-        Eigen::Matrix3d R_Gto0 = quat_2_Rot(quat_multiply(dq_0,q_0));
-        Eigen::Vector3d v0_dot = R_Gto0.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
-
-        Eigen::Vector4d k1_q = q0_dot*dt;
-        Eigen::Vector3d k1_p = p0_dot*dt;
-        Eigen::Vector3d k1_v = v0_dot*dt;
-
-        // k2 ================
-        w_hat += 0.5*w_alpha*dt;
-        a_hat += 0.5*a_jerk*dt;
-
-        Eigen::Vector4d dq_1 = quatnorm(dq_0+0.5*k1_q);
-        Eigen::Vector3d v_1 = v_0+0.5*k1_v;
-
-        Eigen::Vector4d q1_dot = 0.5*Omega(w_hat)*dq_1;
-        Eigen::Vector3d p1_dot = v_1;
-        Eigen::Matrix3d R_Gto1 = quat_2_Rot(quat_multiply(dq_1,q_0));
-        Eigen::Vector3d v1_dot = R_Gto1.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
-
-        Eigen::Vector4d k2_q = q1_dot*dt;
-        Eigen::Vector3d k2_p = p1_dot*dt;
-        Eigen::Vector3d k2_v = v1_dot*dt;
-
-        // k3 ================
-        Eigen::Vector4d dq_2 = quatnorm(dq_0+0.5*k2_q);
-        //Eigen::Vector3d p_2 = p_0+0.5*k2_p;
-        Eigen::Vector3d v_2 = v_0+0.5*k2_v;
-
-        Eigen::Vector4d q2_dot = 0.5*Omega(w_hat)*dq_2;
-        Eigen::Vector3d p2_dot = v_2;
-        Eigen::Matrix3d R_Gto2 = quat_2_Rot(quat_multiply(dq_2,q_0));
-        Eigen::Vector3d v2_dot = R_Gto2.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
-
-        Eigen::Vector4d k3_q = q2_dot*dt;
-        Eigen::Vector3d k3_p = p2_dot*dt;
-        Eigen::Vector3d k3_v = v2_dot*dt;
-
-        // k4 ================
-        w_hat += 0.5*w_alpha*dt;
-        a_hat += 0.5*a_jerk*dt;
-
-        Eigen::Vector4d dq_3 = quatnorm(dq_0+k3_q);
-        //Eigen::Vector3d p_3 = p_0+k3_p;
-        Eigen::Vector3d v_3 = v_0+k3_v;
-
-        Eigen::Vector4d q3_dot = 0.5*Omega(w_hat)*dq_3;
-        Eigen::Vector3d p3_dot = v_3;
-        Eigen::Matrix3d R_Gto3 = quat_2_Rot(quat_multiply(dq_3,q_0));
-        Eigen::Vector3d v3_dot = R_Gto3.transpose()*a_hat-Eigen::Vector3d{0.0, 0.0, 9.81};
-
-        Eigen::Vector4d k4_q = q3_dot*dt;
-        Eigen::Vector3d k4_p = p3_dot*dt;
-        Eigen::Vector3d k4_v = v3_dot*dt;
-
-        // y+dt ================
-        Eigen::Matrix<double,13,1> state_plus = Eigen::Matrix<double,13,1>::Zero();
-        Eigen::Vector4d dq = quatnorm(dq_0+(1.0/6.0)*k1_q+(1.0/3.0)*k2_q+(1.0/3.0)*k3_q+(1.0/6.0)*k4_q);
-        state_plus.block(0,0,4,1) = quat_multiply(dq, q_0);
-        state_plus.block(4,0,3,1) = p_0+(1.0/6.0)*k1_p+(1.0/3.0)*k2_p+(1.0/3.0)*k3_p+(1.0/6.0)*k4_p;
-        state_plus.block(7,0,3,1) = v_0+(1.0/6.0)*k1_v+(1.0/3.0)*k2_v+(1.0/3.0)*k3_v+(1.0/6.0)*k4_v;
-
-        return {state_plus, imu_raw->imu_time};
-    }
-
-    /**
-     * @brief Integrated quaternion from angular velocity
-     *
-     * See equation (48) of trawny tech report [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf).
-     *
-     */
-    static const inline Eigen::Matrix<double, 4, 4> Omega(Eigen::Matrix<double, 3, 1> w) {
-        Eigen::Matrix<double, 4, 4> mat;
-        mat.block(0, 0, 3, 3) = -skew_x(w);
-        mat.block(3, 0, 1, 3) = -w.transpose();
-        mat.block(0, 3, 3, 1) = w;
-        mat(3, 3) = 0;
-        return mat;
-    }
-
-    /**
-     * @brief Normalizes a quaternion to make sure it is unit norm
-     * @param q_t Quaternion to normalized
-     * @return Normalized quaterion
-     */
-    static const inline Eigen::Matrix<double, 4, 1> quatnorm(Eigen::Matrix<double, 4, 1> q_t) {
-        if (q_t(3, 0) < 0) {
-            q_t *= -1;
+    // Read on every query without locking
+    mutable orientation_offset _m_offset;
+
+    // Fast poses by (imu_raw, offset, target bucket); ILLIXR_POSE_CACHE_BUCKET_US=0 disables it
+    mutable pose_cache _m_cache;
+    const std::shared_ptr<record_logger> _m_record_logger;
+    mutable std::atomic<std::chrono::steady_clock::time_point> _m_next_cache_log;
+
+    // Fixed-rate stream; a zero period (the default) disables it
+    const std::chrono::nanoseconds _m_stream_period;
+    pose_stream _m_stream;
+    switchboard::writer<pose_stream_type> _m_pose_stream_topic;
+
+    static std::chrono::nanoseconds stream_period_from_hz(double hz) {
+        return hz > 0 ? std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{1 / hz}) : std::chrono::nanoseconds{0};
+    }
+
+    // About once a second, whichever query gets there first logs the hits and misses since the last record
+    void maybe_log_cache() const {
+        const auto now = std::chrono::steady_clock::now();
+        auto next = _m_next_cache_log.load();
+        if (now < next || !_m_next_cache_log.compare_exchange_strong(next, now + std::chrono::seconds{1})) {
+            return;
         }
-        return q_t / q_t.norm();
-    }
-
-    /**
-     * @brief Skew-symmetric matrix from a given 3x1 vector
-     *
-     * This is based on equation 6 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf):
-     * \f{align*}{
-     *  \lfloor\mathbf{v}\times\rfloor =
-     *  \begin{bmatrix}
-     *  0 & -v_3 & v_2 \\ v_3 & 0 & -v_1 \\ -v_2 & v_1 & 0
-     *  \end{bmatrix}
-     * @f}
-     *
-     * @param[in] w 3x1 vector to be made a skew-symmetric
-     * @return 3x3 skew-symmetric matrix
-     */
-    static const inline Eigen::Matrix<double, 3, 3> skew_x(const Eigen::Matrix<double, 3, 1> &w) {
-        Eigen::Matrix<double, 3, 3> w_x;
-        w_x << 0, -w(2), w(1),
-                w(2), 0, -w(0),
-                -w(1), w(0), 0;
-        return w_x;
-    }
-
-    /**
-     * @brief Converts JPL quaterion to SO(3) rotation matrix
-     *
-     * This is based on equation 62 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf):
-     * \f{align*}{
-     *  \mathbf{R} = (2q_4^2-1)\mathbf{I}_3-2q_4\lfloor\mathbf{q}\times\rfloor+2\mathbf{q}^\top\mathbf{q}
-     * @f}
-     *
-     * @param[in] q JPL quaternion
-     * @return 3x3 SO(3) rotation matrix
-     */
-    static const inline Eigen::Matrix<double, 3, 3> quat_2_Rot(const Eigen::Matrix<double, 4, 1> &q) {
-        Eigen::Matrix<double, 3, 3> q_x = skew_x(q.block(0, 0, 3, 1));
-        Eigen::MatrixXd Rot = (2 * std::pow(q(3, 0), 2) - 1) * Eigen::MatrixXd::Identity(3, 3)
-                              - 2 * q(3, 0) * q_x +
-                              2 * q.block(0, 0, 3, 1) * (q.block(0, 0, 3, 1).transpose());
-        return Rot;
-    }
-
-    /**
-     * @brief Multiply two JPL quaternions
-     *
-     * This is based on equation 9 in [Indirect Kalman Filter for 3D Attitude Estimation](http://mars.cs.umn.edu/tr/reports/Trawny05b.pdf).
-     * We also enforce that the quaternion is unique by having q_4 be greater than zero.
-     * \f{align*}{
-     *  \bar{q}\otimes\bar{p}=
-     *  \mathcal{L}(\bar{q})\bar{p}=
-     *  \begin{bmatrix}
-     *  q_4\mathbf{I}_3+\lfloor\mathbf{q}\times\rfloor & \mathbf{q} \\
-     *  -\mathbf{q}^\top & q_4
-     *  \end{bmatrix}
-     *  \begin{bmatrix}
-     *  \mathbf{p} \\ p_4
-     *  \end{bmatrix}
-     * @f}
-     *
-     * @param[in] q First JPL quaternion
-     * @param[in] p Second JPL quaternion
-     * @return 4x1 resulting p*q quaternion
-     */
-    static const inline Eigen::Matrix<double, 4, 1> quat_multiply(const Eigen::Matrix<double, 4, 1> &q, const Eigen::Matrix<double, 4, 1> &p) {
-        Eigen::Matrix<double, 4, 1> q_t;
-        Eigen::Matrix<double, 4, 4> Qm;
-        // create big L matrix
-        Qm.block(0, 0, 3, 3) = q(3, 0) * Eigen::MatrixXd::Identity(3, 3) - skew_x(q.block(0, 0, 3, 1));
-        Qm.block(0, 3, 3, 1) = q.block(0, 0, 3, 1);
-        Qm.block(3, 0, 1, 3) = -q.block(0, 0, 3, 1).transpose();
-        Qm(3, 3) = q(3, 0);
-        q_t = Qm * p;
-        // ensure unique by forcing q_4 to be >0
-        if (q_t(3, 0) < 0) {
-            q_t *= -1;
+        const auto [hits, misses] = _m_cache.take_counts();
+        if (_m_record_logger) {
+            _m_record_logger->log(record{pose_prediction_cache_record, {
+                {hits},
+                {misses},
+            }});
         }
-        // normalize and return
-        return q_t / q_t.norm();
+    }
+
+    // With ILLIXR_LAZY_IMU_INTEGRATION, the integrator only propagates when asked, here.
+    // It registers itself after this is constructed, so it is looked up on first use.
+    const bool _m_lazy_imu;
+    mutable std::once_flag _m_lazy_imu_lookup;
+    mutable std::shared_ptr<lazy_imu_integrator> _m_lazy_imu_integrator;
+
+    // Learned from timewarp's mtp samples; only applied if ILLIXR_POSE_ADAPTIVE_HORIZON is True, but always logged
+    const bool _m_adaptive_horizon;
+    display_latency _m_display_latency;
+    record_coalescer _m_horizon_log;
+
+    // Rotation-only poses from the IMU while VIO is not up (or has stalled for ILLIXR_POSE_VIO_TIMEOUT_MS);
+    // null unless ILLIXR_ORIENTATION_FILTER is True
+    const std::unique_ptr<orientation_filter> _m_orientation_filter;
+    const std::chrono::nanoseconds _m_vio_timeout;
+    mutable pose_handover _m_handover;
+
+    static std::unique_ptr<orientation_filter> orientation_filter_from_env() {
+        if (!ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_ORIENTATION_FILTER", "False"))) {
+            return nullptr;
+        }
+        return std::make_unique<orientation_filter>(std::stof(ILLIXR::getenv_or("ILLIXR_ORIENTATION_FILTER_GAIN", "1.0")));
+    }
+
+    // The integrator's latest propagation (or null if there is none yet)
+    switchboard::ptr<const imu_raw_type> get_imu_raw() const {
+        if (!_m_lazy_imu) {
+            return _m_imu_raw.get_ro_nullable();
+        }
+        std::call_once(_m_lazy_imu_lookup, [this]() {
+            _m_lazy_imu_integrator = pb->lookup_impl<lazy_imu_integrator>();
+        });
+        return _m_lazy_imu_integrator->propagate();
     }
 };
 
-class pose_prediction_plugin : public plugin {
+// The thread only runs with ILLIXR_POSE_STREAM_HZ; otherwise it stops at once and poses are predicted on demand.
+class pose_prediction_plugin : public threadloop {
 public:
-    pose_prediction_plugin(const std::string& name, phonebook* pb)
-        : plugin{name, pb}
+    pose_prediction_plugin(const std::string& name, phonebook* pb_)
+        : threadloop{name, pb_}
+        , _m_impl{std::make_shared<pose_prediction_impl>(pb_)}
     {
-        pb->register_impl<pose_prediction>(
-            std::static_pointer_cast<pose_prediction>(
-                std::make_shared<pose_prediction_impl>(pb)
-            )
+        pb_->register_impl<pose_prediction>(
+            std::static_pointer_cast<pose_prediction>(_m_impl)
         );
     }
+
+    virtual void start() override {
+        threadloop::start();
+        pb->lookup_impl<switchboard>()->schedule<mtp_sample>(id, "mtp", [this](switchboard::ptr<const mtp_sample> sample, std::size_t) {
+            _m_impl->observe_display(*sample);
+        });
+        if (_m_impl->imu_only_enabled()) {
+            pb->lookup_impl<switchboard>()->schedule<imu_sample>(id, "imu", [this](switchboard::ptr<const imu_sample> sample, std::size_t) {
+                _m_impl->observe_imu(*sample);
+            });
+        }
+    }
+
+protected:
+    virtual skip_option _p_should_skip() override {
+        if (!_m_impl->streaming()) {
+            return skip_option::stop;
+        }
+        std::this_thread::sleep_until(_m_next_sample);
+        _m_next_sample += _m_impl->stream_period();
+        const auto now = std::chrono::steady_clock::now();
+        if (_m_next_sample < now) {
+            // Fell behind: carry on from now instead of catching up in a burst
+            _m_next_sample = now + _m_impl->stream_period();
+        }
+        return skip_option::run;
+    }
+
+    virtual void _p_thread_setup() override {
+        if (!_m_impl->streaming()) {
+            return;
+        }
+        _m_next_sample = std::chrono::steady_clock::now();
+
+        // Real-time, so samples keep coming while the render threads load the CPU.
+        // This needs CAP_SYS_NICE (or an rtprio limit); without it, the thread stays at normal priority.
+        sched_param param {};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        if (const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+            std::cerr << "pose_prediction: stream thread stays at normal priority (" << std::strerror(error) << ")" << std::endl;
+        }
+    }
+
+    virtual void _p_one_iteration() override {
+        _m_impl->stream_once();
+    }
+
+private:
+    const std::shared_ptr<pose_prediction_impl> _m_impl;
+    std::chrono::steady_clock::time_point _m_next_sample;
 };
 
 PLUGIN_MAIN(pose_prediction_plugin);
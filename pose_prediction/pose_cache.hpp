@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "common/data_format.hpp"
+#include "common/seqlock.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Memoizes fast poses, so consumers asking for the same target within a frame share one prediction.
+	 *
+	 * gldemo, timewarp_gl and debugview each call `get_fast_pose` every frame, mostly for the same vsync.
+	 * An RK4 prediction only depends on the `imu_raw` it started from, the orientation offset, and the target time,
+	 * so that is the key; targets are rounded down to buckets of `bucket_width`.
+	 * `imu_raw` is identified by its `imu_time`, which each propagation advances (its address could be reused).
+	 * Only the pose is stored: the caller stamps its own target and compute times on a hit.
+	 *
+	 * RK4 integrates over `target - now` from the `imu_raw`'s state, so a hit serves the pose as predicted at
+	 * the first caller's `now`, not the current caller's: its dt is longer than the later caller's would be,
+	 * by the time between the two queries (within a frame, a few ms at most). The key leaves `now` out on
+	 * purpose; keying on it too would make the callers of one frame, which query at different times, all miss.
+	 *
+	 * A few slots (chosen by bucket) each hold an entry in a `seqlock`, so lookups never block.
+	 * Concurrent misses on the same slot all compute the pose; only one of them stores it.
+	 */
+	class pose_cache {
+	public:
+		struct key {
+			time_type::rep imu_time;
+			std::uint64_t offset_version;
+			std::int64_t bucket;
+		};
+
+		/// A zero @p bucket_width disables the cache
+		explicit pose_cache(std::chrono::nanoseconds bucket_width)
+			: _m_bucket_width{bucket_width}
+		{ }
+
+		bool enabled() const {
+			return _m_bucket_width.count() > 0;
+		}
+
+		key make_key(const imu_raw_type& imu_raw, std::uint64_t offset_version, time_type target) const {
+			const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch());
+			return key{imu_raw.imu_time.time_since_epoch().count(), offset_version, since_epoch.count() / _m_bucket_width.count()};
+		}
+
+		bool lookup(const key& k, pose_type& out) {
+			entry e;
+			if (_m_slots[slot(k)].try_load(e) && e.imu_time == k.imu_time && e.offset_version == k.offset_version && e.bucket == k.bucket) {
+				out = e.to_pose();
+				_m_hits.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			_m_misses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		void insert(const key& k, const pose_type& pose) {
+			_m_slots[slot(k)].try_store(entry::from(k, pose));
+		}
+
+		/// Hits and misses since the last call
+		std::pair<std::size_t, std::size_t> take_counts() {
+			return {_m_hits.exchange(0, std::memory_order_relaxed), _m_misses.exchange(0, std::memory_order_relaxed)};
+		}
+
+	private:
+		// Trivially copyable, for the seqlock
+		struct entry {
+			time_type::rep imu_time;
+			std::uint64_t offset_version;
+			std::int64_t bucket;
+			time_type::rep sensor_time;
+			float position[3];
+			// w, x, y, z
+			float orientation[4];
+
+			static entry from(const key& k, const pose_type& pose) {
+				return entry{
+					k.imu_time,
+					k.offset_version,
+					k.bucket,
+					pose.sensor_time.time_since_epoch().count(),
+					{pose.position.x(), pose.position.y(), pose.position.z()},
+					{pose.orientation.w(), pose.orientation.x(), pose.orientation.y(), pose.orientation.z()},
+				};
+			}
+
+			pose_type to_pose() const {
+				return pose_type{
+					time_type{time_type::duration{sensor_time}},
+					Eigen::Vector3f{position[0], position[1], position[2]},
+					Eigen::Quaternionf{orientation[0], orientation[1], orientation[2], orientation[3]},
+				};
+			}
+		};
+
+		static constexpr std::size_t slots = 4;
+
+		static std::size_t slot(const key& k) {
+			return std::size_t(k.bucket) % slots;
+		}
+
+		const std::chrono::nanoseconds _m_bucket_width;
+		std::array<seqlock<entry>, slots> _m_slots;
+		std::atomic<std::size_t> _m_hits {0};
+		std::atomic<std::size_t> _m_misses {0};
+	};
+
+}
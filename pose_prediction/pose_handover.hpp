@@ -0,0 +1,133 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+
+#include "common/data_format.hpp"
+#include "common/seqlock.hpp"
+
+namespace ILLIXR {
+
+	enum class pose_source {
+		// Nothing has been served yet
+		none,
+		vio,
+		imu_only,
+	};
+
+	/**
+	 * @brief Keeps the served pose continuous when pose_prediction switches between VIO and the IMU-only filter.
+	 *
+	 * Both sources are gravity-aligned, but their yaws are unrelated. On a switch, the new source is
+	 * rotated about world z (from then on) so that its orientation matches the old source's at that moment.
+	 * While IMU-only, the position is held where VIO left it; back on VIO, its positions are translated
+	 * (after the rotation) so that they start from the held one.
+	 *
+	 * Poses here are raw (OpenVINS' frame), before `correct_pose`.
+	 * Queries read the state from a `seqlock`; switches, which are rare, are serialized by a mutex.
+	 */
+	class pose_handover {
+	public:
+		struct state {
+			pose_source source;
+			// Applied on the left of each source's orientations (and VIO's positions)
+			Eigen::Quaternionf vio_alignment;
+			// Added to VIO's rotated positions
+			Eigen::Vector3f vio_translation;
+			Eigen::Quaternionf imu_only_alignment;
+			Eigen::Vector3f held_position;
+
+			pose_type serve_vio(const pose_type& vio) const {
+				return pose_type{vio.sensor_time, vio_alignment * vio.position + vio_translation, vio_alignment * vio.orientation};
+			}
+
+			pose_type serve_imu_only(time_type sensor_time, const Eigen::Quaternionf& orientation) const {
+				return pose_type{sensor_time, held_position, imu_only_alignment * orientation};
+			}
+		};
+
+		state load() const {
+			return _m_state.load().to_state();
+		}
+
+		/// @param imu_only The IMU-only orientation at VIO's pose's time, if there is one
+		void switch_to_vio(const pose_type& vio, const std::optional<Eigen::Quaternionf>& imu_only) {
+			std::lock_guard<std::mutex> lock {_m_switch_mutex};
+			state s = load();
+			if (s.source == pose_source::vio) {
+				return;
+			}
+			if (s.source == pose_source::imu_only) {
+				if (imu_only) {
+					s.vio_alignment = yaw_between(s.imu_only_alignment * *imu_only, vio.orientation);
+				}
+				s.vio_translation = s.held_position - s.vio_alignment * vio.position;
+			}
+			s.source = pose_source::vio;
+			_m_state.store(stored::from(s));
+		}
+
+		/// @param vio VIO's pose at the IMU-only orientation's time, if there is one
+		void switch_to_imu_only(const Eigen::Quaternionf& imu_only, const std::optional<pose_type>& vio) {
+			std::lock_guard<std::mutex> lock {_m_switch_mutex};
+			state s = load();
+			if (s.source == pose_source::imu_only) {
+				return;
+			}
+			if (s.source == pose_source::vio && vio) {
+				const pose_type served = s.serve_vio(*vio);
+				s.imu_only_alignment = yaw_between(served.orientation, imu_only);
+				s.held_position = served.position;
+			}
+			s.source = pose_source::imu_only;
+			_m_state.store(stored::from(s));
+		}
+
+		/// The rotation about world z which best takes @p from to @p to (its twist about z)
+		static Eigen::Quaternionf yaw_between(const Eigen::Quaternionf& to, const Eigen::Quaternionf& from) {
+			const Eigen::Quaternionf delta = to * from.inverse();
+			const Eigen::Quaternionf twist {delta.w(), 0.f, 0.f, delta.z()};
+			if (twist.norm() < 1e-6f) {
+				return Eigen::Quaternionf::Identity();
+			}
+			return twist.normalized();
+		}
+
+	private:
+		// Trivially copyable, for the seqlock
+		struct stored {
+			pose_source source;
+			// w, x, y, z
+			float vio_alignment[4];
+			float vio_translation[3];
+			float imu_only_alignment[4];
+			float held_position[3];
+
+			static stored from(const state& s) {
+				const Eigen::Quaternionf& v = s.vio_alignment;
+				const Eigen::Quaternionf& i = s.imu_only_alignment;
+				return stored{
+					s.source,
+					{v.w(), v.x(), v.y(), v.z()},
+					{s.vio_translation.x(), s.vio_translation.y(), s.vio_translation.z()},
+					{i.w(), i.x(), i.y(), i.z()},
+					{s.held_position.x(), s.held_position.y(), s.held_position.z()},
+				};
+			}
+
+			state to_state() const {
+				return state{
+					source,
+					Eigen::Quaternionf{vio_alignment[0], vio_alignment[1], vio_alignment[2], vio_alignment[3]},
+					Eigen::Vector3f{vio_translation[0], vio_translation[1], vio_translation[2]},
+					Eigen::Quaternionf{imu_only_alignment[0], imu_only_alignment[1], imu_only_alignment[2], imu_only_alignment[3]},
+					Eigen::Vector3f{held_position[0], held_position[1], held_position[2]},
+				};
+			}
+		};
+
+		seqlock<stored> _m_state {stored{pose_source::none, {1.f, 0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, {1.f, 0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}}};
+		std::mutex _m_switch_mutex;
+	};
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "common/data_format.hpp"
+#include "common/seqlock.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief The latest sample of pose_prediction's fixed-rate stream (`ILLIXR_POSE_STREAM_HZ`), which
+	 * `get_fast_pose` extrapolates from instead of predicting on the caller's thread.
+	 *
+	 * The streaming thread predicts the pose at a target and one period after it, from the same `imu_raw`;
+	 * their difference gives the velocities, so that extrapolating within a period follows the prediction.
+	 * Readers copy the sample out of a `seqlock`, as with the pose cache.
+	 */
+	class pose_stream {
+	public:
+		/// Predictions of the same `imu_raw` at `t` and `t + h`, under offset version @p offset_version
+		pose_stream_type publish(const fast_pose_type& at_t, const fast_pose_type& at_t_plus_h, std::uint64_t offset_version) {
+			const double h = std::chrono::duration<double>(at_t_plus_h.predict_target_time - at_t.predict_target_time).count();
+			const pose_type& p0 = at_t.pose;
+			const pose_type& p1 = at_t_plus_h.pose;
+
+			const Eigen::Vector3f linear_velocity = (p1.position - p0.position) / float(h);
+			Eigen::Quaternionf dq = p0.orientation.inverse() * p1.orientation;
+			if (dq.w() < 0.f) {
+				// The short way round
+				dq.coeffs() *= -1.f;
+			}
+			const Eigen::AngleAxisf turn {dq};
+			const Eigen::Vector3f angular_velocity = turn.axis() * turn.angle() / float(h);
+
+			_m_sample.store(sample::from(at_t, linear_velocity, angular_velocity, offset_version));
+			return pose_stream_type{at_t, linear_velocity, angular_velocity};
+		}
+
+		/// The latest sample, unless there is none yet or it was predicted under another offset
+		std::optional<pose_stream_type> latest(std::uint64_t offset_version) const {
+			const sample s = _m_sample.load();
+			if (!s.valid || s.offset_version != offset_version) {
+				return std::nullopt;
+			}
+			return s.to_pose_stream();
+		}
+
+		/// The sample's pose, moved at constant velocities to @p target
+		static fast_pose_type extrapolate(const pose_stream_type& stream, time_type target) {
+			const fast_pose_type& from = stream.fast_pose;
+			const float dt = std::chrono::duration<float>(target - from.predict_target_time).count();
+
+			const float angle = stream.angular_velocity.norm() * dt;
+			const Eigen::Quaternionf turn = angle == 0.f
+				? Eigen::Quaternionf::Identity()
+				: Eigen::Quaternionf{Eigen::AngleAxisf{angle, stream.angular_velocity.normalized()}};
+
+			return fast_pose_type{
+				pose_type{
+					from.pose.sensor_time,
+					from.pose.position + stream.linear_velocity * dt,
+					(from.pose.orientation * turn).normalized(),
+				},
+				from.predict_computed_time,
+				target,
+			};
+		}
+
+	private:
+		// Trivially copyable, for the seqlock
+		struct sample {
+			bool valid;
+			std::uint64_t offset_version;
+			time_type::rep sensor_time;
+			time_type::rep predict_computed_time;
+			time_type::rep predict_target_time;
+			float position[3];
+			// w, x, y, z
+			float orientation[4];
+			float linear_velocity[3];
+			float angular_velocity[3];
+
+			static sample from(const fast_pose_type& fast_pose, const Eigen::Vector3f& v, const Eigen::Vector3f& w, std::uint64_t offset_version) {
+				const pose_type& pose = fast_pose.pose;
+				return sample{
+					true,
+					offset_version,
+					pose.sensor_time.time_since_epoch().count(),
+					fast_pose.predict_computed_time.time_since_epoch().count(),
+					fast_pose.predict_target_time.time_since_epoch().count(),
+					{pose.position.x(), pose.position.y(), pose.position.z()},
+					{pose.orientation.w(), pose.orientation.x(), pose.orientation.y(), pose.orientation.z()},
+					{v.x(), v.y(), v.z()},
+					{w.x(), w.y(), w.z()},
+				};
+			}
+
+			pose_stream_type to_pose_stream() const {
+				return pose_stream_type{
+					fast_pose_type{
+						pose_type{
+							time_type{time_type::duration{sensor_time}},
+							Eigen::Vector3f{position[0], position[1], position[2]},
+							Eigen::Quaternionf{orientation[0], orientation[1], orientation[2], orientation[3]},
+						},
+						time_type{time_type::duration{predict_computed_time}},
+						time_type{time_type::duration{predict_target_time}},
+					},
+					Eigen::Vector3f{linear_velocity[0], linear_velocity[1], linear_velocity[2]},
+					Eigen::Vector3f{angular_velocity[0], angular_velocity[1], angular_velocity[2]},
+				};
+			}
+		};
+
+		seqlock<sample> _m_sample {sample{}};
+	};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <eigen3/Eigen/Dense>
+
+#include "common/data_format.hpp"
+#include "common/jpl_quaternion.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief pose_prediction's RK4 step from an `imu_raw`, to any dt.
+	 *
+	 * Slightly modified copy of OpenVINS's `Propagator::predict_mean_rk4` (propagator.cpp).
+	 * The angular velocity and acceleration go linearly from `w_hat`/`a_hat` to `w_hat2`/`a_hat2` over the step,
+	 * so their values at the RK4 nodes do not depend on dt, and neither does the first stage.
+	 * Those are computed here once, so that several predictions from one `imu_raw` (`get_fast_poses`)
+	 * only pay for the rest.
+	 */
+	class rk4_predictor {
+	public:
+		explicit rk4_predictor(const imu_raw_type& imu_raw)
+			: _m_omega_0{Omega(imu_raw.w_hat)}
+			, _m_a_0{imu_raw.a_hat}
+			, _m_q_0{imu_raw.quat.x(), imu_raw.quat.y(), imu_raw.quat.z(), imu_raw.quat.w()}
+			, _m_p_0{imu_raw.pos}
+			, _m_v_0{imu_raw.vel}
+			, _m_imu_time{imu_raw.imu_time}
+		{
+			// w_hat and a_hat at the middle and end of the step
+			const Eigen::Vector3d w_half_step = 0.5 * (imu_raw.w_hat2 - imu_raw.w_hat);
+			const Eigen::Vector3d a_half_step = 0.5 * (imu_raw.a_hat2 - imu_raw.a_hat);
+			_m_omega_mid = Omega(imu_raw.w_hat + w_half_step);
+			_m_omega_1 = Omega(imu_raw.w_hat + w_half_step + w_half_step);
+			_m_a_mid = imu_raw.a_hat + a_half_step;
+			_m_a_1 = _m_a_mid + a_half_step;
+
+			// k1, per unit of dt
+			const Eigen::Vector4d dq_0 = {0,0,0,1};
+			_m_q0_dot = 0.5*_m_omega_0*dq_0;
+			const Eigen::Matrix3d R_Gto0 = quat_2_Rot(quat_multiply(dq_0,_m_q_0));
+			_m_v0_dot = R_Gto0.transpose()*_m_a_0-Eigen::Vector3d{0.0, 0.0, 9.81};
+		}
+
+		/// The most recent IMU sample the prediction is from
+		time_type imu_time() const {
+			return _m_imu_time;
+		}
+
+		/// The state @p dt seconds after the IMU's: JPL orientation (x, y, z, w), position, velocity
+		Eigen::Matrix<double,13,1> predict(double dt) const {
+			// k1 ================
+			const Eigen::Vector4d dq_0 = {0,0,0,1};
+			Eigen::Vector4d k1_q = _m_q0_dot*dt;
+			Eigen::Vector3d k1_p = _m_v_0*dt;
+			Eigen::Vector3d k1_v = _m_v0_dot*dt;
+
+			// k2 ================
+			Eigen::Vector4d dq_1 = quatnorm(dq_0+0.5*k1_q);
+			Eigen::Vector3d v_1 = _m_v_0+0.5*k1_v;
+
+			Eigen::Vector4d q1_dot = 0.5*_m_omega_mid*dq_1;
+			Eigen::Vector3d p1_dot = v_1;
+			Eigen::Matrix3d R_Gto1 = quat_2_Rot(quat_multiply(dq_1,_m_q_0));
+			Eigen::Vector3d v1_dot = R_Gto1.transpose()*_m_a_mid-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+			Eigen::Vector4d k2_q = q1_dot*dt;
+			Eigen::Vector3d k2_p = p1_dot*dt;
+			Eigen::Vector3d k2_v = v1_dot*dt;
+
+			// k3 ================
+			Eigen::Vector4d dq_2 = quatnorm(dq_0+0.5*k2_q);
+			Eigen::Vector3d v_2 = _m_v_0+0.5*k2_v;
+
+			Eigen::Vector4d q2_dot = 0.5*_m_omega_mid*dq_2;
+			Eigen::Vector3d p2_dot = v_2;
+			Eigen::Matrix3d R_Gto2 = quat_2_Rot(quat_multiply(dq_2,_m_q_0));
+			Eigen::Vector3d v2_dot = R_Gto2.transpose()*_m_a_mid-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+			Eigen::Vector4d k3_q = q2_dot*dt;
+			Eigen::Vector3d k3_p = p2_dot*dt;
+			Eigen::Vector3d k3_v = v2_dot*dt;
+
+			// k4 ================
+			Eigen::Vector4d dq_3 = quatnorm(dq_0+k3_q);
+			Eigen::Vector3d v_3 = _m_v_0+k3_v;
+
+			Eigen::Vector4d q3_dot = 0.5*_m_omega_1*dq_3;
+			Eigen::Vector3d p3_dot = v_3;
+			Eigen::Matrix3d R_Gto3 = quat_2_Rot(quat_multiply(dq_3,_m_q_0));
+			Eigen::Vector3d v3_dot = R_Gto3.transpose()*_m_a_1-Eigen::Vector3d{0.0, 0.0, 9.81};
+
+			Eigen::Vector4d k4_q = q3_dot*dt;
+			Eigen::Vector3d k4_p = p3_dot*dt;
+			Eigen::Vector3d k4_v = v3_dot*dt;
+
+			// y+dt ================
+			Eigen::Matrix<double,13,1> state_plus = Eigen::Matrix<double,13,1>::Zero();
+			Eigen::Vector4d dq = quatnorm(dq_0+(1.0/6.0)*k1_q+(1.0/3.0)*k2_q+(1.0/3.0)*k3_q+(1.0/6.0)*k4_q);
+			state_plus.block(0,0,4,1) = quat_multiply(dq, _m_q_0);
+			state_plus.block(4,0,3,1) = _m_p_0+(1.0/6.0)*k1_p+(1.0/3.0)*k2_p+(1.0/3.0)*k3_p+(1.0/6.0)*k4_p;
+			state_plus.block(7,0,3,1) = _m_v_0+(1.0/6.0)*k1_v+(1.0/3.0)*k2_v+(1.0/3.0)*k3_v+(1.0/6.0)*k4_v;
+
+			return state_plus;
+		}
+
+	private:
+		Eigen::Matrix4d _m_omega_0;
+		Eigen::Matrix4d _m_omega_mid;
+		Eigen::Matrix4d _m_omega_1;
+		Eigen::Vector3d _m_a_0;
+		Eigen::Vector3d _m_a_mid;
+		Eigen::Vector3d _m_a_1;
+		Eigen::Vector4d _m_q_0;
+		Eigen::Vector3d _m_p_0;
+		Eigen::Vector3d _m_v_0;
+		Eigen::Vector4d _m_q0_dot;
+		Eigen::Vector3d _m_v0_dot;
+		time_type _m_imu_time;
+	};
+
+}
@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "../display_latency.hpp"
+
+namespace ILLIXR {
+
+class DisplayLatencyTest : public ::testing::Test {
+protected:
+	// A frame estimated at @p vsync, displayed @p late after it, with a pose predicted for @p target 10 ms earlier
+	static mtp_sample frame(time_type vsync, std::chrono::nanoseconds late, time_type target) {
+		return mtp_sample{
+			vsync,
+			vsync + late,
+			fast_pose_type{pose_type{}, vsync - std::chrono::milliseconds{10}, target},
+		};
+	}
+};
+
+TEST_F(DisplayLatencyTest, ConvergesOnAConstantLateness) {
+	display_latency latency {0.1};
+	ASSERT_EQ(latency.vsync_correction().count(), 0);
+	ASSERT_EQ(latency.predict_to_display().count(), 0);
+
+	const std::chrono::nanoseconds late = std::chrono::milliseconds{3};
+	time_type vsync {std::chrono::seconds{10}};
+	display_latency::errors errors {};
+	for (int i = 0; i < 200; i++) {
+		// Predict for the corrected target, as pose_prediction does
+		errors = latency.update(frame(vsync, late, vsync + latency.vsync_correction()));
+		vsync += std::chrono::microseconds{16667};
+	}
+
+	ASSERT_NEAR(double(latency.vsync_correction().count()), double(late.count()), 1e3);
+	ASSERT_NEAR(double(latency.predict_to_display().count()), double((std::chrono::milliseconds{10} + late).count()), 1e3);
+	ASSERT_EQ(errors.uncorrected, late);
+	ASSERT_LT(std::abs(errors.residual.count()), 1000);
+}
+
+TEST_F(DisplayLatencyTest, AnOutlierOnlyMovesTheCorrectionByAlpha) {
+	display_latency latency {0.1};
+	const time_type vsync {std::chrono::seconds{10}};
+	const display_latency::errors errors = latency.update(frame(vsync, std::chrono::milliseconds{16}, vsync));
+	ASSERT_EQ(errors.uncorrected, std::chrono::milliseconds{16});
+	ASSERT_EQ(errors.residual, std::chrono::milliseconds{16});
+	ASSERT_NEAR(double(latency.vsync_correction().count()), 1.6e6, 1.);
+}
+
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "../orientation_filter.hpp"
+
+namespace ILLIXR {
+
+class OrientationFilterTest : public ::testing::Test {
+protected:
+	static time_type at_ms(int ms) {
+		return time_type{std::chrono::milliseconds{1000 + ms}};
+	}
+
+	// The up direction the estimate puts in the body frame
+	static Eigen::Vector3f estimated_up(const orientation_filter& filter) {
+		return filter.latest()->orientation.inverse() * Eigen::Vector3f::UnitZ();
+	}
+
+	static const Eigen::Vector3f level;
+};
+
+const Eigen::Vector3f OrientationFilterTest::level {0.f, 0.f, 9.81f};
+
+TEST_F(OrientationFilterTest, NoEstimateBeforeTheFirstSample) {
+	orientation_filter filter {1.f};
+	ASSERT_FALSE(filter.latest().has_value());
+	filter.update(at_ms(0), Eigen::Vector3f::Zero(), level);
+	ASSERT_TRUE(filter.latest().has_value());
+	ASSERT_EQ(filter.latest()->time, at_ms(0));
+	ASSERT_LT(filter.latest()->orientation.angularDistance(Eigen::Quaternionf::Identity()), 1e-5f);
+}
+
+TEST_F(OrientationFilterTest, IntegratesTheGyro) {
+	// No correction, so only the gyro counts
+	orientation_filter filter {0.f};
+	const Eigen::Vector3f yaw_rate {0.f, 0.f, 1.f};
+	for (int ms = 0; ms <= 500; ms += 5) {
+		filter.update(at_ms(ms), yaw_rate, level);
+	}
+	const Eigen::Quaternionf expected {Eigen::AngleAxisf{0.5f, Eigen::Vector3f::UnitZ()}};
+	ASSERT_LT(filter.latest()->orientation.angularDistance(expected), 1e-4f);
+
+	// And predicts at the last rate
+	const Eigen::Quaternionf later {Eigen::AngleAxisf{0.6f, Eigen::Vector3f::UnitZ()}};
+	ASSERT_LT(orientation_filter::predict(*filter.latest(), at_ms(600)).angularDistance(later), 1e-4f);
+}
+
+TEST_F(OrientationFilterTest, ConvergesOnTheAccelerometersTilt) {
+	orientation_filter filter {2.f};
+	filter.update(at_ms(0), Eigen::Vector3f::Zero(), level);
+
+	// Tilted by 0.3 rad about x, which the (unmoving) gyro does not see
+	const Eigen::Vector3f tilted_up = Eigen::AngleAxisf{0.3f, Eigen::Vector3f::UnitX()} * Eigen::Vector3f::UnitZ();
+	for (int ms = 5; ms <= 5000; ms += 5) {
+		filter.update(at_ms(ms), Eigen::Vector3f::Zero(), 9.81f * tilted_up);
+	}
+	ASSERT_LT(std::acos(std::min(1.f, estimated_up(filter).dot(tilted_up))), 1e-3f);
+}
+
+TEST_F(OrientationFilterTest, IgnoresTheAccelerometerWhileAccelerating) {
+	orientation_filter filter {2.f};
+	filter.update(at_ms(0), Eigen::Vector3f::Zero(), level);
+	for (int ms = 5; ms <= 1000; ms += 5) {
+		filter.update(at_ms(ms), Eigen::Vector3f::Zero(), level + Eigen::Vector3f{8.f, 0.f, 0.f});
+	}
+	ASSERT_LT(filter.latest()->orientation.angularDistance(Eigen::Quaternionf::Identity()), 1e-5f);
+}
+
+}
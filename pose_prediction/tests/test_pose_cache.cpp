@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+#include "../pose_cache.hpp"
+
+namespace ILLIXR {
+
+class PoseCacheTest : public ::testing::Test {
+protected:
+	static pose_type make_pose(time_type target, float x) {
+		return pose_type{target - std::chrono::milliseconds{5}, Eigen::Vector3f{x, 2.f, 3.f}, Eigen::Quaternionf{0.5f, 0.5f, -0.5f, 0.5f}};
+	}
+
+	static imu_raw_type make_imu_raw(time_type imu_time) {
+		const Eigen::Vector3d zero = Eigen::Vector3d::Zero();
+		return imu_raw_type{zero, zero, zero, zero, zero, zero, Eigen::Quaterniond::Identity(), imu_time};
+	}
+};
+
+TEST_F(PoseCacheTest, HitsOnlyForTheSameKey) {
+	pose_cache cache {std::chrono::microseconds{1000}};
+	ASSERT_TRUE(cache.enabled());
+
+	const time_type target {std::chrono::seconds{100}};
+	const imu_raw_type imu_raw = make_imu_raw(target - std::chrono::milliseconds{5});
+	const imu_raw_type next_imu_raw = make_imu_raw(target - std::chrono::milliseconds{3});
+	const pose_cache::key key = cache.make_key(imu_raw, 0, target);
+
+	pose_type out;
+	ASSERT_FALSE(cache.lookup(key, out));
+	const pose_type stored = make_pose(target, 1.f);
+	cache.insert(key, stored);
+
+	ASSERT_TRUE(cache.lookup(key, out));
+	ASSERT_EQ(out.sensor_time, stored.sensor_time);
+	ASSERT_EQ(out.position, stored.position);
+	ASSERT_EQ(out.orientation.coeffs(), stored.orientation.coeffs());
+
+	// A target in the same bucket shares the pose
+	ASSERT_TRUE(cache.lookup(cache.make_key(imu_raw, 0, target + std::chrono::microseconds{999}), out));
+
+	ASSERT_FALSE(cache.lookup(cache.make_key(imu_raw, 0, target + std::chrono::microseconds{1000}), out));
+	ASSERT_FALSE(cache.lookup(cache.make_key(next_imu_raw, 0, target), out));
+	ASSERT_FALSE(cache.lookup(cache.make_key(imu_raw, 1, target), out));
+
+	ASSERT_EQ(cache.take_counts(), (std::pair<std::size_t, std::size_t>{2, 4}));
+	ASSERT_EQ(cache.take_counts(), (std::pair<std::size_t, std::size_t>{0, 0}));
+}
+
+TEST_F(PoseCacheTest, NewerEntriesReplaceOlderOnes) {
+	pose_cache cache {std::chrono::microseconds{1000}};
+	const time_type target {std::chrono::seconds{100}};
+	const imu_raw_type imu_raw = make_imu_raw(target - std::chrono::milliseconds{5});
+
+	cache.insert(cache.make_key(imu_raw, 0, target), make_pose(target, 1.f));
+	cache.insert(cache.make_key(imu_raw, 1, target), make_pose(target, 2.f));
+
+	pose_type out;
+	ASSERT_FALSE(cache.lookup(cache.make_key(imu_raw, 0, target), out));
+	ASSERT_TRUE(cache.lookup(cache.make_key(imu_raw, 1, target), out));
+	ASSERT_EQ(out.position.x(), 2.f);
+}
+
+// A new imu_raw (say, at a freed one's address) with the same integration time is the same propagation
+TEST_F(PoseCacheTest, KeysOnTheImuTimeNotTheObject) {
+	pose_cache cache {std::chrono::microseconds{1000}};
+	const time_type target {std::chrono::seconds{100}};
+	const imu_raw_type imu_raw = make_imu_raw(target - std::chrono::milliseconds{5});
+	cache.insert(cache.make_key(imu_raw, 0, target), make_pose(target, 1.f));
+
+	pose_type out;
+	ASSERT_TRUE(cache.lookup(cache.make_key(make_imu_raw(imu_raw.imu_time), 0, target), out));
+	ASSERT_FALSE(cache.lookup(cache.make_key(make_imu_raw(imu_raw.imu_time + std::chrono::nanoseconds{1}), 0, target), out));
+}
+
+TEST_F(PoseCacheTest, ZeroBucketWidthDisables) {
+	ASSERT_FALSE(pose_cache{std::chrono::microseconds{0}}.enabled());
+}
+
+}
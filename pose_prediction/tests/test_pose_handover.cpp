@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "../pose_handover.hpp"
+
+namespace ILLIXR {
+
+class PoseHandoverTest : public ::testing::Test {
+protected:
+	static Eigen::Quaternionf rotation(float yaw, float roll) {
+		return Eigen::Quaternionf{Eigen::AngleAxisf{yaw, Eigen::Vector3f::UnitZ()} * Eigen::AngleAxisf{roll, Eigen::Vector3f::UnitX()}};
+	}
+
+	static pose_type vio(const Eigen::Vector3f& position, const Eigen::Quaternionf& orientation) {
+		return pose_type{time_type{std::chrono::seconds{1}}, position, orientation};
+	}
+};
+
+TEST_F(PoseHandoverTest, StartsUnaligned) {
+	pose_handover handover;
+	ASSERT_EQ(handover.load().source, pose_source::none);
+
+	// Straight to VIO, without any IMU-only poses before
+	handover.switch_to_vio(vio(Eigen::Vector3f{1.f, 2.f, 3.f}, rotation(0.4f, 0.1f)), std::nullopt);
+	const pose_handover::state state = handover.load();
+	ASSERT_EQ(state.source, pose_source::vio);
+	const pose_type served = state.serve_vio(vio(Eigen::Vector3f{1.f, 2.f, 3.f}, rotation(0.4f, 0.1f)));
+	ASSERT_TRUE(served.position.isApprox(Eigen::Vector3f{1.f, 2.f, 3.f}));
+	ASSERT_LT(served.orientation.angularDistance(rotation(0.4f, 0.1f)), 1e-5f);
+}
+
+TEST_F(PoseHandoverTest, VioContinuesFromTheImuOnlyOrientation) {
+	pose_handover handover;
+	const Eigen::Quaternionf imu_only = rotation(1.2f, 0.1f);
+	handover.switch_to_imu_only(imu_only, std::nullopt);
+	ASSERT_EQ(handover.load().source, pose_source::imu_only);
+	ASSERT_TRUE(handover.load().serve_imu_only(time_type{}, imu_only).position.isZero());
+
+	// VIO agrees on the tilt but not the yaw
+	const pose_type first_vio = vio(Eigen::Vector3f{1.f, 0.f, 0.f}, rotation(-0.5f, 0.1f));
+	handover.switch_to_vio(first_vio, imu_only);
+	const pose_handover::state state = handover.load();
+	ASSERT_LT(state.serve_vio(first_vio).orientation.angularDistance(imu_only), 1e-5f);
+	ASSERT_LT(std::abs(state.vio_alignment.x()) + std::abs(state.vio_alignment.y()), 1e-6f);
+	// VIO starts from the held (zero) position, and moves as VIO does, rotated
+	ASSERT_TRUE(state.serve_vio(first_vio).position.isZero(1e-6f));
+	const pose_type later_vio = vio(Eigen::Vector3f{1.f, 1.f, 0.f}, rotation(-0.5f, 0.1f));
+	ASSERT_TRUE(state.serve_vio(later_vio).position.isApprox(state.vio_alignment * Eigen::Vector3f{0.f, 1.f, 0.f}));
+}
+
+TEST_F(PoseHandoverTest, ImuOnlyHoldsWhereVioLeftOff) {
+	pose_handover handover;
+	handover.switch_to_vio(vio(Eigen::Vector3f::Zero(), rotation(0.f, 0.f)), std::nullopt);
+
+	const pose_type last_vio = vio(Eigen::Vector3f{1.f, 2.f, 0.f}, rotation(0.7f, 0.2f));
+	const Eigen::Quaternionf imu_only = rotation(-2.f, 0.2f);
+	handover.switch_to_imu_only(imu_only, last_vio);
+	const pose_type served = handover.load().serve_imu_only(time_type{}, imu_only);
+	ASSERT_TRUE(served.position.isApprox(last_vio.position));
+	ASSERT_LT(served.orientation.angularDistance(last_vio.orientation), 1e-5f);
+
+	// Switching again is a no-op
+	handover.switch_to_imu_only(rotation(1.f, 0.f), std::nullopt);
+	ASSERT_LT(handover.load().serve_imu_only(time_type{}, imu_only).orientation.angularDistance(last_vio.orientation), 1e-5f);
+}
+
+// VIO, then IMU-only while the yaw drifts, then VIO again: neither switch moves the served pose
+TEST_F(PoseHandoverTest, RoundTripKeepsThePositionContinuous) {
+	pose_handover handover;
+	const pose_type first_vio = vio(Eigen::Vector3f{3.f, -1.f, 0.5f}, rotation(0.3f, 0.f));
+	handover.switch_to_vio(first_vio, std::nullopt);
+
+	const pose_type last_vio = vio(Eigen::Vector3f{4.f, 2.f, 0.5f}, rotation(0.6f, 0.1f));
+	const pose_type served_before = handover.load().serve_vio(last_vio);
+	handover.switch_to_imu_only(rotation(-1.f, 0.1f), last_vio);
+	const pose_type held = handover.load().serve_imu_only(time_type{}, rotation(-1.f, 0.1f));
+	ASSERT_TRUE(held.position.isApprox(served_before.position));
+	ASSERT_LT(held.orientation.angularDistance(served_before.orientation), 1e-5f);
+
+	// The IMU-only yaw drifts meanwhile; VIO comes back elsewhere, with its own yaw
+	const Eigen::Quaternionf imu_only = rotation(-0.5f, 0.1f);
+	const pose_type imu_only_served = handover.load().serve_imu_only(time_type{}, imu_only);
+	const pose_type next_vio = vio(Eigen::Vector3f{10.f, 5.f, 0.5f}, rotation(0.9f, 0.1f));
+	handover.switch_to_vio(next_vio, imu_only);
+	const pose_handover::state state = handover.load();
+	const pose_type served_after = state.serve_vio(next_vio);
+	ASSERT_TRUE(served_after.position.isApprox(held.position));
+	ASSERT_LT(served_after.orientation.angularDistance(imu_only_served.orientation), 1e-5f);
+
+	// From there on, VIO's motion is served rotated by the new alignment
+	const pose_type moved_vio = vio(next_vio.position + Eigen::Vector3f{1.f, 0.f, 0.f}, next_vio.orientation);
+	ASSERT_TRUE(state.serve_vio(moved_vio).position.isApprox(held.position + state.vio_alignment * Eigen::Vector3f{1.f, 0.f, 0.f}));
+}
+
+}
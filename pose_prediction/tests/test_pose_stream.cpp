@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "../pose_stream.hpp"
+
+namespace ILLIXR {
+
+class PoseStreamTest : public ::testing::Test {
+protected:
+	// A head moving at 2 m/s along x and turning at 1 rad/s about its own y axis
+	static fast_pose_type pose_at(time_type t) {
+		const float s = std::chrono::duration<float>(t.time_since_epoch()).count() - 100.f;
+		const Eigen::Quaternionf start {Eigen::AngleAxisf{0.3f, Eigen::Vector3f::UnitZ()}};
+		return fast_pose_type{
+			pose_type{time_type{std::chrono::seconds{99}}, Eigen::Vector3f{2.f * s, 1.f, 0.f}, start * Eigen::Quaternionf{Eigen::AngleAxisf{s, Eigen::Vector3f::UnitY()}}},
+			time_type{std::chrono::seconds{99}},
+			t,
+		};
+	}
+};
+
+TEST_F(PoseStreamTest, NothingUntilPublished) {
+	pose_stream stream;
+	ASSERT_FALSE(stream.latest(0).has_value());
+}
+
+TEST_F(PoseStreamTest, ExtrapolatesAtConstantVelocity) {
+	pose_stream stream;
+	const time_type t {std::chrono::seconds{100}};
+	const std::chrono::milliseconds h {1};
+	stream.publish(pose_at(t), pose_at(t + h), 3);
+
+	ASSERT_FALSE(stream.latest(4).has_value());
+	const std::optional<pose_stream_type> latest = stream.latest(3);
+	ASSERT_TRUE(latest.has_value());
+	ASSERT_TRUE(latest->linear_velocity.isApprox(Eigen::Vector3f{2.f, 0.f, 0.f}, 1e-3f));
+	ASSERT_TRUE(latest->angular_velocity.isApprox(Eigen::Vector3f{0.f, 1.f, 0.f}, 1e-3f));
+
+	for (const std::chrono::microseconds ahead : {std::chrono::microseconds{0}, std::chrono::microseconds{500}, std::chrono::microseconds{4000}}) {
+		const fast_pose_type expected = pose_at(t + ahead);
+		const fast_pose_type actual = pose_stream::extrapolate(*latest, t + ahead);
+		ASSERT_EQ(actual.predict_target_time, t + ahead);
+		ASSERT_EQ(actual.predict_computed_time, expected.predict_computed_time);
+		ASSERT_TRUE(actual.pose.position.isApprox(expected.pose.position, 1e-4f));
+		ASSERT_LT(actual.pose.orientation.angularDistance(expected.pose.orientation), 1e-4f);
+	}
+}
+
+}
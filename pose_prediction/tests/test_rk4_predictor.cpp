@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include "../rk4_predictor.hpp"
+
+namespace ILLIXR {
+
+class Rk4PredictorTest : public ::testing::Test { };
+
+TEST_F(Rk4PredictorTest, ZeroDtIsTheImuState) {
+	const Eigen::Quaterniond quat {Eigen::AngleAxisd{0.4, Eigen::Vector3d{1., 2., 3.}.normalized()}};
+	const imu_raw_type imu_raw {
+		Eigen::Vector3d{0.3, -0.2, 0.1}, Eigen::Vector3d{0.5, 0.4, 9.9},
+		Eigen::Vector3d{0.32, -0.21, 0.12}, Eigen::Vector3d{0.45, 0.42, 9.85},
+		Eigen::Vector3d{1., 2., 1.5}, Eigen::Vector3d{0.2, -0.1, 0.05},
+		quat, time_type{std::chrono::seconds{3}},
+	};
+	const rk4_predictor predictor {imu_raw};
+	ASSERT_EQ(predictor.imu_time(), imu_raw.imu_time);
+
+	const Eigen::Matrix<double,13,1> state = predictor.predict(0.);
+	ASSERT_TRUE(state.head<4>().isApprox(Eigen::Vector4d{quat.x(), quat.y(), quat.z(), quat.w()}));
+	ASSERT_TRUE(state.segment<3>(4).isApprox(imu_raw.pos));
+	ASSERT_TRUE(state.segment<3>(7).isApprox(imu_raw.vel));
+}
+
+TEST_F(Rk4PredictorTest, ConstantVelocityWhenOnlyGravityIsMeasured) {
+	const imu_raw_type imu_raw {
+		Eigen::Vector3d::Zero(), Eigen::Vector3d{0., 0., 9.81},
+		Eigen::Vector3d::Zero(), Eigen::Vector3d{0., 0., 9.81},
+		Eigen::Vector3d{1., 2., 3.}, Eigen::Vector3d{0.5, 0., -0.25},
+		Eigen::Quaterniond::Identity(), time_type{},
+	};
+	const rk4_predictor predictor {imu_raw};
+
+	for (const double dt : {0.004, 0.016, 0.05}) {
+		const Eigen::Matrix<double,13,1> state = predictor.predict(dt);
+		ASSERT_TRUE(state.head<4>().isApprox(Eigen::Vector4d{0., 0., 0., 1.}));
+		ASSERT_TRUE(state.segment<3>(4).isApprox(imu_raw.pos + imu_raw.vel * dt));
+		ASSERT_TRUE(state.segment<3>(7).isApprox(imu_raw.vel));
+	}
+}
+
+}
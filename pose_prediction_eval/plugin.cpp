@@ -0,0 +1,208 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/data_format.hpp"
+#include "common/phonebook.hpp"
+#include "common/pose_prediction.hpp"
+#include "common/switchboard.hpp"
+#include "common/threadloop.hpp"
+#include "prediction_scorer.hpp"
+
+using namespace ILLIXR;
+
+// One record per scored prediction; errors in meters and degrees (see prediction_scorer)
+const record_header pose_prediction_eval_record {
+	"pose_prediction_eval",
+	{
+		{"horizon", typeid(std::chrono::nanoseconds)},
+		{"target_time", typeid(std::chrono::high_resolution_clock::time_point)},
+		{"compute_time", typeid(std::chrono::nanoseconds)},
+		{"position_error", typeid(double)},
+		{"orientation_error", typeid(double)},
+		{"motion_position_error", typeid(double)},
+		{"motion_orientation_error", typeid(double)},
+		{"hold_position_error", typeid(double)},
+		{"hold_orientation_error", typeid(double)},
+	},
+};
+
+static
+std::vector<std::chrono::nanoseconds>
+parse_horizons(const std::string& milliseconds) {
+	std::vector<std::chrono::nanoseconds> horizons;
+	std::istringstream list {milliseconds};
+	std::string item;
+	while (std::getline(list, item, ',')) {
+		if (!item.empty()) {
+			horizons.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>{std::stod(item)}));
+		}
+	}
+	return horizons;
+}
+
+/**
+ * @brief Scores `pose_prediction` against the ground truth on `true_pose`.
+ *
+ * At `ILLIXR_POSE_EVAL_HZ`, it asks for the pose now and at each of `ILLIXR_POSE_EVAL_HORIZONS_MS` ahead,
+ * timing each call. Once the ground truth reaches a prediction's target, the prediction is scored
+ * and logged as a `pose_prediction_eval` record. A summary per horizon is printed at the end.
+ */
+class pose_prediction_eval : public threadloop {
+public:
+	pose_prediction_eval(std::string name_, phonebook* pb_)
+		: threadloop{name_, pb_}
+		, sb{pb->lookup_impl<switchboard>()}
+		, pp{pb->lookup_impl<pose_prediction>()}
+		, _m_ground_truth_offset{sb->get_reader<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
+		, _m_horizons{parse_horizons(ILLIXR::getenv_or("ILLIXR_POSE_EVAL_HORIZONS_MS", "5,10,20,33,50"))}
+		, _m_period{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{1 / std::stod(ILLIXR::getenv_or("ILLIXR_POSE_EVAL_HZ", "100"))})}
+		, _m_log{record_logger_}
+	{ }
+
+	virtual void start() override {
+		threadloop::start();
+		sb->schedule<pose_type>(id, "true_pose", [this](switchboard::ptr<const pose_type> true_pose, std::size_t) {
+			this->add_ground_truth(*true_pose);
+		});
+	}
+
+	virtual void stop() override {
+		threadloop::stop();
+		print_summary();
+	}
+
+protected:
+	virtual skip_option _p_should_skip() override {
+		std::this_thread::sleep_for(_m_period);
+		return pp->fast_pose_reliable() ? skip_option::run : skip_option::skip_and_yield;
+	}
+
+	virtual void _p_one_iteration() override {
+		const time_type query_time = std::chrono::system_clock::now();
+		const pose_type anchor = pp->get_fast_pose(query_time).pose;
+
+		std::vector<prediction_scorer::prediction> predictions;
+		predictions.reserve(_m_horizons.size());
+		for (const std::chrono::nanoseconds horizon : _m_horizons) {
+			const time_type target_time = query_time + horizon;
+			const auto start = std::chrono::steady_clock::now();
+			const fast_pose_type fast_pose = pp->get_fast_pose(target_time);
+			const auto compute_time = std::chrono::steady_clock::now() - start;
+			predictions.push_back(prediction_scorer::prediction{
+				horizon,
+				query_time,
+				anchor,
+				fast_pose.pose,
+				target_time,
+				std::chrono::duration_cast<std::chrono::nanoseconds>(compute_time),
+			});
+		}
+
+		std::vector<prediction_scorer::score> scores;
+		{
+			std::lock_guard<std::mutex> lock {_m_scorer_mutex};
+			for (const prediction_scorer::prediction& p : predictions) {
+				_m_scorer.add_prediction(p);
+			}
+			scores = _m_scorer.take_scores();
+		}
+
+		for (const prediction_scorer::score& s : scores) {
+			_m_log.log(record{pose_prediction_eval_record, {
+				{s.horizon},
+				{s.target_time},
+				{s.compute_time},
+				{s.position_error},
+				{s.orientation_error},
+				{s.motion_position_error},
+				{s.motion_orientation_error},
+				{s.hold_position_error},
+				{s.hold_orientation_error},
+			}});
+			_m_totals[s.horizon].add(s);
+		}
+	}
+
+private:
+	// Corrected as get_true_pose does, so it is in the predictions' frame
+	void add_ground_truth(const pose_type& true_pose) {
+		switchboard::ptr<const switchboard::event_wrapper<Eigen::Vector3f>> offset = _m_ground_truth_offset.get_ro_nullable();
+		if (offset == nullptr) {
+			return;
+		}
+		pose_type offset_pose = true_pose;
+		offset_pose.position -= **offset;
+
+		const pose_type corrected = pp->correct_pose(offset_pose);
+		std::lock_guard<std::mutex> lock {_m_scorer_mutex};
+		_m_scorer.add_ground_truth(corrected);
+	}
+
+	struct totals {
+		std::size_t count = 0;
+		std::chrono::nanoseconds compute_time {0};
+		double position_error = 0;
+		double orientation_error = 0;
+		double motion_position_error = 0;
+		double motion_orientation_error = 0;
+		double hold_position_error = 0;
+		double hold_orientation_error = 0;
+
+		void add(const prediction_scorer::score& s) {
+			count++;
+			compute_time += s.compute_time;
+			position_error += s.position_error;
+			orientation_error += s.orientation_error;
+			motion_position_error += s.motion_position_error;
+			motion_orientation_error += s.motion_orientation_error;
+			hold_position_error += s.hold_position_error;
+			hold_orientation_error += s.hold_orientation_error;
+		}
+	};
+
+	void print_summary() {
+		std::size_t unmatched;
+		{
+			std::lock_guard<std::mutex> lock {_m_scorer_mutex};
+			unmatched = _m_scorer.unmatched();
+		}
+		std::cout << "pose_prediction_eval: means per horizon (mm, degrees), " << unmatched << " unmatched\n"
+				  << std::setw(10) << "horizon" << std::setw(8) << "count" << std::setw(12) << "compute ns"
+				  << std::setw(10) << "pos" << std::setw(10) << "rot"
+				  << std::setw(12) << "motion pos" << std::setw(12) << "motion rot"
+				  << std::setw(10) << "hold pos" << std::setw(10) << "hold rot" << "\n"
+				  << std::fixed << std::setprecision(2);
+		for (const auto& [horizon, t] : _m_totals) {
+			const double n = double(t.count);
+			std::cout << std::setw(8) << std::chrono::duration<double, std::milli>(horizon).count() << "ms"
+					  << std::setw(8) << t.count
+					  << std::setw(12) << double(t.compute_time.count()) / n
+					  << std::setw(10) << 1000 * t.position_error / n << std::setw(10) << t.orientation_error / n
+					  << std::setw(12) << 1000 * t.motion_position_error / n << std::setw(12) << t.motion_orientation_error / n
+					  << std::setw(10) << 1000 * t.hold_position_error / n << std::setw(10) << t.hold_orientation_error / n << "\n";
+		}
+		std::cout << std::flush;
+	}
+
+	const std::shared_ptr<switchboard> sb;
+	const std::shared_ptr<pose_prediction> pp;
+	switchboard::reader<switchboard::event_wrapper<Eigen::Vector3f>> _m_ground_truth_offset;
+	const std::vector<std::chrono::nanoseconds> _m_horizons;
+	const std::chrono::nanoseconds _m_period;
+
+	// Ground truth comes in on switchboard's thread, predictions on this one
+	std::mutex _m_scorer_mutex;
+	prediction_scorer _m_scorer;
+
+	record_coalescer _m_log;
+	std::map<std::chrono::nanoseconds, totals> _m_totals;
+};
+
+PLUGIN_MAIN(pose_prediction_eval);
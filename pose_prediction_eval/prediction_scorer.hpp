@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "common/data_format.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Scores pose predictions against the ground truth at their target times, once it has arrived.
+	 *
+	 * Errors are reported two ways:
+	 * - absolute: the predicted pose against the ground truth, in the frame `get_true_pose` corrects it to.
+	 *   This assumes SLAM's world frame matches the ground truth's, as debugview does.
+	 * - motion: the motion predicted from the query time to the target (from the pose predicted for the query
+	 *   time itself) against the ground truth's motion, each in its own body frame at the query time.
+	 *   This does not depend on how the world frames line up, and it is what extrapolation is responsible for.
+	 *   The ground truth's motion is also the error of not predicting at all ("hold").
+	 *
+	 * Not thread-safe.
+	 */
+	class prediction_scorer {
+	public:
+		struct prediction {
+			std::chrono::nanoseconds horizon;
+			time_type query_time;
+			// Predicted for query_time, where the predicted motion starts
+			pose_type anchor;
+			pose_type predicted;
+			time_type target_time;
+			// Of the get_fast_pose call
+			std::chrono::nanoseconds compute_time;
+		};
+
+		struct score {
+			std::chrono::nanoseconds horizon;
+			time_type target_time;
+			std::chrono::nanoseconds compute_time;
+			// Meters and degrees
+			double position_error;
+			double orientation_error;
+			double motion_position_error;
+			double motion_orientation_error;
+			double hold_position_error;
+			double hold_orientation_error;
+		};
+
+		/// Ground truth must come in time order; a sample older than the newest is dropped
+		void add_ground_truth(const pose_type& true_pose) {
+			if (!_m_ground_truth.empty() && true_pose.sensor_time <= _m_ground_truth.back().sensor_time) {
+				return;
+			}
+			_m_ground_truth.push_back(true_pose);
+		}
+
+		void add_prediction(const prediction& p) {
+			_m_pending.push_back(p);
+		}
+
+		/// Scores of the predictions whose target the ground truth has reached
+		std::vector<score> take_scores() {
+			std::vector<score> scores;
+			if (_m_ground_truth.empty()) {
+				return scores;
+			}
+			const time_type newest = _m_ground_truth.back().sensor_time;
+
+			std::vector<prediction> still_pending;
+			for (const prediction& p : _m_pending) {
+				if (p.target_time > newest) {
+					still_pending.push_back(p);
+					continue;
+				}
+				const std::optional<pose_type> true_at_query = ground_truth_at(p.query_time);
+				const std::optional<pose_type> true_at_target = ground_truth_at(p.target_time);
+				if (!true_at_query || !true_at_target) {
+					// Before the ground truth started
+					_m_unmatched++;
+					continue;
+				}
+				scores.push_back(score_of(p, *true_at_query, *true_at_target));
+			}
+			_m_pending = std::move(still_pending);
+
+			forget_ground_truth_before(earliest_needed());
+			return scores;
+		}
+
+		/// Predictions dropped because the ground truth started after their query time
+		std::size_t unmatched() const {
+			return _m_unmatched;
+		}
+
+		/// Interpolated between the samples around @p time, if there is ground truth on both sides
+		std::optional<pose_type> ground_truth_at(time_type time) const {
+			const auto after = std::lower_bound(_m_ground_truth.cbegin(), _m_ground_truth.cend(), time,
+				[](const pose_type& sample, time_type t) { return sample.sensor_time < t; });
+			if (after == _m_ground_truth.cend()) {
+				return std::nullopt;
+			}
+			if (after->sensor_time == time) {
+				return *after;
+			}
+			if (after == _m_ground_truth.cbegin()) {
+				return std::nullopt;
+			}
+			const pose_type& before = *std::prev(after);
+			const float s = std::chrono::duration<float>(time - before.sensor_time).count()
+				/ std::chrono::duration<float>(after->sensor_time - before.sensor_time).count();
+			return pose_type{
+				time,
+				before.position + s * (after->position - before.position),
+				before.orientation.slerp(s, after->orientation),
+			};
+		}
+
+	private:
+		static double degrees(float radians) {
+			return double(radians) * 180. / M_PI;
+		}
+
+		static score score_of(const prediction& p, const pose_type& true_at_query, const pose_type& true_at_target) {
+			const Eigen::Vector3f predicted_motion = p.anchor.orientation.inverse() * (p.predicted.position - p.anchor.position);
+			const Eigen::Quaternionf predicted_turn = p.anchor.orientation.inverse() * p.predicted.orientation;
+			const Eigen::Vector3f true_motion = true_at_query.orientation.inverse() * (true_at_target.position - true_at_query.position);
+			const Eigen::Quaternionf true_turn = true_at_query.orientation.inverse() * true_at_target.orientation;
+
+			return score{
+				p.horizon,
+				p.target_time,
+				p.compute_time,
+				(p.predicted.position - true_at_target.position).norm(),
+				degrees(p.predicted.orientation.angularDistance(true_at_target.orientation)),
+				(predicted_motion - true_motion).norm(),
+				degrees(predicted_turn.angularDistance(true_turn)),
+				true_motion.norm(),
+				degrees(true_turn.angularDistance(Eigen::Quaternionf::Identity())),
+			};
+		}
+
+		time_type earliest_needed() const {
+			time_type earliest = _m_ground_truth.back().sensor_time;
+			for (const prediction& p : _m_pending) {
+				earliest = std::min(earliest, p.query_time);
+			}
+			return earliest;
+		}
+
+		// Keeping the sample just before, to interpolate from
+		void forget_ground_truth_before(time_type time) {
+			while (_m_ground_truth.size() >= 2 && _m_ground_truth[1].sensor_time <= time) {
+				_m_ground_truth.pop_front();
+			}
+		}
+
+		std::deque<pose_type> _m_ground_truth;
+		std::vector<prediction> _m_pending;
+		std::size_t _m_unmatched = 0;
+	};
+
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "../prediction_scorer.hpp"
+
+namespace ILLIXR {
+
+class PredictionScorerTest : public ::testing::Test {
+protected:
+	static time_type at_ms(int ms) {
+		return time_type{std::chrono::milliseconds{1000 + ms}};
+	}
+
+	// Ground truth moving at 1 m/s along x, turning at 1 rad/s about z
+	static pose_type truth(int ms) {
+		const float s = float(ms) / 1000.f;
+		return pose_type{at_ms(ms), Eigen::Vector3f{s, 0.f, 0.f}, Eigen::Quaternionf{Eigen::AngleAxisf{s, Eigen::Vector3f::UnitZ()}}};
+	}
+
+	static prediction_scorer::prediction predict(int query_ms, int horizon_ms, const pose_type& predicted) {
+		return prediction_scorer::prediction{
+			std::chrono::milliseconds{horizon_ms},
+			at_ms(query_ms),
+			truth(query_ms),
+			predicted,
+			at_ms(query_ms + horizon_ms),
+			std::chrono::nanoseconds{500},
+		};
+	}
+};
+
+TEST_F(PredictionScorerTest, InterpolatesGroundTruth) {
+	prediction_scorer scorer;
+	scorer.add_ground_truth(truth(0));
+	scorer.add_ground_truth(truth(10));
+
+	ASSERT_FALSE(scorer.ground_truth_at(at_ms(-1)).has_value());
+	ASSERT_FALSE(scorer.ground_truth_at(at_ms(11)).has_value());
+	const std::optional<pose_type> middle = scorer.ground_truth_at(at_ms(4));
+	ASSERT_TRUE(middle.has_value());
+	ASSERT_TRUE(middle->position.isApprox(truth(4).position, 1e-5f));
+	ASSERT_LT(middle->orientation.angularDistance(truth(4).orientation), 1e-5f);
+}
+
+TEST_F(PredictionScorerTest, ScoresOnceTheTargetIsReached) {
+	prediction_scorer scorer;
+	for (int ms = 0; ms <= 20; ms += 5) {
+		scorer.add_ground_truth(truth(ms));
+	}
+	// A perfect prediction, one that holds the pose, and one that is not due yet
+	scorer.add_prediction(predict(2, 10, truth(12)));
+	scorer.add_prediction(predict(2, 10, truth(2)));
+	scorer.add_prediction(predict(2, 30, truth(32)));
+
+	std::vector<prediction_scorer::score> scores = scorer.take_scores();
+	ASSERT_EQ(scores.size(), 2U);
+
+	const prediction_scorer::score& perfect = scores[0];
+	ASSERT_EQ(perfect.horizon, std::chrono::milliseconds{10});
+	ASSERT_EQ(perfect.target_time, at_ms(12));
+	ASSERT_EQ(perfect.compute_time, std::chrono::nanoseconds{500});
+	ASSERT_NEAR(perfect.position_error, 0., 1e-5);
+	ASSERT_NEAR(perfect.motion_position_error, 0., 1e-5);
+	ASSERT_NEAR(perfect.motion_orientation_error, 0., 1e-2);
+	ASSERT_NEAR(perfect.hold_position_error, 0.01, 1e-5);
+	ASSERT_NEAR(perfect.hold_orientation_error, 0.01 * 180. / M_PI, 1e-2);
+
+	const prediction_scorer::score& hold = scores[1];
+	ASSERT_NEAR(hold.position_error, 0.01, 1e-5);
+	ASSERT_NEAR(hold.motion_position_error, hold.hold_position_error, 1e-5);
+	ASSERT_NEAR(hold.motion_orientation_error, hold.hold_orientation_error, 1e-2);
+
+	ASSERT_TRUE(scorer.take_scores().empty());
+	scorer.add_ground_truth(truth(35));
+	scores = scorer.take_scores();
+	ASSERT_EQ(scores.size(), 1U);
+	ASSERT_EQ(scores[0].horizon, std::chrono::milliseconds{30});
+	ASSERT_EQ(scorer.unmatched(), 0U);
+}
+
+TEST_F(PredictionScorerTest, DropsPredictionsFromBeforeTheGroundTruth) {
+	prediction_scorer scorer;
+	scorer.add_prediction(predict(0, 10, truth(10)));
+	scorer.add_ground_truth(truth(5));
+	scorer.add_ground_truth(truth(15));
+	ASSERT_TRUE(scorer.take_scores().empty());
+	ASSERT_EQ(scorer.unmatched(), 1U);
+}
+
+}
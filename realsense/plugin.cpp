@@ -6,6 +6,8 @@
 #include "common/threadloop.hpp"
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
+#include "common/sensor_publisher.hpp"
+#include "common/frame_pool.hpp"
 
 using namespace ILLIXR;
 
@@ -23,7 +25,8 @@ public:
 	realsense(std::string name_, phonebook *pb_)
         : plugin{name_, pb_}
         , sb{pb->lookup_impl<switchboard>()}
-        , _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
+        , _m_frame_pool{pb->lookup_impl<frame_pool>()}
+        , _m_publisher{sb, "realsense"}
         , _m_rgb_depth{sb->get_writer<rgb_depth_type>("rgb_depth")}
         , realsense_cam{ILLIXR::getenv_or("REALSENSE_CAM", "auto")}
         {      
@@ -42,20 +45,22 @@ public:
                 if (auto fs = frame.as<rs2::frameset>()) {
                     rs2::video_frame ir_frame_left = fs.get_infrared_frame(1);
                     rs2::video_frame ir_frame_right = fs.get_infrared_frame(2);
-                    rs2::video_frame depth_frame = fs.get_depth_frame();
+                    rs2::depth_frame depth_frame = fs.get_depth_frame();
                     rs2::video_frame rgb_frame = fs.get_color_frame();
-                    cv::Mat ir_left = cv::Mat(cv::Size(IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX), CV_8UC1, (void*)ir_frame_left.get_data());
-                    cv::Mat ir_right = cv::Mat(cv::Size(IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX), CV_8UC1, (void *)ir_frame_right.get_data());
-                    cv::Mat rgb = cv::Mat(cv::Size(IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX), CV_8UC3, (void *)rgb_frame.get_data());
-                    cv::Mat depth = cv::Mat(cv::Size(IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX), CV_16UC1, (void *)depth_frame.get_data());
-                    cv::Mat converted_depth;
-                    float depth_scale = pipe.get_active_profile().get_device().first<rs2::depth_sensor>().get_depth_scale(); // for converting measurements into millimeters
-                    depth.convertTo(converted_depth, CV_32FC1, depth_scale * 1000.f);
+                    // Zero-copy: each Mat holds a reference to its rs2::frame, so librealsense cannot recycle it while in use.
+                    cv::Mat ir_left = wrap_frame(ir_frame_left, IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX, CV_8UC1);
+                    cv::Mat ir_right = wrap_frame(ir_frame_right, IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX, CV_8UC1);
+                    cv::Mat rgb = wrap_frame(rgb_frame, IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX, CV_8UC3);
+                    // Depth stays in raw Z16 units; the depth_pointcloud plugin converts it off this callback thread.
+                    cv::Mat depth = wrap_frame(depth_frame, IMAGE_WIDTH_D4XX, IMAGE_HEIGHT_D4XX, CV_16UC1);
+                    rs2_intrinsics intrinsics = depth_frame.get_profile().as<rs2::video_stream_profile>().get_intrinsics();
                     cam_type_ = cam_type {
                         .img0 = cv::Mat{ir_left},
                         .img1 = cv::Mat{ir_right},
                         .rgb = cv::Mat{rgb},
-                        .depth = cv::Mat{converted_depth},
+                        .depth = cv::Mat{depth},
+                        .depth_scale = depth_frame.get_units(),
+                        .intrinsics = depth_intrinsics{intrinsics.fx, intrinsics.fy, intrinsics.ppx, intrinsics.ppy},
                         .iteration = iteration_cam,
                     };
                     iteration_cam++;
@@ -66,8 +71,8 @@ public:
                 if (auto fs = frame.as<rs2::frameset>()) {
                     rs2::video_frame fisheye_frame_left = fs.get_fisheye_frame(1);
                     rs2::video_frame fisheye_frame_right = fs.get_fisheye_frame(2);
-                    cv::Mat fisheye_left = cv::Mat(cv::Size(IMAGE_WIDTH_T26X, IMAGE_HEIGHT_T26X), CV_8UC1, (void*)fisheye_frame_left.get_data());
-                    cv::Mat fisheye_right = cv::Mat(cv::Size(IMAGE_WIDTH_T26X, IMAGE_HEIGHT_T26X), CV_8UC1, (void *)fisheye_frame_right.get_data());
+                    cv::Mat fisheye_left = wrap_frame(fisheye_frame_left, IMAGE_WIDTH_T26X, IMAGE_HEIGHT_T26X, CV_8UC1);
+                    cv::Mat fisheye_right = wrap_frame(fisheye_frame_right, IMAGE_WIDTH_T26X, IMAGE_HEIGHT_T26X, CV_8UC1);
                     cam_type_ = cam_type {
                         .img0 = cv::Mat{fisheye_left},
                         .img1 = cv::Mat{fisheye_right},
@@ -116,7 +121,7 @@ public:
                     std::optional<cv::Mat> rgb = std::nullopt;
                     std::optional<cv::Mat> depth = std::nullopt;
 
-                        
+
                     if (last_iteration_cam != cam_type_.iteration)
                     {
                         last_iteration_cam = cam_type_.iteration;
@@ -127,16 +132,15 @@ public:
                     }
                     
                     // Submit to switchboard
-                    _m_imu_cam.put(_m_imu_cam.allocate<imu_cam_type>(
-                        {
-                            imu_time_point,
-                            av,
-                            la,
-                            img0,
-                            img1,
-                            imu_time
-                        }
-                    ));
+                    // RGB-D images go in the same frame set, as the "rgb" and "depth" cameras
+                    std::vector<camera_image> rgbd;
+                    if (rgb) {
+                        rgbd.push_back(_m_publisher.image("rgb", image_plane::color, imu_time_point, imu_time, *rgb));
+                    }
+                    if (depth) {
+                        rgbd.push_back(_m_publisher.depth_image("depth", imu_time_point, imu_time, *depth, cam_type_.depth_scale));
+                    }
+                    _m_publisher.put(imu_time_point, av, la, img0, img1, imu_time, std::move(rgbd));
                     
                     if (rgb && depth)
                     {
@@ -144,7 +148,9 @@ public:
                             {
                                 rgb,
                                 depth,
-                                imu_time
+                                imu_time,
+                                cam_type_.depth_scale,
+                                cam_type_.intrinsics
                             }
                         ));
                     }
@@ -156,11 +162,18 @@ public:
 	virtual ~realsense() override { pipe.stop(); }
 
 private:
+    cv::Mat wrap_frame(const rs2::video_frame& frame, int width, int height, int type) const {
+        return _m_frame_pool->wrap(height, width, type, const_cast<void*>(frame.get_data()), frame.get_stride_in_bytes(),
+                                   std::make_shared<rs2::video_frame>(frame));
+    }
+
     typedef struct {
         cv::Mat img0;
         cv::Mat img1;
         cv::Mat rgb;
         cv::Mat depth;
+        float depth_scale;
+        depth_intrinsics intrinsics;
         int iteration;
     } cam_type;
 
@@ -176,7 +189,8 @@ private:
     } accel_type;
 
 	const std::shared_ptr<switchboard> sb;
-    switchboard::writer<imu_cam_type> _m_imu_cam;
+    const std::shared_ptr<frame_pool> _m_frame_pool;
+    sensor_publisher _m_publisher;
 	switchboard::writer<rgb_depth_type> _m_rgb_depth;
     std::mutex mutex;
 	rs2::pipeline_profile profiles;
@@ -0,0 +1,140 @@
+/*
+ * Speed and accuracy of the RK4 step in each precision, on a synthetic IMU stream.
+ *
+ * - double: the reference (ILLIXR_RK4_PRECISION=double)
+ * - float: the same step in float (ILLIXR_RK4_PRECISION=float)
+ *
+ * Errors are against double, after a typical integration window and after the whole stream.
+ *
+ * Build and run with `make benchmarks/run`.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../propagator.hpp"
+
+using namespace ILLIXR;
+
+namespace {
+
+	constexpr double imu_rate = 200.;
+	constexpr double duration = 10.;
+	// About as long as the window between two slow poses
+	constexpr std::size_t window_steps = 20;
+	constexpr int repetitions = 50;
+
+	struct sample {
+		double dt;
+		Eigen::Vector3d w_hat;
+		Eigen::Vector3d a_hat;
+	};
+
+	std::vector<sample> make_stream() {
+		std::mt19937 rng {0};
+		std::normal_distribution<double> noise {0., 0.01};
+		std::vector<sample> stream;
+		for (double t = 0; t < duration; t += 1. / imu_rate) {
+			stream.push_back(sample{
+				1. / imu_rate,
+				Eigen::Vector3d{0.3 * std::sin(t), 0.2 * std::cos(0.7 * t), 0.1 * std::sin(1.3 * t)} + Eigen::Vector3d::Constant(noise(rng)),
+				Eigen::Vector3d{0.5 * std::cos(t), 0.4 * std::sin(0.5 * t), 9.81 + 0.2 * std::sin(2. * t)} + Eigen::Vector3d::Constant(noise(rng)),
+			});
+		}
+		return stream;
+	}
+
+	template <typename T>
+	struct state {
+		Eigen::Matrix<T, 4, 1> quat {0, 0, 0, 1};
+		Eigen::Matrix<T, 3, 1> pos {Eigen::Matrix<T, 3, 1>::Zero()};
+		Eigen::Matrix<T, 3, 1> vel {Eigen::Matrix<T, 3, 1>::Zero()};
+	};
+
+	struct double_step {
+		void operator()(state<double>& s, const sample& from, const sample& to) const {
+			const state<double> in = s;
+			predict_mean_rk4(in.quat, in.pos, in.vel, from.dt, from.w_hat, from.a_hat, to.w_hat, to.a_hat, s.quat, s.vel, s.pos);
+		}
+	};
+
+	struct float_step {
+		void operator()(state<float>& s, const sample& from, const sample& to) const {
+			const Eigen::Vector3f w_hat = from.w_hat.cast<float>();
+			const Eigen::Vector3f a_hat = from.a_hat.cast<float>();
+			const Eigen::Vector3f w_hat2 = to.w_hat.cast<float>();
+			const Eigen::Vector3f a_hat2 = to.a_hat.cast<float>();
+			const state<float> in = s;
+			predict_mean_rk4(in.quat, in.pos, in.vel, float(from.dt), w_hat, a_hat, w_hat2, a_hat2, s.quat, s.vel, s.pos);
+		}
+	};
+
+	// The state after stepping over stream[begin, end), from the identity
+	template <typename T, typename Step>
+	state<T> integrate(const std::vector<sample>& stream, std::size_t begin, std::size_t end, Step step) {
+		state<T> s;
+		for (std::size_t i = begin; i + 1 < end; i++) {
+			step(s, stream[i], stream[i + 1]);
+		}
+		return s;
+	}
+
+	template <typename T, typename Step>
+	double ns_per_step(const std::vector<sample>& stream, Step step) {
+		double sink = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repetitions; r++) {
+			sink += double(integrate<T>(stream, 0, stream.size(), step).pos.x());
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		// Keep the work from being optimized out
+		if (std::isnan(sink)) {
+			std::printf("NaN\n");
+		}
+		return std::chrono::duration<double, std::nano>(stop - start).count() / double(repetitions * (stream.size() - 1));
+	}
+
+	struct errors {
+		double window_pos = 0;
+		double window_quat = 0;
+		double drift_pos = 0;
+		double drift_quat = 0;
+	};
+
+	template <typename T, typename Step>
+	errors compare(const std::vector<sample>& stream, Step step) {
+		errors e;
+		// Every window of the stream, each from the identity
+		for (std::size_t begin = 0; begin + window_steps < stream.size(); begin += window_steps) {
+			const state<double> expected = integrate<double>(stream, begin, begin + window_steps + 1, double_step{});
+			const state<T> actual = integrate<T>(stream, begin, begin + window_steps + 1, step);
+			e.window_pos = std::max(e.window_pos, (actual.pos.template cast<double>() - expected.pos).norm());
+			e.window_quat = std::max(e.window_quat, (actual.quat.template cast<double>() - expected.quat).norm());
+		}
+		const state<double> expected = integrate<double>(stream, 0, stream.size(), double_step{});
+		const state<T> actual = integrate<T>(stream, 0, stream.size(), step);
+		e.drift_pos = (actual.pos.template cast<double>() - expected.pos).norm();
+		e.drift_quat = (actual.quat.template cast<double>() - expected.quat).norm();
+		return e;
+	}
+
+	template <typename T, typename Step>
+	void report(const char* name, const std::vector<sample>& stream, Step step) {
+		const double ns = ns_per_step<T>(stream, step);
+		const errors e = compare<T>(stream, step);
+		std::printf("%-28s %10.1f %14.3g %14.3g %14.3g %14.3g\n", name, ns, e.window_pos, e.window_quat, e.drift_pos, e.drift_quat);
+	}
+
+}
+
+int main() {
+	const std::vector<sample> stream = make_stream();
+	std::printf("%zu samples at %.0f Hz; windows of %zu steps\n\n", stream.size(), imu_rate, window_steps);
+
+	std::printf("%-28s %10s %14s %14s %14s %14s\n", "", "ns/step", "window dp (m)", "window dq", "drift dp (m)", "drift dq");
+	report<double>("double", stream, double_step{});
+	report<float>("float", stream, float_step{});
+	return 0;
+}
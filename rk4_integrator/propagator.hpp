@@ -0,0 +1,221 @@
+#pragma once
+
+// The RK4 step has been ported almost as-is from the original OpenVINS integrator, which
+// can be found here: https://github.com/rpng/open_vins/blob/master/ov_msckf/src/state/Propagator.cpp
+//
+// The step is templated on the scalar type: double is the reference,
+// and float is the (faster) option for deployments which can take its precision (see rk4_precision).
+// Everything is fixed-size, so a step does no heap allocation.
+
+#include <string>
+#include <eigen3/Eigen/Dense>
+
+#include "common/imu_buffer.hpp"
+#include "common/jpl_quaternion.hpp"
+#include "common/global_module_defs.hpp"
+
+namespace ILLIXR {
+
+	template <typename T>
+	EIGEN_ALWAYS_INLINE void predict_mean_rk4(const Eigen::Matrix<T,4,1> &quat, const Eigen::Matrix<T,3,1> &pos, const Eigen::Matrix<T,3,1> &vel, T dt,
+                                  const Eigen::Matrix<T,3,1> &w_hat1, const Eigen::Matrix<T,3,1> &a_hat1,
+                                  const Eigen::Matrix<T,3,1> &w_hat2, const Eigen::Matrix<T,3,1> &a_hat2,
+                                  Eigen::Matrix<T,4,1> &new_q, Eigen::Matrix<T,3,1> &new_v, Eigen::Matrix<T,3,1> &new_p) {
+		using Vector3 = Eigen::Matrix<T,3,1>;
+		using Vector4 = Eigen::Matrix<T,4,1>;
+		using Matrix3 = Eigen::Matrix<T,3,3>;
+
+		const Vector3 gravity_vec {T(0.0), T(0.0), T(9.81)};
+		const T half = T(0.5);
+		const T sixth = T(1.0/6.0);
+		const T third = T(1.0/3.0);
+
+		// Pre-compute things
+		Vector3 w_hat = w_hat1;
+		Vector3 a_hat = a_hat1;
+		Vector3 w_alpha = (w_hat2-w_hat1)/dt;
+		Vector3 a_jerk = (a_hat2-a_hat1)/dt;
+
+		// y0 ================
+		Vector4 q_0 = quat;
+		Vector3 p_0 = pos;
+		Vector3 v_0 = vel;
+
+		// k1 ================
+		Vector4 dq_0 = {0,0,0,1};
+		Vector4 q0_dot = half*Omega(w_hat)*dq_0;
+		Vector3 p0_dot = v_0;
+		Matrix3 R_Gto0 = quat_2_Rot(quat_multiply(dq_0,q_0));
+		Vector3 v0_dot = R_Gto0.transpose()*a_hat-gravity_vec;
+
+		Vector4 k1_q = q0_dot*dt;
+		Vector3 k1_p = p0_dot*dt;
+		Vector3 k1_v = v0_dot*dt;
+
+		// k2 ================
+		w_hat += half*w_alpha*dt;
+		a_hat += half*a_jerk*dt;
+
+		Vector4 dq_1 = quatnorm(dq_0+half*k1_q);
+		//Vector3 p_1 = p_0+half*k1_p;
+		Vector3 v_1 = v_0+half*k1_v;
+
+		Vector4 q1_dot = half*Omega(w_hat)*dq_1;
+		Vector3 p1_dot = v_1;
+		Matrix3 R_Gto1 = quat_2_Rot(quat_multiply(dq_1,q_0));
+		Vector3 v1_dot = R_Gto1.transpose()*a_hat-gravity_vec;
+
+		Vector4 k2_q = q1_dot*dt;
+		Vector3 k2_p = p1_dot*dt;
+		Vector3 k2_v = v1_dot*dt;
+
+		// k3 ================
+		Vector4 dq_2 = quatnorm(dq_0+half*k2_q);
+		//Vector3 p_2 = p_0+half*k2_p;
+		Vector3 v_2 = v_0+half*k2_v;
+
+		Vector4 q2_dot = half*Omega(w_hat)*dq_2;
+		Vector3 p2_dot = v_2;
+		Matrix3 R_Gto2 = quat_2_Rot(quat_multiply(dq_2,q_0));
+		Vector3 v2_dot = R_Gto2.transpose()*a_hat-gravity_vec;
+
+		Vector4 k3_q = q2_dot*dt;
+		Vector3 k3_p = p2_dot*dt;
+		Vector3 k3_v = v2_dot*dt;
+
+		// k4 ================
+		w_hat += half*w_alpha*dt;
+		a_hat += half*a_jerk*dt;
+
+		Vector4 dq_3 = quatnorm(dq_0+k3_q);
+		//Vector3 p_3 = p_0+k3_p;
+		Vector3 v_3 = v_0+k3_v;
+
+		Vector4 q3_dot = half*Omega(w_hat)*dq_3;
+		Vector3 p3_dot = v_3;
+		Matrix3 R_Gto3 = quat_2_Rot(quat_multiply(dq_3,q_0));
+		Vector3 v3_dot = R_Gto3.transpose()*a_hat-gravity_vec;
+
+		Vector4 k4_q = q3_dot*dt;
+		Vector3 k4_p = p3_dot*dt;
+		Vector3 k4_v = v3_dot*dt;
+
+		// y+dt ================
+		Vector4 dq = quatnorm(dq_0+sixth*k1_q+third*k2_q+third*k3_q+sixth*k4_q);
+		new_q = quat_multiply(dq, q_0);
+		new_p = p_0+sixth*k1_p+third*k2_p+third*k3_p+sixth*k4_p;
+		new_v = v_0+sixth*k1_v+third*k2_v+third*k3_v+sixth*k4_v;
+	}
+
+	// Scalar type of the RK4 step
+	enum class rk4_precision { float32, float64 };
+
+	/// `ILLIXR_RK4_PRECISION`: "double" (default) or "float".
+	inline rk4_precision rk4_precision_from_env() {
+		return ILLIXR::getenv_or("ILLIXR_RK4_PRECISION", "double") == "float" ? rk4_precision::float32 : rk4_precision::float64;
+	}
+
+	// Propagated state; quat is a JPL quaternion (x, y, z, w)
+	struct rk4_state {
+		Eigen::Vector4d quat;
+		Eigen::Vector3d pos;
+		Eigen::Vector3d vel;
+	};
+
+	// The propagated state, and the bias-corrected measurements at both ends of the last step
+	struct rk4_result {
+		rk4_state state;
+		Eigen::Vector3d w_hat {Eigen::Vector3d::Zero()};
+		Eigen::Vector3d a_hat {Eigen::Vector3d::Zero()};
+		Eigen::Vector3d w_hat2 {Eigen::Vector3d::Zero()};
+		Eigen::Vector3d a_hat2 {Eigen::Vector3d::Zero()};
+	};
+
+	/**
+	 * @brief Propagates an integrator input over the IMU window, reusing the work done for earlier samples.
+	 *
+	 * Integrating the whole window since the last camera time on every sample costs O(n) RK4 steps per sample.
+	 * Instead, the state after the window's committed steps (see `imu_window_tracker`) is kept as a checkpoint,
+	 * and each call only steps it over the readings which arrived since, then takes the (at most two) steps
+	 * to the interpolated end of the window on a copy. The result is bit-for-bit identical.
+	 *
+	 * Steps are taken in double, or in float with `rk4_precision::float32`; the state is kept in double either way.
+	 */
+	class rk4_propagator {
+	public:
+		explicit rk4_propagator(rk4_precision precision = rk4_precision::float64)
+			: _m_precision{precision}
+		{ }
+
+		/// Start propagating a new integrator input from @p time_begin.
+		void reset(const rk4_state& state, double time_begin, const Eigen::Vector3d& bias_gyro, const Eigen::Vector3d& bias_acc) {
+			_m_initial = state;
+			_m_bias_gyro = bias_gyro;
+			_m_bias_acc = bias_acc;
+			_m_window.reset(time_begin);
+		}
+
+		/// Propagate over [time_begin, @p time_end] of @p buffer.
+		rk4_result propagate(const imu_buffer& buffer, double time_end) {
+			_m_window.advance(buffer, time_end,
+				[this]() {
+					_m_checkpoint = _m_initial;
+				},
+				[this](const imu_reading& from, const imu_reading& to) {
+					step(_m_checkpoint, from, to, nullptr);
+				}
+			);
+
+			rk4_result result {_m_checkpoint};
+			_m_window.finish([this, &result](const imu_reading& from, const imu_reading& to) {
+				step(result.state, from, to, &result);
+			});
+			return result;
+		}
+
+	private:
+		void step(rk4_state& state, const imu_reading& from, const imu_reading& to, rk4_result* result) const {
+			// Time elapsed over interval
+			const double dt = to.timestamp - from.timestamp;
+
+			// Corrected imu measurements
+			const Eigen::Vector3d w_hat = from.wm - _m_bias_gyro;
+			const Eigen::Vector3d a_hat = from.am - _m_bias_acc;
+			const Eigen::Vector3d w_hat2 = to.wm - _m_bias_gyro;
+			const Eigen::Vector3d a_hat2 = to.am - _m_bias_acc;
+
+			// Compute the new state mean value
+			if (_m_precision == rk4_precision::float32) {
+				Eigen::Vector4f new_quat;
+				Eigen::Vector3f new_vel, new_pos;
+				predict_mean_rk4<float>(state.quat.cast<float>(), state.pos.cast<float>(), state.vel.cast<float>(), float(dt),
+									    w_hat.cast<float>(), a_hat.cast<float>(), w_hat2.cast<float>(), a_hat2.cast<float>(),
+									    new_quat, new_vel, new_pos);
+				state = rk4_state{new_quat.cast<double>(), new_pos.cast<double>(), new_vel.cast<double>()};
+			} else {
+				Eigen::Vector4d new_quat;
+				Eigen::Vector3d new_vel, new_pos;
+				predict_mean_rk4(state.quat, state.pos, state.vel, dt, w_hat, a_hat, w_hat2, a_hat2, new_quat, new_vel, new_pos);
+				state = rk4_state{new_quat, new_pos, new_vel};
+			}
+			if (result) {
+				result->w_hat = w_hat;
+				result->a_hat = a_hat;
+				result->w_hat2 = w_hat2;
+				result->a_hat2 = a_hat2;
+			}
+		}
+
+		const rk4_precision _m_precision;
+
+		// The input being propagated
+		rk4_state _m_initial;
+		Eigen::Vector3d _m_bias_gyro {Eigen::Vector3d::Zero()};
+		Eigen::Vector3d _m_bias_acc {Eigen::Vector3d::Zero()};
+
+		imu_window_tracker _m_window;
+		// State after the window's committed steps
+		rk4_state _m_checkpoint;
+	};
+
+}
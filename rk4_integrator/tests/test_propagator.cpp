@@ -0,0 +1,141 @@
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../propagator.hpp"
+
+namespace ILLIXR {
+
+class PropagatorTest : public ::testing::Test {
+protected:
+	// NaN (from extrapolating between simultaneous readings) must match NaN
+	template <typename Derived>
+	static bool same(const Eigen::MatrixBase<Derived>& a, const Eigen::MatrixBase<Derived>& b) {
+		return (a.array() == b.array() || (a.array().isNaN() && b.array().isNaN())).all();
+	}
+
+	// What rk4_integrator did before: re-integrate the whole window on every sample
+	static rk4_result propagate_window(const rk4_state& initial, const std::vector<imu_reading>& window,
+									   const Eigen::Vector3d& bias_gyro, const Eigen::Vector3d& bias_acc) {
+		rk4_result result {initial};
+		for (std::size_t i = 0; i + 1 < window.size(); i++) {
+			const double dt = window[i + 1].timestamp - window[i].timestamp;
+			result.w_hat = window[i].wm - bias_gyro;
+			result.a_hat = window[i].am - bias_acc;
+			result.w_hat2 = window[i + 1].wm - bias_gyro;
+			result.a_hat2 = window[i + 1].am - bias_acc;
+			Eigen::Vector4d new_quat;
+			Eigen::Vector3d new_vel, new_pos;
+			predict_mean_rk4(result.state.quat, result.state.pos, result.state.vel, dt,
+							 result.w_hat, result.a_hat, result.w_hat2, result.a_hat2, new_quat, new_vel, new_pos);
+			result.state = rk4_state{new_quat, new_pos, new_vel};
+		}
+		return result;
+	}
+
+	static void expect_same(const rk4_result& actual, const rk4_result& expected) {
+		ASSERT_TRUE(same(actual.state.quat, expected.state.quat));
+		ASSERT_TRUE(same(actual.state.pos, expected.state.pos));
+		ASSERT_TRUE(same(actual.state.vel, expected.state.vel));
+		ASSERT_TRUE(same(actual.w_hat, expected.w_hat));
+		ASSERT_TRUE(same(actual.a_hat, expected.a_hat));
+		ASSERT_TRUE(same(actual.w_hat2, expected.w_hat2));
+		ASSERT_TRUE(same(actual.a_hat2, expected.a_hat2));
+	}
+};
+
+TEST_F(PropagatorTest, MatchesFullReintegration) {
+	std::mt19937 rng {7};
+	std::normal_distribution<double> noise {0., 1.};
+	std::uniform_real_distribution<double> step {0.004, 0.006};
+	std::bernoulli_distribution duplicate {0.02};
+	std::bernoulli_distribution new_input {0.05};
+	std::bernoulli_distribution late {0.02};
+
+	imu_buffer buffer {300};
+	imu_buffer reference {300};
+	rk4_propagator propagator;
+
+	rk4_state initial {Eigen::Vector4d{0, 0, 0, 1}, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()};
+	double time_begin = 0;
+	Eigen::Vector3d bias_gyro = Eigen::Vector3d::Zero();
+	Eigen::Vector3d bias_acc = Eigen::Vector3d::Zero();
+	propagator.reset(initial, time_begin, bias_gyro, bias_acc);
+
+	double t = 0;
+	for (int iteration = 0; iteration < 1500; iteration++) {
+		t += duplicate(rng) ? 0. : step(rng);
+		const imu_reading reading {
+			t,
+			Eigen::Vector3d{noise(rng), noise(rng), noise(rng)} * 0.1,
+			Eigen::Vector3d{noise(rng), noise(rng), 9.81 + noise(rng)},
+		};
+		buffer.push(reading);
+		reference.push(reading);
+		buffer.expire_before(t - 0.5);
+		reference.expire_before(t - 0.5);
+
+		if (new_input(rng)) {
+			// A new (slow) pose for a camera time somewhat in the past
+			time_begin = t - 0.2 * std::abs(noise(rng));
+			initial = rk4_state{
+				Eigen::Vector4d{noise(rng), noise(rng), noise(rng), noise(rng)}.normalized(),
+				Eigen::Vector3d{noise(rng), noise(rng), noise(rng)},
+				Eigen::Vector3d{noise(rng), noise(rng), noise(rng)},
+			};
+			bias_gyro = Eigen::Vector3d{noise(rng), noise(rng), noise(rng)} * 0.01;
+			bias_acc = Eigen::Vector3d{noise(rng), noise(rng), noise(rng)} * 0.1;
+			propagator.reset(initial, time_begin, bias_gyro, bias_acc);
+		}
+
+		// Occasionally propagate to an older time, like a sample that arrives out of order
+		const double time_end = late(rng) ? t - 0.02 : t;
+		const rk4_result actual = propagator.propagate(buffer, time_end);
+		const rk4_result expected = propagate_window(initial, reference.select(time_begin, time_end), bias_gyro, bias_acc);
+		SCOPED_TRACE(iteration);
+		expect_same(actual, expected);
+	}
+}
+
+TEST_F(PropagatorTest, AdvancesWithEachSample) {
+	imu_buffer buffer {64};
+	rk4_propagator propagator;
+	propagator.reset(rk4_state{Eigen::Vector4d{0, 0, 0, 1}, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()}, 0.,
+					 Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero());
+
+	// Constant acceleration along x (gravity cancelled), so velocity grows linearly.
+	// The window ends at the newest sample, so the interval up to it is only integrated once the next one arrives.
+	for (int i = 0; i <= 10; i++) {
+		buffer.push(imu_reading{i * 0.1, Eigen::Vector3d::Zero(), Eigen::Vector3d{1., 0., 9.81}});
+		const rk4_result result = propagator.propagate(buffer, i * 0.1);
+		ASSERT_NEAR(result.state.vel.x(), std::max(0, i - 1) * 0.1, 1e-9);
+	}
+}
+
+TEST_F(PropagatorTest, FloatStepsTrackDouble) {
+	std::mt19937 rng {11};
+	std::normal_distribution<double> noise {0., 1.};
+
+	// Two seconds at 200 Hz
+	imu_buffer buffer {512};
+	for (int i = 0; i <= 400; i++) {
+		buffer.push(imu_reading{
+			i * 0.005,
+			Eigen::Vector3d{noise(rng), noise(rng), noise(rng)} * 0.1,
+			Eigen::Vector3d{noise(rng), noise(rng), 9.81 + noise(rng)},
+		});
+	}
+
+	const rk4_state initial {Eigen::Vector4d{0, 0, 0, 1}, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()};
+	rk4_propagator reference {rk4_precision::float64};
+	rk4_propagator fast {rk4_precision::float32};
+	reference.reset(initial, 0., Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero());
+	fast.reset(initial, 0., Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero());
+
+	const rk4_result expected = reference.propagate(buffer, 2.);
+	const rk4_result actual = fast.propagate(buffer, 2.);
+	ASSERT_LT((actual.state.quat - expected.state.quat).norm(), 1e-5);
+	ASSERT_LT((actual.state.vel - expected.state.vel).norm(), 1e-4);
+	ASSERT_LT((actual.state.pos - expected.state.pos).norm(), 1e-4);
+}
+
+}
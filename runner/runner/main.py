@@ -90,9 +90,15 @@ def build_runtime(
     return runtime_path / runtime_name
 
 
+def data_env(config: Mapping[str, Any]) -> Mapping[str, str]:
+    # Configs that generate their own inputs (e.g. synthetic.yaml) have no dataset.
+    if "data" not in config:
+        return {}
+    return dict(ILLIXR_DATA=str(pathify(config["data"], root_dir, cache_path, True, True)))
+
+
 def load_native(config: Mapping[str, Any]) -> None:
     runtime_exe_path = build_runtime(config, "exe")
-    data_path = pathify(config["data"], root_dir, cache_path, True, True)
     demo_data_path = pathify(config["demo_data"], root_dir, cache_path, True, True)
     enable_offload_flag = config["enable_offload"]
     enable_alignment_flag = config["enable_alignment"]
@@ -105,7 +111,7 @@ def load_native(config: Mapping[str, Any]) -> None:
     actual_cmd_str = config["action"].get("command", "$cmd")
     illixr_cmd_list = [str(runtime_exe_path), *map(str, plugin_paths)]
     env_override = dict(
-        ILLIXR_DATA=str(data_path),
+        **data_env(config),
         ILLIXR_DEMO_DATA=str(demo_data_path),
         ILLIXR_OFFLOAD_ENABLE=str(enable_offload_flag),
         ILLIXR_ALIGNMENT_ENABLE=str(enable_alignment_flag),
@@ -152,7 +158,6 @@ def load_native(config: Mapping[str, Any]) -> None:
 
 def load_tests(config: Mapping[str, Any]) -> None:
     runtime_exe_path = build_runtime(config, "exe", test=True)
-    data_path = pathify(config["data"], root_dir, cache_path, True, True)
     demo_data_path = pathify(config["demo_data"], root_dir, cache_path, True, True)
     enable_offload_flag = config["enable_offload"]
     enable_alignment_flag = config["enable_alignment"]
@@ -174,7 +179,7 @@ def load_tests(config: Mapping[str, Any]) -> None:
     subprocess_run(
         cmd_list,
         env_override=dict(
-            ILLIXR_DATA=str(data_path),
+            **data_env(config),
             ILLIXR_DEMO_DATA=str(demo_data_path),
             ILLIXR_RUN_DURATION=str(config["action"].get("ILLIXR_RUN_DURATION", 10)),
             ILLIXR_OFFLOAD_ENABLE=str(enable_offload_flag),
@@ -198,7 +203,6 @@ def load_monado(config: Mapping[str, Any]) -> None:
     runtime_path = pathify(config["runtime"]["path"], root_dir, cache_path, True, True)
     monado_config = config["action"]["monado"].get("config", {})
     monado_path = pathify(config["action"]["monado"]["path"], root_dir, cache_path, True, True)
-    data_path = pathify(config["data"], root_dir, cache_path, True, True)
     demo_data_path = pathify(config["demo_data"], root_dir, cache_path, True, True)
     enable_offload_flag = config["enable_offload"]
     enable_alignment_flag = config["enable_alignment"]
@@ -220,7 +224,7 @@ def load_monado(config: Mapping[str, Any]) -> None:
     plugin_paths_comp_arg: str = ':'.join(map(str, plugin_paths))
 
     env_monado: Mapping[str, str] = dict(
-        ILLIXR_DATA=str(data_path),
+        **data_env(config),
         ILLIXR_PATH=str(runtime_path / f"plugin.{profile}.so"),
         ILLIXR_COMP=plugin_paths_comp_arg,
         XR_RUNTIME_JSON=str(monado_path / "build" / "openxr_monado-dev.json"),
@@ -13,6 +13,7 @@
 #include "common/global_module_defs.hpp"
 #include "common/error_util.hpp"
 #include "common/stoplight.hpp"
+#include "common/frame_pool.hpp"
 
 using namespace ILLIXR;
 
@@ -30,6 +31,7 @@ public:
         pb.register_impl<xlib_gl_extended_window>(std::make_shared<xlib_gl_extended_window>(ILLIXR::FB_WIDTH, ILLIXR::FB_HEIGHT, appGLCtx));
 #endif /// ILLIXR_MONADO_MAINLINE
 		pb.register_impl<Stoplight>(std::make_shared<Stoplight>());
+		pb.register_impl<frame_pool>(std::make_shared<frame_pool>());
 	}
 
 	virtual void load_so(const std::vector<std::string>& so_paths) override {
@@ -0,0 +1,176 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "common/switchboard.hpp"
+#include "common/data_format.hpp"
+#include "common/threadloop.hpp"
+#include "common/global_module_defs.hpp"
+#include "common/sensor_publisher.hpp"
+#include "common/frame_pool.hpp"
+#include "trajectory.hpp"
+#include "scene.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Synthesizes IMU and stereo samples and `true_pose` from a parametric trajectory, with no dataset.
+ *
+ * The IMU is sampled from the analytic trajectory and corrupted with white noise and a random-walk bias
+ * (continuous-time densities, like a Kalibr IMU config). A stereo pair is rendered from a procedural room
+ * every few IMU samples.
+ */
+class synthetic_imu_cam : public ILLIXR::threadloop {
+public:
+	synthetic_imu_cam(std::string name_, phonebook* pb_)
+		: threadloop{name_, pb_}
+		, _m_sb{pb->lookup_impl<switchboard>()}
+		, _m_frame_pool{pb->lookup_impl<frame_pool>()}
+		, _m_publisher{_m_sb, "synthetic"}
+		, _m_true_pose{_m_sb->get_writer<pose_type>("true_pose")}
+		, _m_ground_truth_offset{_m_sb->get_writer<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
+		, _m_imu_rate{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_IMU_RATE", "200"))}
+		, _m_imu_period_ns{static_cast<ullong>(std::llround(NANO_SEC / _m_imu_rate))}
+		, _m_cam_every{static_cast<ullong>(std::max(1L, std::lround(
+			_m_imu_rate / std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_CAM_RATE", "20"))
+		)))}
+		, _m_width{std::stoi(ILLIXR::getenv_or("ILLIXR_SYNTH_WIDTH", "752"))}
+		, _m_height{std::stoi(ILLIXR::getenv_or("ILLIXR_SYNTH_HEIGHT", "480"))}
+		, _m_baseline{std::stof(ILLIXR::getenv_or("ILLIXR_SYNTH_BASELINE", "0.11"))}
+		, _m_realtime{ILLIXR::str_to_bool(ILLIXR::getenv_or("ILLIXR_SYNTH_REALTIME", "True"))}
+		, _m_gyro_noise{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_GYRO_NOISE", "1.6968e-04"))}
+		, _m_acc_noise{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_ACC_NOISE", "2.0e-3"))}
+		, _m_gyro_walk{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_GYRO_WALK", "1.9393e-05"))}
+		, _m_acc_walk{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_ACC_WALK", "3.0e-3"))}
+		, _m_trajectory{std::stod(ILLIXR::getenv_or("ILLIXR_SYNTH_MOTION_SCALE", "1"))}
+		, _m_scene{4.0f, 3.0f, 0.2f}
+		// Roughly an 80 degree horizontal field of view, like the EuRoC cameras
+		, _m_rays{scene::pinhole_rays(_m_width, _m_height, 0.6f * _m_width, 0.6f * _m_width, 0.5f * _m_width, 0.5f * _m_height)}
+		, _m_rng{std::stoull(ILLIXR::getenv_or("ILLIXR_SYNTH_SEED", "0"))}
+	{
+		// The cameras look along the body x-axis: camera z = body x, camera x = body -y, camera y = body -z.
+		_m_body_from_cam <<
+			0,  0, 1,
+			-1, 0, 0,
+			0, -1, 0;
+	}
+
+	virtual void _p_thread_setup() override {
+		auto now = std::chrono::system_clock::now();
+		_m_real_first_time = std::chrono::time_point_cast<std::chrono::seconds>(now);
+	}
+
+protected:
+	virtual skip_option _p_should_skip() override {
+		if (_m_realtime) {
+			std::this_thread::sleep_for(
+				_m_real_first_time + std::chrono::nanoseconds{_m_sample_no * _m_imu_period_ns}
+				- std::chrono::system_clock::now()
+			);
+		}
+		return skip_option::run;
+	}
+
+	virtual void _p_one_iteration() override {
+		const ullong dataset_time = _m_sample_no * _m_imu_period_ns;
+		const time_type real_time = _m_real_first_time + std::chrono::nanoseconds{dataset_time};
+		const double t = dataset_time / NANO_SEC;
+		const trajectory::state state = _m_trajectory.at(t);
+
+		// Discrete-time noise from continuous-time densities
+		const double dt = _m_imu_period_ns / NANO_SEC;
+		Eigen::Vector3d gyro_white;
+		Eigen::Vector3d acc_white;
+		for (int i = 0; i < 3; ++i) {
+			gyro_white[i] = _m_gyro_noise / std::sqrt(dt) * _m_normal(_m_rng);
+			acc_white[i]  = _m_acc_noise  / std::sqrt(dt) * _m_normal(_m_rng);
+			_m_gyro_bias[i] += _m_gyro_walk * std::sqrt(dt) * _m_normal(_m_rng);
+			_m_acc_bias[i]  += _m_acc_walk  * std::sqrt(dt) * _m_normal(_m_rng);
+		}
+		const Eigen::Vector3d angular_v = state.angular_velocity + _m_gyro_bias + gyro_white;
+		const Eigen::Vector3d linear_a  = trajectory::specific_force(state) + _m_acc_bias + acc_white;
+
+		std::optional<cv::Mat> cam0;
+		std::optional<cv::Mat> cam1;
+		if (_m_sample_no % _m_cam_every == 0) {
+			const Eigen::Matrix3f world_from_body = state.orientation.toRotationMatrix().cast<float>();
+			const Eigen::Matrix3f world_from_cam = world_from_body * _m_body_from_cam;
+			const Eigen::Vector3f position = state.position.cast<float>();
+			const Eigen::Vector3f left = world_from_body * Eigen::Vector3f{0, _m_baseline / 2, 0};
+			// Only render the cameras some plugin consumes
+			if (_m_publisher.wants("cam0")) {
+				cam0 = _m_frame_pool->acquire(_m_height, _m_width, CV_8UC1);
+				_m_scene.render(*cam0, _m_rays, world_from_cam, position + left);
+			}
+			if (_m_publisher.wants("cam1")) {
+				cam1 = _m_frame_pool->acquire(_m_height, _m_width, CV_8UC1);
+				_m_scene.render(*cam1, _m_rays, world_from_cam, position - left);
+			}
+		}
+
+		_m_publisher.put(
+			real_time,
+			angular_v.cast<float>(),
+			linear_a.cast<float>(),
+			cam0,
+			cam1,
+			dataset_time
+		);
+
+		switchboard::ptr<pose_type> true_pose = _m_true_pose.allocate<pose_type>(
+			pose_type {
+				real_time,
+				state.position.cast<float>(),
+				state.orientation.cast<float>()
+			}
+		);
+
+		/// Ground truth position offset is the first ground truth position
+		if (_m_sample_no == 0) {
+			_m_ground_truth_offset.put(_m_ground_truth_offset.allocate<switchboard::event_wrapper<Eigen::Vector3f>>(
+				true_pose->position
+			));
+		}
+		_m_true_pose.put(std::move(true_pose));
+
+		++_m_sample_no;
+	}
+
+private:
+	const std::shared_ptr<switchboard> _m_sb;
+	const std::shared_ptr<frame_pool> _m_frame_pool;
+	sensor_publisher _m_publisher;
+	switchboard::writer<pose_type> _m_true_pose;
+	switchboard::writer<switchboard::event_wrapper<Eigen::Vector3f>> _m_ground_truth_offset;
+
+	const double _m_imu_rate;
+	const ullong _m_imu_period_ns;
+	// A stereo pair is rendered every _m_cam_every IMU samples
+	const ullong _m_cam_every;
+	const int _m_width;
+	const int _m_height;
+	const float _m_baseline;
+	// Pace samples to the wall clock; otherwise publish as fast as possible
+	const bool _m_realtime;
+
+	// Noise densities (rad/s/sqrt(Hz), m/s^2/sqrt(Hz)) and bias random walks (rad/s^2/sqrt(Hz), m/s^3/sqrt(Hz))
+	const double _m_gyro_noise;
+	const double _m_acc_noise;
+	const double _m_gyro_walk;
+	const double _m_acc_walk;
+	Eigen::Vector3d _m_gyro_bias {Eigen::Vector3d::Zero()};
+	Eigen::Vector3d _m_acc_bias {Eigen::Vector3d::Zero()};
+
+	const trajectory _m_trajectory;
+	const scene _m_scene;
+	const std::vector<Eigen::Vector3f> _m_rays;
+	Eigen::Matrix3f _m_body_from_cam;
+
+	std::mt19937_64 _m_rng;
+	std::normal_distribution<double> _m_normal;
+
+	ullong _m_sample_no {0};
+	time_type _m_real_first_time;
+};
+
+PLUGIN_MAIN(synthetic_imu_cam)
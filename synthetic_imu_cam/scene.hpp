@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <eigen3/Eigen/Dense>
+
+/**
+ * @brief A procedurally textured box-shaped room, rendered by casting one ray per pixel.
+ *
+ * Every wall, the floor and the ceiling are tiled with square cells of pseudo-random gray levels,
+ * which gives feature trackers plenty of corners without any texture assets.
+ */
+class scene {
+public:
+	scene(float half_extent, float height, float cell_size)
+		: _m_min{-half_extent, -half_extent, 0.0f}
+		, _m_max{half_extent, half_extent, height}
+		, _m_inv_cell{1.0f / cell_size}
+	{ }
+
+	/**
+	 * @brief Render a grayscale pinhole image into `img` (CV_8UC1, already allocated).
+	 *
+	 * @param rays Camera-frame ray directions, one per pixel in row-major order (see pinhole_rays).
+	 * @param world_from_cam Rotation of the camera (z-forward, x-right, y-down) in the world.
+	 * @param origin Camera center in the world; must lie inside the room.
+	 */
+	void render(cv::Mat& img, const std::vector<Eigen::Vector3f>& rays,
+	            const Eigen::Matrix3f& world_from_cam, const Eigen::Vector3f& origin) const {
+		const int width = img.cols;
+		for (int v = 0; v < img.rows; ++v) {
+			unsigned char* row = img.ptr<unsigned char>(v);
+			const Eigen::Vector3f* row_rays = &rays[std::size_t(v) * width];
+			for (int u = 0; u < width; ++u) {
+				row[u] = shade(origin, world_from_cam * row_rays[u]);
+			}
+		}
+	}
+
+	/// Unnormalized camera-frame ray directions for every pixel of a pinhole camera.
+	static std::vector<Eigen::Vector3f> pinhole_rays(int width, int height, float fx, float fy, float cx, float cy) {
+		std::vector<Eigen::Vector3f> rays;
+		rays.reserve(std::size_t(width) * height);
+		for (int v = 0; v < height; ++v) {
+			for (int u = 0; u < width; ++u) {
+				rays.emplace_back((u - cx) / fx, (v - cy) / fy, 1.0f);
+			}
+		}
+		return rays;
+	}
+
+private:
+	unsigned char shade(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir) const {
+		// The ray starts inside the box, so it exits through the nearest plane it is heading towards.
+		float t = std::numeric_limits<float>::infinity();
+		int axis = 0;
+		int side = 0;
+		for (int i = 0; i < 3; ++i) {
+			if (dir[i] > 0) {
+				const float ti = (_m_max[i] - origin[i]) / dir[i];
+				if (ti < t) { t = ti; axis = i; side = 1; }
+			} else if (dir[i] < 0) {
+				const float ti = (_m_min[i] - origin[i]) / dir[i];
+				if (ti < t) { t = ti; axis = i; side = 0; }
+			}
+		}
+
+		const Eigen::Vector3f hit = origin + t * dir;
+		const int a = (axis + 1) % 3;
+		const int b = (axis + 2) % 3;
+		const auto cell_a = static_cast<std::int32_t>(std::floor(hit[a] * _m_inv_cell));
+		const auto cell_b = static_cast<std::int32_t>(std::floor(hit[b] * _m_inv_cell));
+		// Stay clear of 0 and 255 so the intensities never saturate.
+		return static_cast<unsigned char>(32 + hash(cell_a, cell_b, 2 * axis + side) % 192);
+	}
+
+	static std::uint32_t hash(std::int32_t x, std::int32_t y, std::int32_t face) {
+		std::uint32_t h = static_cast<std::uint32_t>(x) * 0x8da6b343u
+		                ^ static_cast<std::uint32_t>(y) * 0xd8163841u
+		                ^ static_cast<std::uint32_t>(face) * 0xcb1ab31fu;
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		h *= 0x846ca68bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+	const Eigen::Vector3f _m_min;
+	const Eigen::Vector3f _m_max;
+	const float _m_inv_cell;
+};
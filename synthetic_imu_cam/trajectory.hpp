@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cmath>
+
+#include <eigen3/Eigen/Dense>
+
+/**
+ * @brief A smooth, analytic 6-DoF trajectory inside a room.
+ *
+ * Position is a Lissajous curve around a hovering point, and orientation is a Z-Y-X (yaw-pitch-roll)
+ * Euler sequence with each angle oscillating sinusoidally. Everything is differentiable in closed form,
+ * so the ideal IMU readings are exact.
+ *
+ * The world frame is z-up with gravity along -z. The body frame is x-forward, y-left, z-up.
+ */
+class trajectory {
+public:
+	struct state {
+		Eigen::Vector3d position;
+		Eigen::Vector3d velocity;
+		Eigen::Vector3d acceleration;
+		// World-from-body rotation
+		Eigen::Quaterniond orientation;
+		// Angular velocity in the body frame
+		Eigen::Vector3d angular_velocity;
+	};
+
+	/**
+	 * @param motion_scale Multiplies every frequency; 2 replays the same path twice as fast.
+	 */
+	trajectory(double motion_scale)
+		: _m_scale{motion_scale}
+	{ }
+
+	state at(double t) const {
+		state s;
+		for (int i = 0; i < 3; ++i) {
+			const double w = 2 * M_PI * _m_pos_freq[i] * _m_scale;
+			const double phase = w * t + _m_pos_phase[i];
+			s.position[i]     = _m_pos_center[i] + _m_pos_amp[i] * std::sin(phase);
+			s.velocity[i]     = _m_pos_amp[i] * w * std::cos(phase);
+			s.acceleration[i] = -_m_pos_amp[i] * w * w * std::sin(phase);
+		}
+
+		// Euler angles (roll, pitch, yaw) and their rates
+		Eigen::Vector3d angle;
+		Eigen::Vector3d rate;
+		for (int i = 0; i < 3; ++i) {
+			const double w = 2 * M_PI * _m_ang_freq[i] * _m_scale;
+			angle[i] = _m_ang_amp[i] * std::sin(w * t);
+			rate[i]  = _m_ang_amp[i] * w * std::cos(w * t);
+		}
+		const double roll = angle[0], pitch = angle[1], yaw = angle[2];
+
+		s.orientation = Eigen::AngleAxisd{yaw,   Eigen::Vector3d::UnitZ()}
+		              * Eigen::AngleAxisd{pitch, Eigen::Vector3d::UnitY()}
+		              * Eigen::AngleAxisd{roll,  Eigen::Vector3d::UnitX()};
+
+		// Body rates of a Z-Y-X Euler sequence
+		s.angular_velocity = {
+			rate[0] - rate[2] * std::sin(pitch),
+			rate[1] * std::cos(roll) + rate[2] * std::cos(pitch) * std::sin(roll),
+			-rate[1] * std::sin(roll) + rate[2] * std::cos(pitch) * std::cos(roll),
+		};
+		return s;
+	}
+
+	/// The specific force an ideal accelerometer on the body reads (body frame).
+	static Eigen::Vector3d specific_force(const state& s) {
+		return s.orientation.conjugate() * (s.acceleration + Eigen::Vector3d{0, 0, gravity});
+	}
+
+	static constexpr double gravity = 9.81;
+
+private:
+	const double _m_scale;
+
+	// Meters, Hz, radians
+	const Eigen::Vector3d _m_pos_center {0.0, 0.0, 1.5};
+	const Eigen::Vector3d _m_pos_amp    {1.0, 1.0, 0.3};
+	const Eigen::Vector3d _m_pos_freq   {0.11, 0.17, 0.23};
+	const Eigen::Vector3d _m_pos_phase  {0.0, M_PI / 2, 0.0};
+	// Roll, pitch, yaw
+	const Eigen::Vector3d _m_ang_amp    {0.15, 0.2, 1.0};
+	const Eigen::Vector3d _m_ang_freq   {0.13, 0.19, 0.07};
+};
@@ -53,6 +53,7 @@ public:
 		, _m_eyebuffer{sb->get_reader<rendered_frame>("eyebuffer")}
 		, _m_hologram{sb->get_writer<hologram_input>("hologram_in")}
 		, _m_vsync_estimate{sb->get_writer<switchboard::event_wrapper<time_type>>("vsync_estimate")}
+		, _m_mtp{sb->get_writer<mtp_sample>("mtp")}
 		, _m_offload_data{sb->get_writer<texture_pose>("texture_pose")}
 		, timewarp_gpu_logger{record_logger_}
 		, mtp_logger{record_logger_}
@@ -93,6 +94,9 @@ private:
 	// Switchboard plug for publishing vsync estimates
 	switchboard::writer<switchboard::event_wrapper<time_type>> _m_vsync_estimate;
 
+	// Switchboard plug for publishing when each frame was displayed (for pose_prediction's horizon)
+	switchboard::writer<mtp_sample> _m_mtp;
+
 	// Switchboard plug for publishing offloaded data
     switchboard::writer<texture_pose> _m_offload_data;
 
@@ -678,6 +682,8 @@ public:
 		//     the buffers have been successfully swapped.
 		// TODO: GLX V SYNCH SWAP BUFFER
 		[[maybe_unused]] time_type time_before_swap = std::chrono::system_clock::now();
+		// What this swap was estimated at (and latest_pose predicted for)
+		const time_type vsync_estimate = GetNextSwapTimeEstimate();
 
         RAC_ERRNO_MSG("timewarp_gl before glXSwapBuffers");
 		glXSwapBuffers(xwin->dpy, xwin->win);
@@ -692,6 +698,14 @@ public:
             GetNextSwapTimeEstimate()
         ));
 
+		if (!disable_warp) {
+			_m_mtp.put(_m_mtp.allocate<mtp_sample>(
+				vsync_estimate,
+				time_last_swap,
+				latest_pose
+			));
+		}
+
 		std::chrono::nanoseconds imu_to_display = time_last_swap - latest_pose.pose.sensor_time;
 		std::chrono::nanoseconds predict_to_display = time_last_swap - latest_pose.predict_computed_time;
 		std::chrono::nanoseconds render_to_display = time_last_swap - most_recent_frame->render_time;
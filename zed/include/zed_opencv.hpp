@@ -22,3 +22,10 @@ cv::Mat slMat2cvMat(Mat& input) {
     // cv::Mat and sl::Mat will share a single memory structure
     return cv::Mat(input.getHeight(), input.getWidth(), cv_type, input.getPtr<sl::uchar1>(MEM::CPU));
 }
+
+/**
+* Non-owning sl::Mat view of a cv::Mat, so the SDK can retrieve straight into OpenCV-owned memory
+**/
+Mat cvMat2slMat(cv::Mat& input, MAT_TYPE type) {
+    return Mat(Resolution(input.cols, input.rows), type, input.ptr<sl::uchar1>(), input.step, MEM::CPU);
+}
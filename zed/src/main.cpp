@@ -10,11 +10,13 @@
 #include "common/threadloop.hpp"
 #include "common/switchboard.hpp"
 #include "common/data_format.hpp"
+#include "common/sensor_publisher.hpp"
+#include "common/frame_pool.hpp"
 #include "common/error_util.hpp"
 
 using namespace ILLIXR;
 
-cv::Mat slMat2cvMat(Mat& input);
+Mat cvMat2slMat(cv::Mat& input, MAT_TYPE type);
 
 const record_header __imu_cam_record {"imu_cam", {
     {"iteration_no", typeid(std::size_t)},
@@ -70,46 +72,34 @@ std::shared_ptr<Camera> start_camera() {
     return zedm;
 }
 
+// Depth is retrieved at the camera resolution, aligned to the left camera
+depth_intrinsics left_camera_intrinsics(Camera& zedm) {
+    CameraParameters left_cam = zedm.getCameraInformation().camera_configuration.calibration_parameters.left_cam;
+    return depth_intrinsics{left_cam.fx, left_cam.fy, left_cam.cx, left_cam.cy};
+}
+
 class zed_camera_thread : public threadloop {
 public:
     zed_camera_thread(std::string name_, phonebook* pb_, std::shared_ptr<Camera> zedm_)
     : threadloop{name_, pb_}
     , sb{pb->lookup_impl<switchboard>()}
     , _m_cam_type{sb->get_writer<cam_type>("cam_type")}
+    , _m_frame_pool{pb->lookup_impl<frame_pool>()}
     , zedm{zedm_}
     , image_size{zedm->getCameraInformation().camera_configuration.resolution}
     {
         runtime_parameters.sensing_mode = SENSING_MODE::STANDARD;
-        // Image setup
-        imageL_zed.alloc(image_size.width, image_size.height, MAT_TYPE::U8_C1, MEM::CPU);
-        imageR_zed.alloc(image_size.width, image_size.height, MAT_TYPE::U8_C1, MEM::CPU);
-        rgb_zed.alloc(image_size.width, image_size.height, MAT_TYPE::U8_C4, MEM::CPU);
-        depth_zed.alloc(image_size.width, image_size.height, MAT_TYPE::F32_C1, MEM::CPU);
-
-        imageL_ocv = slMat2cvMat(imageL_zed);
-        imageR_ocv = slMat2cvMat(imageR_zed);
-        rgb_ocv = slMat2cvMat(rgb_zed);
-        depth_ocv = slMat2cvMat(depth_zed);
     }
 
 private:
     const std::shared_ptr<switchboard> sb;
 	switchboard::writer<cam_type> _m_cam_type;
+    const std::shared_ptr<frame_pool> _m_frame_pool;
     std::shared_ptr<Camera> zedm;
     Resolution image_size;
     RuntimeParameters runtime_parameters;
     std::size_t serial_no {0};
 
-    Mat imageL_zed;
-    Mat imageR_zed;
-    Mat depth_zed;
-    Mat rgb_zed;
-
-    cv::Mat imageL_ocv;
-    cv::Mat imageR_ocv;
-    cv::Mat depth_ocv;
-    cv::Mat rgb_ocv;
-
 protected:
     virtual skip_option _p_should_skip() override {
         if (zedm->grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
@@ -122,18 +112,28 @@ protected:
     virtual void _p_one_iteration() override {
         RAC_ERRNO_MSG("zed at start of _p_one_iteration");
 
-        // Retrieve images
+        // Retrieve each image straight into a fresh pooled buffer. Reusing one set of buffers across grabs
+        // would race with consumers still reading the previous frame.
+        cv::Mat imageL_ocv = _m_frame_pool->acquire(image_size.height, image_size.width, CV_8UC1);
+        cv::Mat imageR_ocv = _m_frame_pool->acquire(image_size.height, image_size.width, CV_8UC1);
+        cv::Mat depth_ocv = _m_frame_pool->acquire(image_size.height, image_size.width, CV_32FC1);
+        cv::Mat rgb_ocv = _m_frame_pool->acquire(image_size.height, image_size.width, CV_8UC4);
+
+        Mat imageL_zed = cvMat2slMat(imageL_ocv, MAT_TYPE::U8_C1);
+        Mat imageR_zed = cvMat2slMat(imageR_ocv, MAT_TYPE::U8_C1);
+        Mat depth_zed = cvMat2slMat(depth_ocv, MAT_TYPE::F32_C1);
+        Mat rgb_zed = cvMat2slMat(rgb_ocv, MAT_TYPE::U8_C4);
+
         zedm->retrieveImage(imageL_zed, VIEW::LEFT_GRAY, MEM::CPU, image_size);
         zedm->retrieveImage(imageR_zed, VIEW::RIGHT_GRAY, MEM::CPU, image_size);
         zedm->retrieveMeasure(depth_zed, MEASURE::DEPTH, MEM::CPU, image_size);
         zedm->retrieveImage(rgb_zed, VIEW::LEFT, MEM::CPU, image_size);
 
         _m_cam_type.put(_m_cam_type.allocate(
-            // Make a copy, so that we don't have race
-            cv::Mat{imageL_ocv},
-            cv::Mat{imageR_ocv},
-			cv::Mat{rgb_ocv},
-            cv::Mat{depth_ocv},
+            imageL_ocv,
+            imageR_ocv,
+			rgb_ocv,
+            depth_ocv,
             iteration_no
         ));
 
@@ -152,11 +152,12 @@ public:
     zed_imu_thread(std::string name_, phonebook* pb_)
         : threadloop{name_, pb_}
         , sb{pb->lookup_impl<switchboard>()}
-        , _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
+        , _m_publisher{sb, "zed"}
         , _m_cam_type{sb->get_reader<cam_type>("cam_type")}
         , _m_rgb_depth{sb->get_writer<rgb_depth_type>("rgb_depth")}
         , zedm{start_camera()}
         , camera_thread_{"zed_camera_thread", pb_, zedm}
+        , _m_depth_intrinsics{left_camera_intrinsics(*zedm)}
         , it_log{record_logger_}
     {
         camera_thread_.start();
@@ -213,20 +214,23 @@ protected:
             {bool(img0)},
         }});
 
-        _m_imu_cam.put(_m_imu_cam.allocate(
-            imu_time_point,
-            av,
-            la,
-            img0,
-            img1,
-            imu_time
-		));
+        // RGB-D images go in the same frame set, as the "rgb" and "depth" cameras
+        std::vector<camera_image> rgbd;
+        if (rgb) {
+            rgbd.push_back(_m_publisher.image("rgb", image_plane::color, imu_time_point, imu_time, *rgb));
+        }
+        if (depth) {
+            rgbd.push_back(_m_publisher.depth_image("depth", imu_time_point, imu_time, *depth, depth_scale));
+        }
+        _m_publisher.put(imu_time_point, av, la, img0, img1, imu_time, std::move(rgbd));
 
         if (rgb && depth) {
             _m_rgb_depth.put(_m_rgb_depth.allocate(
                     rgb,
                     depth,
-                    imu_time
+                    imu_time,
+                    depth_scale,
+                    _m_depth_intrinsics
 			));
         }
 
@@ -238,9 +242,12 @@ protected:
 private:
     std::shared_ptr<Camera> zedm;
     zed_camera_thread camera_thread_;
+    // Depth is float millimeters (init_params.coordinate_units)
+    static constexpr float depth_scale = 0.001f;
+    const depth_intrinsics _m_depth_intrinsics;
 
     const std::shared_ptr<switchboard> sb;
-	switchboard::writer<imu_cam_type> _m_imu_cam;
+	sensor_publisher _m_publisher;
 	switchboard::reader<cam_type> _m_cam_type;
 	switchboard::writer<rgb_depth_type> _m_rgb_depth;
 